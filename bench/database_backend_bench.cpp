@@ -0,0 +1,150 @@
+// PostgREST (RestDataBaseSession) vs. direct PostgreSQL (PgDataBaseSession) on the queries the
+// server issues per request: a session lookup (read), an OAuth state insert (write) and an
+// analyze cache hit (selectDocumentsByIds of a stored 40-section document, sections decompressed
+// with SECTION_ZSTD_DICTIONARY if set).
+// Backends come from the usual config: SUPABASE_HOST/SUPABASE_KEY for REST, DATABASE_URL and
+// PG_POOL_SIZE for PostgreSQL; a backend whose settings are missing is skipped. For a local run
+// point both at the same PostgreSQL, with PostgREST behind a TLS proxy on :443 for the REST side.
+//
+//   database_backend_bench [requests = 500] [concurrency = 8]
+
+#include "Session/DataBaseSession.hpp"
+#include "Session/PgDataBaseSession.hpp"
+#include "Util/ConfigParser.hpp"
+
+#include <boost/asio.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <print>
+#include <string>
+#include <vector>
+
+namespace asio = boost::asio;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template <typename Call>
+asio::awaitable<void> worker(std::atomic<std::size_t>& next, std::size_t requests,
+                             std::vector<std::chrono::microseconds>& latencies, Call call) {
+    for (auto i = next++; i < requests; i = next++) {
+        const auto started = Clock::now();
+        co_await call(i);
+        latencies[i] = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - started);
+    }
+}
+
+template <typename Call>
+asio::awaitable<void> measure(std::string_view label, std::size_t requests, std::size_t concurrency, Call call) {
+    auto executor = co_await asio::this_coro::executor;
+    std::vector<std::chrono::microseconds> latencies(requests);
+    std::atomic<std::size_t> next = 0;
+
+    // Workers run detached; the last one to finish wakes us by cancelling the timer.
+    asio::steady_timer done { executor, Clock::time_point::max() };
+    std::size_t running = concurrency;
+
+    const auto started = Clock::now();
+    for (std::size_t i = 0; i < concurrency; ++i) {
+        asio::co_spawn(executor, worker(next, requests, latencies, call), [&](std::exception_ptr error) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            if (--running == 0) {
+                done.cancel();
+            }
+        });
+    }
+    boost::system::error_code ec;
+    co_await done.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+    const auto elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+
+    std::ranges::sort(latencies);
+    auto percentile = [&](double q) { return latencies[static_cast<std::size_t>(q * (requests - 1))].count(); };
+    std::println("{:<28} {:8.0f} req/s  p50 {:6} us  p99 {:6} us", label, static_cast<double>(requests) / elapsed,
+                 percentile(0.5), percentile(0.99));
+}
+
+asio::awaitable<void> bench(std::string name, std::shared_ptr<Network::DataBaseSession> database,
+                            std::size_t requests, std::size_t concurrency) {
+    const auto run = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    co_await measure(std::format("{} selectActiveAppSession", name), requests, concurrency,
+                     [&](std::size_t i) -> asio::awaitable<void> {
+                         co_await database->selectActiveAppSession(std::format("bench-{}-{}", run, i),
+                                                                   "2000-01-01T00:00:00Z");
+                     });
+    co_await measure(std::format("{} insertOAuthState", name), requests, concurrency,
+                     [&](std::size_t i) -> asio::awaitable<void> {
+                         co_await database->insertOAuthState(std::format("bench-{}-{}-{}", name, run, i),
+                                                             "2000-01-01T00:00:00Z");
+                     });
+
+    std::vector<Documents::Paragraph> sections;
+    for (int i = 0; i < 40; ++i) {
+        std::string text;
+        for (int j = 0; j < 30; ++j) {
+            text += std::format("В разделе {} рассматривается задача {} обнаружения заимствований в тексте. ", i, j);
+        }
+        sections.push_back({ .title = std::format("Раздел {}", i), .text = std::move(text) });
+    }
+    const std::vector<std::string> ids { std::format("bench-document-{}-{}", name, run) };
+    if (!co_await database->insertDocument(Document(std::move(sections), ids.front()))) {
+        std::println(std::cerr, "{}: could not store the benchmark document", name);
+        co_return;
+    }
+    co_await measure(std::format("{} selectDocumentsByIds", name), requests, concurrency,
+                     [&](std::size_t) -> asio::awaitable<void> {
+                         co_await database->selectDocumentsByIds(ids);
+                     });
+    co_await database->deleteDocument(ids.front());
+}
+
+}   // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t requests = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500;
+    const std::size_t concurrency = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 8;
+
+    Util::ConfigParser config;
+    std::vector<std::pair<std::string, std::shared_ptr<Network::DataBaseSession>>> backends;
+    if (!config["SUPABASE_HOST"].empty()) {
+        backends.emplace_back("rest", std::make_shared<Network::RestDataBaseSession>());
+    }
+    if (auto url = config["DATABASE_URL"]; !url.empty()) {
+        backends.emplace_back("postgres", std::make_shared<Network::PgDataBaseSession>(std::string(url)));
+    }
+    if (backends.empty()) {
+        std::println(std::cerr, "Neither SUPABASE_HOST nor DATABASE_URL is set");
+        return 1;
+    }
+
+    std::println("{} requests, {} in flight", requests, concurrency);
+
+    asio::io_context ioc;
+    asio::co_spawn(ioc, [&]() -> asio::awaitable<void> {
+        for (auto& [name, database] : backends) {
+            co_await bench(name, database, requests, concurrency);
+        }
+    }, [&](std::exception_ptr error) {
+        if (error) {
+            try {
+                std::rethrow_exception(error);
+            } catch (const std::exception& e) {
+                std::println(std::cerr, "Benchmark failed: {}", e.what());
+            }
+        }
+        ioc.stop();
+    });
+    ioc.run();
+
+    return 0;
+}
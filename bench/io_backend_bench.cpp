@@ -0,0 +1,177 @@
+// Compares asio's reactor backends on loopback. The same source is built twice, once with the
+// default epoll reactor and once with BOOST_ASIO_HAS_IO_URING + BOOST_ASIO_DISABLE_EPOLL.
+//
+//   io_backend_bench_epoll [connections = 20000] [requests = 50000] [download MiB = 512]
+//   io_backend_bench_uring ...
+
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <print>
+#include <string>
+#include <vector>
+
+namespace asio = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+
+using tcp = asio::ip::tcp;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+#if defined(BOOST_ASIO_HAS_IO_URING) && defined(BOOST_ASIO_DISABLE_EPOLL)
+constexpr std::string_view BACKEND = "io_uring";
+#else
+constexpr std::string_view BACKEND = "epoll";
+#endif
+
+double seconds(Clock::duration d) { return std::chrono::duration<double>(d).count(); }
+
+double micros(Clock::duration d) { return std::chrono::duration<double, std::micro>(d).count(); }
+
+asio::awaitable<void> acceptAndClose(tcp::acceptor& acceptor) {
+    while (true) {
+        auto socket = co_await acceptor.async_accept(asio::use_awaitable);
+        boost::system::error_code ec;
+        socket.close(ec);
+    }
+}
+
+asio::awaitable<void> serveSmall(tcp::socket socket) {
+    beast::flat_buffer buffer;
+    http::response<http::string_body> res { http::status::ok, 11 };
+    res.body() = R"({"ok":true})";
+    res.prepare_payload();
+
+    try {
+        while (true) {
+            http::request<http::empty_body> req;
+            co_await http::async_read(socket, buffer, req, asio::use_awaitable);
+            co_await http::async_write(socket, res, asio::use_awaitable);
+        }
+    } catch (const std::exception&) {
+    }
+}
+
+asio::awaitable<void> serveLarge(tcp::socket socket, std::size_t bytes) {
+    std::vector<unsigned char> block(256 * 1024, 0x5a);
+    for (std::size_t sent = 0; sent < bytes;) {
+        auto n = std::min(block.size(), bytes - sent);
+        co_await asio::async_write(socket, asio::buffer(block.data(), n), asio::use_awaitable);
+        sent += n;
+    }
+    socket.shutdown(tcp::socket::shutdown_send);
+}
+
+template <typename Handler>
+asio::awaitable<void> listen(tcp::acceptor& acceptor, Handler handler) {
+    while (true) {
+        auto socket = co_await acceptor.async_accept(asio::use_awaitable);
+        asio::co_spawn(acceptor.get_executor(), handler(std::move(socket)), asio::detached);
+    }
+}
+
+asio::awaitable<void> acceptRate(tcp::endpoint endpoint, std::size_t connections) {
+    auto executor = co_await asio::this_coro::executor;
+
+    const auto started = Clock::now();
+    for (std::size_t i = 0; i < connections; ++i) {
+        tcp::socket socket { executor };
+        co_await socket.async_connect(endpoint, asio::use_awaitable);
+    }
+    const auto elapsed = seconds(Clock::now() - started);
+
+    std::println("accept      {:>10.0f} conn/s", static_cast<double>(connections) / elapsed);
+}
+
+asio::awaitable<void> smallRequests(tcp::endpoint endpoint, std::size_t requests) {
+    tcp::socket socket { co_await asio::this_coro::executor };
+    co_await socket.async_connect(endpoint, asio::use_awaitable);
+
+    http::request<http::empty_body> req { http::verb::get, "/v1/courses", 11 };
+    req.set(http::field::host, "localhost");
+    beast::flat_buffer buffer;
+
+    std::vector<double> latencies;
+    latencies.reserve(requests);
+    for (std::size_t i = 0; i < requests; ++i) {
+        const auto started = Clock::now();
+        co_await http::async_write(socket, req, asio::use_awaitable);
+        http::response<http::string_body> res;
+        co_await http::async_read(socket, buffer, res, asio::use_awaitable);
+        latencies.push_back(micros(Clock::now() - started));
+    }
+
+    std::ranges::sort(latencies);
+    auto at = [&](double q) { return latencies[static_cast<std::size_t>(q * static_cast<double>(latencies.size() - 1))]; };
+    std::println("small req   p50 {:>7.1f} us   p99 {:>7.1f} us   p99.9 {:>7.1f} us", at(0.5), at(0.99), at(0.999));
+}
+
+asio::awaitable<void> largeDownload(tcp::endpoint endpoint, std::size_t bytes) {
+    tcp::socket socket { co_await asio::this_coro::executor };
+    co_await socket.async_connect(endpoint, asio::use_awaitable);
+
+    std::vector<unsigned char> block(256 * 1024);
+    std::size_t received = 0;
+    const auto started = Clock::now();
+
+    boost::system::error_code ec;
+    while (!ec) {
+        received += co_await socket.async_read_some(asio::buffer(block), asio::redirect_error(asio::use_awaitable, ec));
+    }
+    const auto elapsed = seconds(Clock::now() - started);
+
+    if (received != bytes) {
+        std::println(std::cerr, "download: got {} of {} bytes", received, bytes);
+    }
+    std::println("download    {:>10.1f} MiB/s", static_cast<double>(received) / (1024.0 * 1024.0) / elapsed);
+}
+
+}   // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t connections = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    const std::size_t requests = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 50000;
+    const std::size_t downloadBytes = (argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 512) * 1024 * 1024;
+
+    asio::io_context ioc;
+    const auto loopback = asio::ip::make_address("127.0.0.1");
+
+    tcp::acceptor acceptOnly { ioc, { loopback, 0 } };
+    tcp::acceptor small { ioc, { loopback, 0 } };
+    tcp::acceptor large { ioc, { loopback, 0 } };
+
+    asio::co_spawn(ioc, acceptAndClose(acceptOnly), asio::detached);
+    asio::co_spawn(ioc, listen(small, [](tcp::socket socket) { return serveSmall(std::move(socket)); }), asio::detached);
+    asio::co_spawn(ioc, listen(large, [downloadBytes](tcp::socket socket) {
+        return serveLarge(std::move(socket), downloadBytes);
+    }), asio::detached);
+
+    std::println("backend: {}", BACKEND);
+
+    auto run = [&]() -> asio::awaitable<void> {
+        co_await acceptRate(acceptOnly.local_endpoint(), connections);
+        co_await smallRequests(small.local_endpoint(), requests);
+        co_await largeDownload(large.local_endpoint(), downloadBytes);
+    };
+
+    asio::co_spawn(ioc, run(), [&](std::exception_ptr error) {
+        if (error) {
+            try {
+                std::rethrow_exception(error);
+            } catch (const std::exception& e) {
+                std::println(std::cerr, "Benchmark failed: {}", e.what());
+            }
+        }
+        ioc.stop();
+    });
+    ioc.run();
+
+    return 0;
+}
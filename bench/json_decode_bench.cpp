@@ -0,0 +1,114 @@
+// Decoding PostgREST responses: the old DOM path (boost::json::parse, copying .as_array(),
+// then copying every string into the model) vs. parse_into straight into the row structs of
+// Session/PostgrestRows.hpp. Payloads are shaped like real responses: one auth_users row, and
+// a selectDocumentsByIds answer of `documents` theses with 40 sections of ~4 KB Cyrillic text.
+//
+//   json_decode_bench [iterations = 200] [documents = 10]
+
+#include "Session/PostgrestRows.hpp"
+
+#include <boost/json.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <print>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::string documentsPayload(std::size_t documents) {
+    boost::json::array array;
+    for (std::size_t d = 0; d < documents; ++d) {
+        boost::json::array sections;
+        for (int s = 0; s < 40; ++s) {
+            std::string text;
+            while (text.size() < 4096) {
+                text += std::format("В главе {} рассматривается \"метод {}\" обнаружения заимствований.\n", s, text.size());
+            }
+            sections.push_back({ { "title", std::format("Глава {}", s) }, { "content", text }, { "content_zstd", nullptr } });
+        }
+        array.push_back({ { "external_id", std::format("drive-file-{}", d) }, { "document_sections", std::move(sections) } });
+    }
+    return boost::json::serialize(array);
+}
+
+constexpr std::string_view AUTH_USER_PAYLOAD =
+    R"([{"id":"2f0c6f4e-8c39-4b7e-9f7d-1f2a3b4c5d6e","google_sub":"109876543210987654321",)"
+    R"("email":"student@example.edu","name":"Иван Петров","picture_url":"https://lh3.googleusercontent.com/a/x=s96-c"}])";
+
+std::vector<Document> viaDom(std::string_view body) {
+    std::vector<Document> documents;
+    auto json = boost::json::parse(body);
+    for (auto const& value : json.as_array()) {
+        auto const& object = value.as_object();
+        std::vector<Documents::Paragraph> text;
+        for (auto const& section : object.at("document_sections").as_array()) {
+            auto const& fields = section.as_object();
+            text.push_back({ std::string(fields.at("title").as_string()), std::string(fields.at("content").as_string()) });
+        }
+        documents.emplace_back(std::move(text), std::string(object.at("external_id").as_string()));
+    }
+    return documents;
+}
+
+std::vector<Document> viaParseInto(std::string_view body) {
+    std::vector<Document> documents;
+    for (auto& row : *Network::postgrest::decodeRows<Network::postgrest::DocumentRow>(body)) {
+        documents.push_back(Network::postgrest::toModel(std::move(row)));
+    }
+    return documents;
+}
+
+Network::AuthUser userViaDom(std::string_view body) {
+    auto users = boost::json::parse(body).as_array();
+    auto const& json = users.front().as_object();
+    return Network::AuthUser {
+        .id = std::string(json.at("id").as_string()),
+        .googleSub = std::string(json.at("google_sub").as_string()),
+        .email = std::string(json.at("email").as_string()),
+        .name = std::string(json.at("name").as_string()),
+        .pictureUrl = std::string(json.at("picture_url").as_string()),
+    };
+}
+
+Network::AuthUser userViaParseInto(std::string_view body) {
+    auto rows = Network::postgrest::decodeRows<Network::postgrest::AuthUserRow>(body);
+    return Network::postgrest::toModel(std::move(rows->front()));
+}
+
+template <typename Decode>
+void run(std::string_view label, std::string_view body, std::size_t iterations, Decode decode) {
+    std::size_t check = 0;
+    const auto started = Clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        auto decoded = decode(body);
+        if constexpr (requires { decoded.size(); }) {
+            check += decoded.size();
+        } else {
+            check += decoded.id.size();
+        }
+    }
+    const auto elapsed = std::chrono::duration<double, std::micro>(Clock::now() - started).count();
+    std::println("{:<34} {:10.1f} us/response  {:8.1f} MB/s  ({})", label, elapsed / iterations,
+                 static_cast<double>(body.size()) * iterations / elapsed, check);
+}
+
+}   // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+    const std::size_t documents = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10;
+
+    const auto payload = documentsPayload(documents);
+    std::println("documents payload: {} documents, {} bytes", documents, payload.size());
+
+    run("documents: parse + DOM copies", payload, iterations, viaDom);
+    run("documents: parse_into rows", payload, iterations, viaParseInto);
+    run("auth user: parse + DOM copies", AUTH_USER_PAYLOAD, iterations * 1000, userViaDom);
+    run("auth user: parse_into rows", AUTH_USER_PAYLOAD, iterations * 1000, userViaParseInto);
+    return 0;
+}
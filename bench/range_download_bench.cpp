@@ -0,0 +1,154 @@
+// Single-stream vs. parallel byte-range download against a local stand-in for Drive that
+// throttles every connection to a fixed bandwidth, the way a distant upstream does per TCP flow.
+//
+//   range_download_bench [size MiB = 32] [per-connection KiB/s = 4096]
+
+#include "Session/RangeDownload.hpp"
+#include "Session/SimpleSession.hpp"
+
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <print>
+#include <string>
+#include <vector>
+
+namespace asio = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+
+using tcp = asio::ip::tcp;
+
+namespace {
+
+struct StandIn {
+    std::vector<unsigned char> blob;
+    std::size_t bytesPerSecond;
+};
+
+asio::awaitable<void> writeThrottled(tcp::socket& socket, const unsigned char* data, std::size_t size,
+                                     std::size_t bytesPerSecond) {
+    constexpr std::size_t slice = 16 * 1024;
+    asio::steady_timer timer { socket.get_executor() };
+    const auto started = std::chrono::steady_clock::now();
+
+    for (std::size_t sent = 0; sent < size;) {
+        auto n = std::min(slice, size - sent);
+        co_await asio::async_write(socket, asio::buffer(data + sent, n), asio::use_awaitable);
+        sent += n;
+
+        timer.expires_at(started + std::chrono::microseconds(sent * 1'000'000 / bytesPerSecond));
+        co_await timer.async_wait(asio::use_awaitable);
+    }
+}
+
+asio::awaitable<void> serve(tcp::socket socket, const StandIn& standIn) {
+    beast::flat_buffer buffer;
+    try {
+        while (true) {
+            http::request<http::empty_body> req;
+            co_await http::async_read(socket, buffer, req, asio::use_awaitable);
+
+            std::uint64_t first = 0;
+            std::uint64_t last = standIn.blob.size() - 1;
+            bool ranged = false;
+            if (auto range = req[http::field::range]; range.starts_with("bytes=")) {
+                auto spec = std::string(range.substr(6));
+                auto dash = spec.find('-');
+                first = std::stoull(spec.substr(0, dash));
+                last = std::min<std::uint64_t>(std::stoull(spec.substr(dash + 1)), last);
+                ranged = true;
+            }
+
+            std::string head = ranged ? "HTTP/1.1 206 Partial Content\r\n" : "HTTP/1.1 200 OK\r\n";
+            if (ranged) {
+                head += std::format("Content-Range: bytes {}-{}/{}\r\n", first, last, standIn.blob.size());
+            }
+            head += std::format("Content-Length: {}\r\n\r\n", last - first + 1);
+
+            co_await asio::async_write(socket, asio::buffer(head), asio::use_awaitable);
+            co_await writeThrottled(socket, standIn.blob.data() + first, last - first + 1, standIn.bytesPerSecond);
+        }
+    } catch (const std::exception&) {
+    }
+}
+
+asio::awaitable<void> listen(tcp::acceptor& acceptor, const StandIn& standIn) {
+    while (true) {
+        auto socket = co_await acceptor.async_accept(asio::use_awaitable);
+        asio::co_spawn(acceptor.get_executor(), serve(std::move(socket), standIn), asio::detached);
+    }
+}
+
+template <typename Download>
+asio::awaitable<void> measure(std::string_view label, std::size_t expected, Download download) {
+    const auto started = std::chrono::steady_clock::now();
+    auto res = co_await download();
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    if (res.body().size() != expected) {
+        std::println(std::cerr, "{}: got {} bytes, expected {}", label, res.body().size(), expected);
+    }
+    std::println("{:<22} {:8.3f} s  {:8.1f} MiB/s", label, elapsed,
+                 static_cast<double>(expected) / (1024.0 * 1024.0) / elapsed);
+}
+
+asio::awaitable<void> run(std::string host, std::size_t size) {
+    auto executor = co_await asio::this_coro::executor;
+
+    http::request<http::string_body> req { http::verb::get, "/drive/v3/files/bench?alt=media", 11 };
+    req.set(http::field::host, host);
+
+    auto session = std::make_shared<Network::SimpleSession>(executor);
+    co_await measure("single stream", size, [&] { return session->downloadWithRedirect(req); });
+
+    for (std::size_t parallelism : { 2, 4, 8 }) {
+        Network::RangeDownloadOptions options;
+        options.chunkSize = 2 * 1024 * 1024;
+        options.parallelism = parallelism;
+
+        co_await measure(std::format("ranged x{}", parallelism), size, [&] {
+            return Network::downloadRanged<Network::SimpleSession>(req, "80", options);
+        });
+    }
+}
+
+}   // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t sizeMiB = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 32;
+    const std::size_t kibPerSecond = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 4096;
+
+    StandIn standIn;
+    standIn.blob.resize(sizeMiB * 1024 * 1024);
+    for (std::size_t i = 0; i < standIn.blob.size(); ++i) {
+        standIn.blob[i] = static_cast<unsigned char>(i * 31);
+    }
+    standIn.bytesPerSecond = kibPerSecond * 1024;
+
+    asio::io_context ioc;
+    tcp::acceptor acceptor { ioc, { asio::ip::make_address("127.0.0.1"), 0 } };
+    const auto host = std::format("127.0.0.1:{}", acceptor.local_endpoint().port());
+
+    std::println("{} MiB, {} KiB/s per connection", sizeMiB, kibPerSecond);
+
+    asio::co_spawn(ioc, listen(acceptor, standIn), asio::detached);
+    asio::co_spawn(ioc, run(host, standIn.blob.size()), [&](std::exception_ptr error) {
+        if (error) {
+            try {
+                std::rethrow_exception(error);
+            } catch (const std::exception& e) {
+                std::println(std::cerr, "Benchmark failed: {}", e.what());
+            }
+        }
+        ioc.stop();
+    });
+    ioc.run();
+
+    return 0;
+}
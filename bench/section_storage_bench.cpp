@@ -0,0 +1,149 @@
+// What zstd section storage saves and costs, on real documents: bytes stored per section as
+// plain text vs. a zstd frame (with and without a dictionary), bytes PostgREST sends for them
+// (JSON-escaped text vs. base64 of the frame), and decompression time per document on a cache
+// hit. Pass DOCX/PDF files; their sections are what the server would store.
+//
+//   section_storage_bench [--train dictionary.out] file...
+//
+// With --train, a dictionary is first trained on the sections of all files and written out;
+// point SECTION_ZSTD_DICTIONARY at it to have the server use it. Measure with a dictionary
+// trained on other files than the ones measured, or the numbers flatter it.
+
+#include "DocumentReader/DocReader.hpp"
+#include "Util/Compression.hpp"
+#include "Util/Encrypt.hpp"
+
+#include <boost/json.hpp>
+#include <zdict.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Totals {
+    std::size_t sections = 0;
+    std::size_t compressedSections = 0;
+    std::size_t storedBytes = 0;
+    std::size_t transferBytes = 0;
+    std::chrono::nanoseconds decompress {};
+};
+
+std::vector<std::string> readSections(const std::filesystem::path& path) {
+    std::ifstream file { path, std::ios::binary };
+    std::vector<unsigned char> raw { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    auto type = path.extension().string();
+    if (!type.empty()) {
+        type.erase(0, 1);
+    }
+
+    std::vector<std::string> sections;
+    if (auto paragraphs = DocReader::DocumentReaderFromRaw(raw, type)) {
+        for (auto& paragraph : *paragraphs) {
+            sections.push_back(std::move(paragraph.text));
+        }
+    } else {
+        std::println(std::cerr, "Skipping {}: not a readable document", path.string());
+    }
+    return sections;
+}
+
+Totals measure(const std::vector<std::vector<std::string>>& documents, const util::ZstdCodec* codec) {
+    Totals totals;
+    for (const auto& sections : documents) {
+        std::vector<std::string> frames;
+        for (const auto& section : sections) {
+            ++totals.sections;
+            auto frame = codec != nullptr ? codec->compress(section) : std::nullopt;
+            if (frame) {
+                ++totals.compressedSections;
+                totals.storedBytes += frame->size();
+                totals.transferBytes += util::base64Encode(*frame).size() + 2;
+                frames.push_back(std::move(*frame));
+            } else {
+                totals.storedBytes += section.size();
+                totals.transferBytes += boost::json::serialize(boost::json::string(section)).size();
+            }
+        }
+
+        const auto started = Clock::now();
+        for (const auto& frame : frames) {
+            if (!codec->decompress(frame, 64 * 1024 * 1024)) {
+                throw std::runtime_error("frame did not round-trip");
+            }
+        }
+        totals.decompress += Clock::now() - started;
+    }
+    return totals;
+}
+
+void report(std::string_view label, const Totals& totals, const Totals& plain, std::size_t documents) {
+    std::println("{:<18} stored {:>10} B ({:5.1f}%)  sent {:>10} B ({:5.1f}%)  compressed {:>6}/{:<6} "
+                 "decompress {:8.1f} us/doc",
+                 label, totals.storedBytes, 100.0 * totals.storedBytes / plain.storedBytes, totals.transferBytes,
+                 100.0 * totals.transferBytes / plain.transferBytes, totals.compressedSections, totals.sections,
+                 std::chrono::duration<double, std::micro>(totals.decompress).count() / documents);
+}
+
+}   // namespace
+
+int main(int argc, char** argv) {
+    std::string trainPath;
+    std::vector<std::vector<std::string>> documents;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--train" && i + 1 < argc) {
+            trainPath = argv[++i];
+        } else {
+            documents.push_back(readSections(arg));
+        }
+    }
+    if (documents.empty()) {
+        std::println(std::cerr, "usage: section_storage_bench [--train dictionary.out] file...");
+        return 1;
+    }
+
+    if (!trainPath.empty()) {
+        std::string samples;
+        std::vector<std::size_t> sizes;
+        for (const auto& sections : documents) {
+            for (const auto& section : sections) {
+                samples += section;
+                sizes.push_back(section.size());
+            }
+        }
+        std::string dictionary(112640, '\0');
+        const auto size = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(), samples.data(), sizes.data(),
+                                                static_cast<unsigned>(sizes.size()));
+        if (ZDICT_isError(size)) {
+            std::println(std::cerr, "Dictionary training failed: {}", ZDICT_getErrorName(size));
+            return 1;
+        }
+        std::ofstream { trainPath, std::ios::binary }.write(dictionary.data(), static_cast<std::streamsize>(size));
+        std::println("Trained a {} B dictionary on {} sections into {}", size, sizes.size(), trainPath);
+    }
+
+    util::ZstdCodec::Options options = util::ZstdCodec::Options::defaults();
+    options.dictionaryPath.clear();
+    util::ZstdCodec withoutDictionary { options };
+
+    const auto plain = measure(documents, nullptr);
+    report("plain text", plain, plain, documents.size());
+    report("zstd", measure(documents, &withoutDictionary), plain, documents.size());
+
+    options.dictionaryPath = trainPath.empty() ? util::ZstdCodec::Options::defaults().dictionaryPath : trainPath;
+    if (!options.dictionaryPath.empty()) {
+        util::ZstdCodec withDictionary { options };
+        report("zstd + dictionary", measure(documents, &withDictionary), plain, documents.size());
+    }
+    return 0;
+}
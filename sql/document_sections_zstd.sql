@@ -0,0 +1,21 @@
+-- Compressed section text. A section keeps its text either in `content` (short or
+-- incompressible text, and every row written before this migration) or as a zstd frame in
+-- `content_zstd`, compressed by the server with the dictionary from SECTION_ZSTD_DICTIONARY.
+-- Frames do not record which dictionary wrote them; when rotating it, list the old file in
+-- SECTION_ZSTD_RETIRED_DICTIONARIES so existing rows stay readable.
+-- The server decompresses on read; the database never looks inside the frame.
+alter table document_sections add column if not exists content_zstd bytea;
+alter table document_sections alter column content drop not null;
+alter table document_sections drop constraint if exists document_sections_content_present;
+alter table document_sections add constraint document_sections_content_present
+    check (content is not null or content_zstd is not null);
+
+-- PostgREST renders bytea as hex; this computed field lets RestDataBaseSession select the frame
+-- as base64 instead (document_sections(..., content_zstd:content_zstd_base64)).
+create or replace function content_zstd_base64(document_sections)
+returns text
+language sql
+stable
+as $$
+    select encode($1.content_zstd, 'base64');
+$$;
@@ -0,0 +1,38 @@
+-- Bulk insert behind RestDataBaseSession::insertDocuments: every document and its sections in
+-- one transaction and one PostgREST round trip (POST /rest/v1/rpc/insert_documents).
+--
+-- documents: [{"external_id": "...", "title": "...",
+--              "sections": [{"title": "...", "content": "..." | null, "content_zstd": "<base64>" | null}]}]
+-- See document_sections_zstd.sql for the content_zstd column.
+--
+-- A document that is already stored (another instance got there first, or its stored copy could
+-- not be read back) keeps its row and gets its sections replaced, so one known id does not fail
+-- the whole batch and a re-download repairs an unreadable copy. The statements run one after
+-- another, so the delete sees the sections of a concurrent insert of the same document that the
+-- upsert waited for, and replaces them instead of doubling them.
+create or replace function insert_documents(documents jsonb)
+returns void
+language sql
+as $$
+    insert into documents (external_id, title)
+    select distinct on (value ->> 'external_id') value ->> 'external_id', value ->> 'title'
+    from jsonb_array_elements(documents)
+    on conflict (external_id) do update set title = excluded.title;
+
+    delete from document_sections s
+    using documents d
+    where s.document_id = d.id
+      and d.external_id in (select value ->> 'external_id' from jsonb_array_elements(documents));
+
+    with input as (
+        select distinct on (value ->> 'external_id') value as document
+        from jsonb_array_elements(documents)
+    )
+    insert into document_sections (document_id, title, content, content_zstd)
+    select d.id, section.value ->> 'title', section.value ->> 'content',
+           decode(section.value ->> 'content_zstd', 'base64')
+    from input
+    join documents d on d.external_id = input.document ->> 'external_id'
+    cross join lateral jsonb_array_elements(input.document -> 'sections') with ordinality as section(value, position)
+    order by d.id, section.position;
+$$;
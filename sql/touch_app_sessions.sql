@@ -0,0 +1,13 @@
+-- Batched last_seen_at update behind RestDataBaseSession::updateAppSessionsLastSeen
+-- (POST /rest/v1/rpc/touch_app_sessions).
+--
+-- sessions: [{"session_hash": "...", "last_seen_at": "..."}]
+create or replace function touch_app_sessions(sessions jsonb)
+returns void
+language sql
+as $$
+    update app_sessions
+    set last_seen_at = touched.last_seen_at
+    from jsonb_to_recordset(sessions) as touched(session_hash text, last_seen_at timestamptz)
+    where app_sessions.session_hash = touched.session_hash;
+$$;
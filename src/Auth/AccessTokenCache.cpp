@@ -0,0 +1,95 @@
+#include "AccessTokenCache.hpp"
+
+#include "Util/ConfigParser.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Network::Auth {
+
+const AccessTokenCache::Options& AccessTokenCache::Options::defaults() {
+    static const Options options = [] {
+        Util::ConfigParser config;
+        Options result;
+        result.maxUsers = static_cast<std::size_t>(config.number("TOKEN_CACHE_MAX_USERS", result.maxUsers));
+        result.margin = std::chrono::seconds(
+            static_cast<std::int64_t>(config.number("TOKEN_CACHE_MARGIN_SEC", result.margin.count())));
+        return result;
+    }();
+    return options;
+}
+
+AccessTokenCache& AccessTokenCache::instance() {
+    static AccessTokenCache cache;
+    return cache;
+}
+
+AccessTokenCache::AccessTokenCache(Options options)
+  : options_(options), slots_(options.maxTokenBytes, std::max<std::size_t>(1, options.maxUsers)) {}
+
+std::optional<std::string> AccessTokenCache::find(std::string_view userId, Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+    auto it = entries_.find(std::string(userId));
+    if (it == entries_.end()) {
+        return std::nullopt;
+    }
+    if (it->second.validUntil <= now) {
+        erase(it);
+        return std::nullopt;
+    }
+    auto bytes = slots_.slot(it->second.slot);
+    return std::string(bytes.data(), it->second.length);
+}
+
+void AccessTokenCache::store(std::string_view userId, std::string_view token, Clock::time_point expiresAt,
+                             Clock::time_point now) {
+    const auto validUntil = expiresAt - options_.margin;
+    if (validUntil <= now || token.size() > slots_.slotSize()) {
+        evict(userId);
+        return;
+    }
+
+    std::lock_guard lock(mutex_);
+    auto it = entries_.find(std::string(userId));
+    if (it == entries_.end()) {
+        auto slot = slots_.acquire();
+        if (!slot) {
+            erase(std::ranges::min_element(entries_, {}, [](const auto& item) { return item.second.validUntil; }));
+            slot = slots_.acquire();
+        }
+        it = entries_.emplace(std::string(userId), Entry { *slot, 0, validUntil }).first;
+    }
+
+    auto bytes = slots_.slot(it->second.slot);
+    std::memcpy(bytes.data(), token.data(), token.size());
+    std::memset(bytes.data() + token.size(), 0, bytes.size() - token.size());
+    it->second.length = token.size();
+    it->second.validUntil = validUntil;
+}
+
+void AccessTokenCache::evict(std::string_view userId) {
+    std::lock_guard lock(mutex_);
+    if (auto it = entries_.find(std::string(userId)); it != entries_.end()) {
+        erase(it);
+    }
+}
+
+std::optional<AccessTokenCache::Clock::time_point> AccessTokenCache::expiresAt(std::string_view userId) const {
+    std::lock_guard lock(mutex_);
+    if (auto it = entries_.find(std::string(userId)); it != entries_.end()) {
+        return it->second.validUntil + options_.margin;
+    }
+    return std::nullopt;
+}
+
+void AccessTokenCache::erase(std::unordered_map<std::string, Entry>::iterator it) {
+    slots_.release(it->second.slot);
+    entries_.erase(it);
+}
+
+std::size_t AccessTokenCache::size() const {
+    std::lock_guard lock(mutex_);
+    return entries_.size();
+}
+
+}   // namespace Network::Auth
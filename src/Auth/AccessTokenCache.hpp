@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Util/LockedSlots.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Network::Auth {
+
+// Process-wide cache of decrypted Google access tokens, one per user. A token is served until
+// its expiry minus `margin`, so callers never get one about to lapse. When every slot is taken
+// the entry closest to expiry makes room.
+//
+// Only the cached copies sit in LockedSlots. find() returns an ordinary heap string, and the
+// token is also in plain memory while it is decrypted or refreshed and in every request that
+// carries it, so this keeps the long-lived copies out of swap and core dumps and nothing more.
+class AccessTokenCache {
+public:
+    struct Options {
+        std::size_t maxUsers = 1024;
+        std::size_t maxTokenBytes = 2048;
+        std::chrono::seconds margin { 300 };
+
+        static const Options& defaults();
+    };
+
+    using Clock = std::chrono::system_clock;
+
+    static AccessTokenCache& instance();
+
+    explicit AccessTokenCache(Options options = Options::defaults());
+
+    // A plain copy: once returned, the token is in ordinary memory.
+    std::optional<std::string> find(std::string_view userId, Clock::time_point now = Clock::now());
+
+    // `expiresAt` is when Google stops accepting the token; the margin is applied here.
+    void store(std::string_view userId, std::string_view token, Clock::time_point expiresAt,
+               Clock::time_point now = Clock::now());
+    void evict(std::string_view userId);
+
+    // When Google stops accepting the cached token, or nothing if no token is cached.
+    std::optional<Clock::time_point> expiresAt(std::string_view userId) const;
+
+    std::chrono::seconds margin() const { return options_.margin; }
+    std::size_t size() const;
+
+private:
+    struct Entry {
+        std::size_t slot;
+        std::size_t length;
+        Clock::time_point validUntil;
+    };
+
+    void erase(std::unordered_map<std::string, Entry>::iterator it);
+
+    Options options_;
+    util::LockedSlots slots_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+};
+
+}   // namespace Network::Auth
@@ -20,6 +20,27 @@ namespace {
         }
         return std::string(value->as_string());
     }
+
+    // Google responses are a few hundred bytes: the DOM lives in a stack buffer and only the
+    // fields kept are copied out. Unlike parse_into this tolerates the fields Google adds over time.
+    template <typename Decode>
+    auto decodeResponse(std::string_view body, Decode decode) {
+        unsigned char buffer[4096];
+        boost::json::monotonic_resource resource(buffer, sizeof(buffer));
+        auto json = boost::json::parse(body, &resource);
+        return decode(json.as_object());
+    }
+
+    Network::GoogleTokenResponse tokenResponseFromJson(const boost::json::object& json) {
+        return Network::GoogleTokenResponse {
+            .accessToken = std::string(json.at("access_token").as_string()),
+            .refreshToken = optionalString(json, "refresh_token"),
+            .idToken = optionalString(json, "id_token"),
+            .tokenType = std::string(json.at("token_type").as_string()),
+            .scope = optionalString(json, "scope").value_or(""),
+            .expiresIn = static_cast<int>(json.at("expires_in").as_int64()),
+        };
+    }
 }
 
 namespace Network {
@@ -59,18 +80,7 @@ asio::awaitable<GoogleTokenResponse> GoogleOAuthClient::exchangeCodeForTokens(st
             res.body()));
     }
 
-    auto json = boost::json::parse(res.body()).as_object();
-
-    GoogleTokenResponse tokenResponse{
-        .accessToken = std::string(json["access_token"].as_string()),
-        .refreshToken = optionalString(json, "refresh_token"),
-        .idToken = optionalString(json, "id_token"),
-        .tokenType = std::string(json["token_type"].as_string()),
-        .scope = optionalString(json, "scope").value_or(""),
-        .expiresIn = static_cast<int>(json["expires_in"].as_int64()),
-    };
-
-    co_return tokenResponse;
+    co_return decodeResponse(res.body(), tokenResponseFromJson);
 }
 asio::awaitable<GoogleTokenResponse> GoogleOAuthClient::refreshAccessToken(std::string_view refreshToken) {
     if (config["GOOGLE_CLIENT_ID"].empty() || config["GOOGLE_CLIENT_SECRET"].empty()) {
@@ -100,18 +110,7 @@ asio::awaitable<GoogleTokenResponse> GoogleOAuthClient::refreshAccessToken(std::
             res.body()));
     }
 
-    auto json = boost::json::parse(res.body()).as_object();
-
-    GoogleTokenResponse tokenResponse{
-        .accessToken = std::string(json["access_token"].as_string()),
-        .refreshToken = optionalString(json, "refresh_token"),
-        .idToken = optionalString(json, "id_token"),
-        .tokenType = std::string(json["token_type"].as_string()),
-        .scope = optionalString(json, "scope").value_or(""),
-        .expiresIn = static_cast<int>(json["expires_in"].as_int64()),
-    };
-
-    co_return tokenResponse;
+    co_return decodeResponse(res.body(), tokenResponseFromJson);
 }
 
 asio::awaitable<GoogleUserInfo> GoogleOAuthClient::fetchUserInfo(std::string_view accessToken) {
@@ -130,16 +129,14 @@ asio::awaitable<GoogleUserInfo> GoogleOAuthClient::fetchUserInfo(std::string_vie
             res.body()));
     }
 
-    auto json = boost::json::parse(res.body()).as_object();
-
-    GoogleUserInfo userInfo{
-        .sub = std::string(json["sub"].as_string()),
-        .email = optionalString(json, "email").value_or(""),
-        .name = optionalString(json, "name").value_or(""),
-        .pictureUrl = optionalString(json, "picture").value_or(""),
-    };
-
-    co_return userInfo;
+    co_return decodeResponse(res.body(), [](const boost::json::object& json) {
+        return GoogleUserInfo {
+            .sub = std::string(json.at("sub").as_string()),
+            .email = optionalString(json, "email").value_or(""),
+            .name = optionalString(json, "name").value_or(""),
+            .pictureUrl = optionalString(json, "picture").value_or(""),
+        };
+    });
 }
 
 } // namespace Network
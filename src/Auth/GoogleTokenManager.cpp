@@ -1,8 +1,11 @@
 #include "GoogleTokenManager.hpp"
+#include "AccessTokenCache.hpp"
 #include "GoogleOAuthClient.hpp"
 #include "Util/Encrypt.hpp"
+#include "Util/SingleFlight.hpp"
 #include "Util/TimeFunc.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <print>
 
@@ -10,16 +13,19 @@ namespace {
 
 namespace asio = boost::asio;
 
-}
-
-namespace  Network::Auth {
+using Clock = std::chrono::system_clock;
 
-GoogleTokenManager::GoogleTokenManager(
-    const asio::any_io_executor& executor, const std::shared_ptr<DataBaseSession>& database,
-    Util::ConfigParser& parser)
-: databaseSession(database) , config(parser), executor(executor) {}
+// One load (and, near expiry, one refresh) per user at a time, shared by every request for that user.
+util::SingleFlight<std::string, std::optional<std::string>>& tokenFlights() {
+    static util::SingleFlight<std::string, std::optional<std::string>> flights;
+    return flights;
+}
 
-asio::awaitable<std::optional<std::string>> GoogleTokenManager::getValidAccessToken(std::string_view userId) const {
+// Runs detached from the request that started it, so it owns everything it touches.
+asio::awaitable<std::optional<std::string>> loadAccessToken(
+    asio::any_io_executor executor, std::shared_ptr<Network::DataBaseSession> databaseSession,
+    std::string encrypt_key, std::string userId, std::chrono::seconds refreshWithin) {
+    auto& cache = Network::Auth::AccessTokenCache::instance();
 
     auto auth = co_await databaseSession->selectGoogleOAuthTokens(userId);
     if (auth == std::nullopt) {
@@ -27,10 +33,6 @@ asio::awaitable<std::optional<std::string>> GoogleTokenManager::getValidAccessTo
     }
 
     std::string_view access_token = auth->accessTokenEnc;
-    auto encrypt_key = std::string(config["TOKEN_ENCRYPTION_KEY"]);
-    if (encrypt_key.empty()) {
-        encrypt_key = std::string(config["SECRET_KEY"]);
-    }
     std::string decrypt_access_token;
     try {
         decrypt_access_token = util::textDecrypt(access_token, encrypt_key);
@@ -39,12 +41,12 @@ asio::awaitable<std::optional<std::string>> GoogleTokenManager::getValidAccessTo
         co_return std::nullopt;
     }
 
-    if (!util::time::isTimestampAfterNowPlus(auth->expiresAt, 300)) {
+    if (!util::time::isTimestampAfterNowPlus(auth->expiresAt, static_cast<int>(refreshWithin.count()))) {
         if (auth->refreshTokenEnc == std::nullopt) {
             co_return std::nullopt;
         }
 
-        GoogleOAuthClient client{executor};
+        Network::Auth::GoogleOAuthClient client{executor};
         std::string decrypt_refresh_token;
         try {
             decrypt_refresh_token = util::textDecrypt(auth->refreshTokenEnc.value(), encrypt_key);
@@ -53,7 +55,7 @@ asio::awaitable<std::optional<std::string>> GoogleTokenManager::getValidAccessTo
             co_return std::nullopt;
         }
 
-        GoogleTokenResponse tokenRes;
+        Network::Auth::GoogleTokenResponse tokenRes;
         try {
             tokenRes = co_await client.refreshAccessToken(decrypt_refresh_token);
         } catch (const std::exception& e) {
@@ -69,7 +71,7 @@ asio::awaitable<std::optional<std::string>> GoogleTokenManager::getValidAccessTo
             new_encrypt_refresh_token = util::textEncrypt(tokenRes.refreshToken.value(), encrypt_key);
         }
         co_await databaseSession->upsertGoogleOAuthTokens({
-            .userId = std::string(userId),
+            .userId = userId,
             .accessTokenEnc = new_encrypt_access_token,
             .refreshTokenEnc = new_encrypt_refresh_token,
             .expiresAt = util::time::getCurrentTimeAfterSeconds(tokenRes.expiresIn),
@@ -77,9 +79,49 @@ asio::awaitable<std::optional<std::string>> GoogleTokenManager::getValidAccessTo
             .tokenType =tokenRes.tokenType
         });
 
+        cache.store(userId, tokenRes.accessToken, Clock::now() + std::chrono::seconds(tokenRes.expiresIn));
         co_return tokenRes.accessToken;
     }
 
+    if (auto expiresAt = util::time::parseTimestamp(auth->expiresAt)) {
+        cache.store(userId, decrypt_access_token, *expiresAt);
+    }
     co_return decrypt_access_token;
 }
+
+}
+
+namespace  Network::Auth {
+
+GoogleTokenManager::GoogleTokenManager(
+    const asio::any_io_executor& executor, const std::shared_ptr<DataBaseSession>& database,
+    Util::ConfigParser& parser)
+: databaseSession(database) , config(parser), executor(executor) {}
+
+asio::awaitable<std::optional<std::string>> GoogleTokenManager::getValidAccessToken(std::string_view userId) const {
+    if (auto cached = AccessTokenCache::instance().find(userId)) {
+        co_return cached;
+    }
+    co_return co_await load(userId, AccessTokenCache::instance().margin());
+}
+
+asio::awaitable<std::optional<std::string>> GoogleTokenManager::refreshAhead(
+    std::string_view userId, std::chrono::seconds ahead) const {
+    co_return co_await load(userId, std::max(ahead, AccessTokenCache::instance().margin()));
+}
+
+asio::awaitable<std::optional<std::string>> GoogleTokenManager::load(
+    std::string_view userId, std::chrono::seconds refreshWithin) const {
+    auto encrypt_key = std::string(config["TOKEN_ENCRYPTION_KEY"]);
+    if (encrypt_key.empty()) {
+        encrypt_key = std::string(config["SECRET_KEY"]);
+    }
+
+    co_return co_await tokenFlights().run(
+        std::string(userId),
+        [executor = executor, databaseSession = databaseSession, encrypt_key = std::move(encrypt_key),
+         userId = std::string(userId), refreshWithin] {
+            return loadAccessToken(executor, databaseSession, encrypt_key, userId, refreshWithin);
+        });
+}
 }   // namespace Network::Auth
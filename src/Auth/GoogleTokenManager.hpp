@@ -5,6 +5,7 @@
 #include <Session/DataBaseSession.hpp>
 #include <Util/ConfigParser.hpp>
 
+#include <chrono>
 #include <memory>
 
 namespace Network::Auth {
@@ -15,7 +16,13 @@ public:
 
     boost::asio::awaitable<std::optional<std::string>> getValidAccessToken(std::string_view userId) const;
 
+    // Background refresh: renews the token if it expires within `ahead`, writing the new one
+    // through to the database and the access-token cache.
+    boost::asio::awaitable<std::optional<std::string>> refreshAhead(std::string_view userId, std::chrono::seconds ahead) const;
+
 private:
+    boost::asio::awaitable<std::optional<std::string>> load(std::string_view userId, std::chrono::seconds refreshWithin) const;
+
     std::shared_ptr<DataBaseSession> databaseSession;
     Util::ConfigParser &config;
     boost::asio::any_io_executor executor;
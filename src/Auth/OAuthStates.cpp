@@ -0,0 +1,117 @@
+#include "OAuthStates.hpp"
+
+#include "Util/ConfigParser.hpp"
+#include "Util/Encrypt.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <format>
+#include <iostream>
+#include <print>
+#include <ranges>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+constexpr std::string_view VERSION = "o1";
+constexpr std::size_t FIELDS = 5;
+
+}   // namespace
+
+namespace Network::Auth {
+
+const OAuthStates::Options& OAuthStates::Options::defaults() {
+    static const Options options = [] {
+        Util::ConfigParser config;
+        Options result;
+        result.keys = SessionTokens::Options::defaults().keys;
+        result.lifetime = std::chrono::seconds(
+            static_cast<std::int64_t>(config.number("OAUTH_STATE_TTL_SEC", result.lifetime.count())));
+        result.maxPending = static_cast<std::size_t>(config.number("OAUTH_STATE_MAX_PENDING", result.maxPending));
+        return result;
+    }();
+    return options;
+}
+
+OAuthStates::OAuthStates(Options options) : options_(std::move(options)) {}
+
+bool OAuthStates::isSigned(std::string_view state) {
+    return state.starts_with(VERSION) && state.substr(VERSION.size()).starts_with('.');
+}
+
+std::string OAuthStates::issue(Clock::time_point now) const {
+    if (!enabled()) {
+        throw std::logic_error("No OAuth state signing key configured");
+    }
+
+    const auto& key = options_.keys.front();
+    auto expiresAt = std::chrono::floor<std::chrono::seconds>(now + options_.lifetime);
+    auto body = std::format("{}.{}.{}.{}", VERSION, key.id, util::randomUrlSafeToken(16),
+                            expiresAt.time_since_epoch().count());
+    auto mac = util::hmacSha256UrlSafe(key.secret, body);
+    return body + "." + mac;
+}
+
+bool OAuthStates::consume(std::string_view state, Clock::time_point now) {
+    std::array<std::string_view, FIELDS> fields;
+    std::size_t count = 0;
+    for (auto part : state | std::views::split('.')) {
+        if (count == FIELDS) {
+            return false;
+        }
+        fields[count++] = std::string_view(std::ranges::begin(part), std::ranges::end(part));
+    }
+    if (count != FIELDS || fields[0] != VERSION || fields[2].empty()) {
+        return false;
+    }
+
+    auto key = std::ranges::find(options_.keys, fields[1], &SessionTokens::Key::id);
+    if (key == options_.keys.end()) {
+        return false;
+    }
+    auto body = state.substr(0, state.size() - fields[4].size() - 1);
+    if (!util::constantTimeEquals(util::hmacSha256UrlSafe(key->secret, body), fields[4])) {
+        return false;
+    }
+
+    std::int64_t expiry = 0;
+    auto [end, ec] = std::from_chars(fields[3].data(), fields[3].data() + fields[3].size(), expiry);
+    if (ec != std::errc {} || end != fields[3].data() + fields[3].size()) {
+        return false;
+    }
+    auto expiresAt = Clock::time_point { std::chrono::seconds { expiry } };
+    // A state from a longer lifetime setting would fall outside the two live windows.
+    if (expiresAt <= now || expiresAt > now + options_.lifetime) {
+        return false;
+    }
+
+    // Valid states expire within (now, now + lifetime], i.e. in the current window or the next;
+    // a slot still holding an older window only holds expired states and is reused.
+    const auto lifetime = std::max<std::int64_t>(1, options_.lifetime.count());
+    const auto index = expiry / lifetime;
+    const auto nonce = std::hash<std::string_view> {}(fields[2]);
+
+    std::lock_guard lock(mutex_);
+    auto& window = windows_[static_cast<std::size_t>(index % 2)];
+    if (window.index != index) {
+        window.index = index;
+        window.nonces.clear();
+        window.full = false;
+    }
+    if (window.nonces.contains(nonce)) {
+        return false;
+    }
+    if (window.nonces.size() >= options_.maxPending) {
+        if (!std::exchange(window.full, true)) {
+            std::println(std::cerr, "More than {} OAuth states in one window; accepting further ones unchecked",
+                         options_.maxPending);
+        }
+        return true;
+    }
+    window.nonces.insert(nonce);
+    return true;
+}
+
+}   // namespace Network::Auth
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Auth/SessionTokens.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace Network::Auth {
+
+// OAuth `state` values that need no database row:
+//   o1.<key id>.<nonce>.<expiry, unix seconds>.<HMAC-SHA256, base64url>
+// They are signed with the session signing keys; the "o1" prefix keeps a session cookie from
+// passing as a state and the other way round.
+//
+// A state can be used once per instance, not once overall: nonces are remembered in memory
+// only, so with several instances behind a balancer a state can be replayed once on each.
+// Nonces sit in one of two sets keyed by expiry, each covering one `lifetime`; a set is
+// dropped whole once every state in it has expired. A set that reaches `maxPending` nonces
+// stops remembering new ones and lets them through unchecked, so a flood of logins costs
+// replay protection for that window, never logins.
+class OAuthStates {
+public:
+    struct Options {
+        std::vector<SessionTokens::Key> keys;
+        std::chrono::seconds lifetime { 300 };
+        // Remembered nonces per lifetime window; two windows are live at a time.
+        std::size_t maxPending = 100'000;
+
+        static const Options& defaults();
+    };
+
+    using Clock = std::chrono::system_clock;
+
+    explicit OAuthStates(Options options = Options::defaults());
+
+    bool enabled() const { return !options_.keys.empty(); }
+
+    static bool isSigned(std::string_view state);
+
+    std::string issue(Clock::time_point now = Clock::now()) const;
+
+    // True the first time a valid, unexpired `state` is presented to this instance.
+    bool consume(std::string_view state, Clock::time_point now = Clock::now());
+
+private:
+    struct Window {
+        // Expiry divided by the lifetime; states in one window expire within one lifetime.
+        std::int64_t index = -1;
+        std::unordered_set<std::uint64_t> nonces;
+        bool full = false;
+    };
+
+    Options options_;
+
+    std::mutex mutex_;
+    std::array<Window, 2> windows_;
+};
+
+}   // namespace Network::Auth
@@ -0,0 +1,89 @@
+#include "RevocationSet.hpp"
+
+#include "Util/ConfigParser.hpp"
+
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include <iostream>
+#include <print>
+
+namespace Network::Auth {
+
+const RevocationSet::Options& RevocationSet::Options::defaults() {
+    static const Options options = [] {
+        Util::ConfigParser config;
+        Options result;
+        result.refreshInterval = std::chrono::seconds(static_cast<std::int64_t>(
+            config.number("SESSION_REVOCATION_REFRESH_SEC", result.refreshInterval.count())));
+        result.maxStaleness = std::chrono::seconds(static_cast<std::int64_t>(
+            config.number("SESSION_REVOCATION_MAX_STALENESS_SEC", result.maxStaleness.count())));
+        return result;
+    }();
+    return options;
+}
+
+RevocationSet::RevocationSet(Options options) : options_(options) {}
+
+bool RevocationSet::current(Clock::time_point now) const {
+    std::lock_guard lock(mutex_);
+    return loadedAt_ && now - *loadedAt_ <= options_.maxStaleness;
+}
+
+bool RevocationSet::contains(std::string_view sessionHash) const {
+    std::lock_guard lock(mutex_);
+    return revoked_.contains(std::string(sessionHash));
+}
+
+void RevocationSet::revoke(std::string_view sessionHash, Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+    revoked_.insert_or_assign(std::string(sessionHash), now);
+}
+
+std::size_t RevocationSet::size() const {
+    std::lock_guard lock(mutex_);
+    return revoked_.size();
+}
+
+boost::asio::awaitable<void> RevocationSet::run(Loader load) {
+    boost::asio::steady_timer timer { co_await boost::asio::this_coro::executor };
+    while (true) {
+        co_await refresh(load);
+        timer.expires_after(options_.refreshInterval);
+        co_await timer.async_wait(boost::asio::use_awaitable);
+    }
+}
+
+boost::asio::awaitable<bool> RevocationSet::refresh(const Loader& load) {
+    const auto started = Clock::now();
+
+    std::optional<std::vector<std::string>> hashes;
+    try {
+        hashes = co_await load();
+    } catch (const std::exception& e) {
+        std::println(std::cerr, "Session revocation refresh failed: {}", e.what());
+    }
+    if (!hashes) {
+        co_return false;
+    }
+
+    std::unordered_map<std::string, Clock::time_point> revoked;
+    revoked.reserve(hashes->size());
+    for (auto& hash : *hashes) {
+        revoked.emplace(std::move(hash), Clock::time_point {});
+    }
+
+    std::lock_guard lock(mutex_);
+    // Revocations made while the query ran may be missing from its result.
+    for (const auto& [hash, revokedAt] : revoked_) {
+        if (revokedAt >= started) {
+            revoked.emplace(hash, revokedAt);
+        }
+    }
+    revoked_ = std::move(revoked);
+    loadedAt_ = started;
+    co_return true;
+}
+
+}   // namespace Network::Auth
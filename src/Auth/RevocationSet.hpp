@@ -0,0 +1,54 @@
+#pragma once
+
+#include <boost/asio/awaitable.hpp>
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Network::Auth {
+
+// Hashes of revoked sessions that have not expired yet, which is all a signed session token
+// needs checked besides its signature. Every instance reloads the set from app_sessions each
+// `refreshInterval` and adds its own revocations, and those announced by other instances, as
+// they happen. If no reload has succeeded within `maxStaleness` the set is not current and
+// callers go back to the database.
+class RevocationSet {
+public:
+    struct Options {
+        std::chrono::seconds refreshInterval { 30 };
+        std::chrono::seconds maxStaleness { 120 };
+
+        static const Options& defaults();
+    };
+
+    using Clock = std::chrono::steady_clock;
+    // Hashes of every revoked, unexpired session, or nothing if they could not be read.
+    using Loader = std::function<boost::asio::awaitable<std::optional<std::vector<std::string>>>()>;
+
+    explicit RevocationSet(Options options = Options::defaults());
+
+    bool current(Clock::time_point now = Clock::now()) const;
+    bool contains(std::string_view sessionHash) const;
+    void revoke(std::string_view sessionHash, Clock::time_point now = Clock::now());
+
+    boost::asio::awaitable<void> run(Loader load);
+    boost::asio::awaitable<bool> refresh(const Loader& load);
+
+    std::size_t size() const;
+
+private:
+    Options options_;
+
+    mutable std::mutex mutex_;
+    // Hash -> when this instance revoked it, or Clock::time_point {} for loaded entries.
+    std::unordered_map<std::string, Clock::time_point> revoked_;
+    std::optional<Clock::time_point> loadedAt_;
+};
+
+}   // namespace Network::Auth
@@ -0,0 +1,102 @@
+#include "SessionTokens.hpp"
+
+#include "Util/ConfigParser.hpp"
+#include "Util/Encrypt.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <format>
+#include <iostream>
+#include <print>
+#include <ranges>
+#include <stdexcept>
+
+namespace {
+
+constexpr std::string_view VERSION = "s1";
+constexpr std::size_t FIELDS = 6;
+
+// Fields are joined with '.', so none of them may contain one.
+bool validField(std::string_view field) { return !field.empty() && field.find('.') == std::string_view::npos; }
+
+}   // namespace
+
+namespace Network::Auth {
+
+const SessionTokens::Options& SessionTokens::Options::defaults() {
+    static const Options options = [] {
+        Util::ConfigParser config;
+        Options result;
+        for (auto part : config["SESSION_SIGNING_KEYS"] | std::views::split(',')) {
+            std::string_view entry(std::ranges::begin(part), std::ranges::end(part));
+            auto colon = entry.find(':');
+            if (colon == std::string_view::npos || !validField(entry.substr(0, colon)) || colon + 1 == entry.size()) {
+                std::println(std::cerr, "Ignoring malformed SESSION_SIGNING_KEYS entry");
+                continue;
+            }
+            result.keys.push_back({ .id = std::string(entry.substr(0, colon)), .secret = std::string(entry.substr(colon + 1)) });
+        }
+        return result;
+    }();
+    return options;
+}
+
+SessionTokens::SessionTokens(Options options) : options_(std::move(options)) {}
+
+bool SessionTokens::isSigned(std::string_view cookie) {
+    return cookie.starts_with(VERSION) && cookie.substr(VERSION.size()).starts_with('.');
+}
+
+std::string SessionTokens::issue(const Claims& claims) const {
+    if (!enabled()) {
+        throw std::logic_error("No session signing key configured");
+    }
+    if (!validField(claims.sessionId) || !validField(claims.userId)) {
+        throw std::invalid_argument("Session token fields must be non-empty and free of '.'");
+    }
+
+    const auto& key = options_.keys.front();
+    auto body = std::format("{}.{}.{}.{}.{}", VERSION, key.id, claims.sessionId, claims.userId,
+                            claims.expiresAt.time_since_epoch().count());
+    auto mac = util::hmacSha256UrlSafe(key.secret, body);
+    return body + "." + mac;
+}
+
+std::optional<SessionTokens::Claims> SessionTokens::verify(
+    std::string_view token, std::chrono::system_clock::time_point now) const {
+    std::array<std::string_view, FIELDS> fields;
+    std::size_t count = 0;
+    for (auto part : token | std::views::split('.')) {
+        if (count == FIELDS) {
+            return std::nullopt;
+        }
+        fields[count++] = std::string_view(std::ranges::begin(part), std::ranges::end(part));
+    }
+    if (count != FIELDS || fields[0] != VERSION) {
+        return std::nullopt;
+    }
+
+    auto key = std::ranges::find(options_.keys, fields[1], &Key::id);
+    if (key == options_.keys.end()) {
+        return std::nullopt;
+    }
+    auto body = token.substr(0, token.size() - fields[5].size() - 1);
+    if (!util::constantTimeEquals(util::hmacSha256UrlSafe(key->secret, body), fields[5])) {
+        return std::nullopt;
+    }
+
+    std::int64_t expiry = 0;
+    auto [end, ec] = std::from_chars(fields[4].data(), fields[4].data() + fields[4].size(), expiry);
+    if (ec != std::errc {} || end != fields[4].data() + fields[4].size()) {
+        return std::nullopt;
+    }
+    auto expiresAt = std::chrono::sys_seconds { std::chrono::seconds { expiry } };
+    if (expiresAt <= now || !validField(fields[2]) || !validField(fields[3])) {
+        return std::nullopt;
+    }
+
+    return Claims { .sessionId = std::string(fields[2]), .userId = std::string(fields[3]), .expiresAt = expiresAt };
+}
+
+}   // namespace Network::Auth
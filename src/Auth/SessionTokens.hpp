@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Network::Auth {
+
+// Session cookies that verify without a database round trip:
+//   s1.<key id>.<session id>.<user id>.<expiry, unix seconds>.<HMAC-SHA256, base64url>
+// The session id is the same random secret an opaque cookie carries, so its hash still names
+// the app_sessions row used for revocation and last-seen updates. Signing is on when
+// SESSION_SIGNING_KEYS is set; opaque cookies issued before keep working.
+class SessionTokens {
+public:
+    struct Key {
+        std::string id;
+        std::string secret;
+    };
+
+    struct Options {
+        // The first key signs and every key verifies, so a new key goes first while the old
+        // one stays until the tokens it signed have expired. "id:secret,id:secret".
+        std::vector<Key> keys;
+
+        static const Options& defaults();
+    };
+
+    struct Claims {
+        std::string sessionId;
+        std::string userId;
+        std::chrono::sys_seconds expiresAt;
+    };
+
+    explicit SessionTokens(Options options = Options::defaults());
+
+    bool enabled() const { return !options_.keys.empty(); }
+
+    static bool isSigned(std::string_view cookie);
+
+    std::string issue(const Claims& claims) const;
+
+    // The claims of a well-formed, correctly signed, unexpired token.
+    std::optional<Claims> verify(std::string_view token,
+                                 std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) const;
+
+private:
+    Options options_;
+};
+
+}   // namespace Network::Auth
@@ -0,0 +1,145 @@
+#include "TokenRefresher.hpp"
+
+#include "Util/ConfigParser.hpp"
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/deferred.hpp>
+#include <boost/asio/experimental/parallel_group.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <print>
+#include <random>
+
+namespace asio = boost::asio;
+namespace X = boost::asio::experimental;
+
+namespace Network::Auth {
+
+const TokenRefresher::Options& TokenRefresher::Options::defaults() {
+    static const Options options = [] {
+        Util::ConfigParser config;
+        Options result;
+        result.interval = std::chrono::seconds(
+            static_cast<std::int64_t>(config.number("TOKEN_REFRESH_INTERVAL_SEC", result.interval.count())));
+        result.refreshAhead = std::chrono::seconds(
+            static_cast<std::int64_t>(config.number("TOKEN_REFRESH_AHEAD_SEC", result.refreshAhead.count())));
+        result.activeWindow = std::chrono::seconds(
+            static_cast<std::int64_t>(config.number("TOKEN_REFRESH_ACTIVE_SEC", result.activeWindow.count())));
+        result.jitter = std::chrono::milliseconds(
+            static_cast<std::int64_t>(config.number("TOKEN_REFRESH_JITTER_MS", result.jitter.count())));
+        result.maxBackoff = std::chrono::seconds(
+            static_cast<std::int64_t>(config.number("TOKEN_REFRESH_MAX_BACKOFF_SEC", result.maxBackoff.count())));
+        result.concurrency = static_cast<std::size_t>(config.number("TOKEN_REFRESH_CONCURRENCY", result.concurrency));
+        return result;
+    }();
+    return options;
+}
+
+TokenRefresher::TokenRefresher(asio::any_io_executor executor, Refresh refresh, AccessTokenCache& cache, Options options)
+  : executor_(std::move(executor)), refresh_(std::move(refresh)), cache_(cache), options_(options) {}
+
+void TokenRefresher::touch(std::string_view userId, Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+    lastActive_.insert_or_assign(std::string(userId), now);
+}
+
+std::vector<std::string> TokenRefresher::due(Clock::time_point now) {
+    std::vector<std::string> users;
+    std::lock_guard lock(mutex_);
+    std::erase_if(lastActive_, [&](const auto& item) { return item.second + options_.activeWindow < now; });
+    std::erase_if(backoff_, [&](const auto& item) { return !lastActive_.contains(item.first); });
+    for (const auto& [userId, _] : lastActive_) {
+        if (auto it = backoff_.find(userId); it != backoff_.end() && now < it->second.retryAt) {
+            continue;
+        }
+        auto expiresAt = cache_.expiresAt(userId);
+        if (!expiresAt || *expiresAt <= now + options_.refreshAhead) {
+            users.push_back(userId);
+        }
+    }
+    return users;
+}
+
+asio::awaitable<void> TokenRefresher::run() {
+    asio::steady_timer timer { executor_ };
+    while (true) {
+        timer.expires_after(options_.interval);
+        co_await timer.async_wait(asio::use_awaitable);
+        co_await refreshDue();
+    }
+}
+
+asio::awaitable<void> TokenRefresher::refreshDue() {
+    auto users = due();
+    if (users.empty()) {
+        co_return;
+    }
+
+    // Starts are spread evenly over the jitter window in random order; the window never outlasts
+    // the interval, so one round is done before the next is due.
+    std::ranges::shuffle(users, std::minstd_rand { std::random_device {}() });
+    const auto window = std::min<std::chrono::steady_clock::duration>(options_.jitter, options_.interval);
+    const auto spacing = window / users.size();
+    const auto start = std::chrono::steady_clock::now();
+
+    std::size_t next = 0;
+    auto make_op = [&]() -> decltype(auto) {
+        return asio::co_spawn(
+            executor_, [&]() -> asio::awaitable<void> { co_await worker(users, next, start, spacing); }, asio::deferred);
+    };
+
+    auto first = make_op();
+
+    using Op = decltype(first);
+
+    const auto workers = std::min(std::max<std::size_t>(1, options_.concurrency), users.size());
+    std::vector<Op> ops;
+    ops.reserve(workers);
+    ops.emplace_back(std::move(first));
+    for (std::size_t i = 1; i < workers; ++i) {
+        ops.emplace_back(make_op());
+    }
+
+    co_await X::make_parallel_group(std::move(ops)).async_wait(X::wait_for_all(), asio::use_awaitable);
+}
+
+asio::awaitable<void> TokenRefresher::worker(std::vector<std::string>& users, std::size_t& next,
+                                             std::chrono::steady_clock::time_point start,
+                                             std::chrono::steady_clock::duration spacing) {
+    // All workers run on the server's single-threaded io_context, so `next` needs no lock.
+    asio::steady_timer timer { executor_ };
+
+    while (next < users.size()) {
+        const auto index = next++;
+        auto userId = std::move(users[index]);
+
+        timer.expires_at(start + spacing * index);
+        co_await timer.async_wait(asio::use_awaitable);
+
+        bool refreshed = false;
+        try {
+            refreshed = co_await refresh_(userId);
+        } catch (const std::exception& e) {
+            std::println(std::cerr, "Background token refresh failed: {}", e.what());
+        }
+        record(userId, refreshed);
+    }
+}
+
+void TokenRefresher::record(const std::string& userId, bool refreshed, Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+    if (refreshed) {
+        backoff_.erase(userId);
+        return;
+    }
+    auto& backoff = backoff_[userId];
+    backoff.failures = std::min(backoff.failures + 1, 16u);
+    const auto delay = options_.interval * (std::int64_t { 1 } << backoff.failures);
+    backoff.retryAt = now + std::min<Clock::duration>(delay, options_.maxBackoff);
+}
+
+}   // namespace Network::Auth
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "AccessTokenCache.hpp"
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Network::Auth {
+
+// Refreshes the Google access tokens of recently active users before they expire, so the
+// refresh round trip happens here rather than inside a user's request. Every `interval` the
+// users seen within `activeWindow` whose token expires within `refreshAhead` (or is not
+// cached) are handed to `refresh`, at most `concurrency` at a time. Their start times are
+// spread in random order over `jitter` (at most one interval), so a burst of logins does not
+// turn into a burst of refreshes. A user whose refresh fails, or who has no tokens, is left
+// alone for twice as many intervals after each failure, up to `maxBackoff`.
+class TokenRefresher {
+public:
+    struct Options {
+        std::chrono::seconds interval { 60 };
+        std::chrono::seconds refreshAhead { 900 };
+        std::chrono::seconds activeWindow { 1800 };
+        std::chrono::milliseconds jitter { 30000 };
+        std::chrono::seconds maxBackoff { 3600 };
+        std::size_t concurrency = 4;
+
+        static const Options& defaults();
+    };
+
+    using Clock = AccessTokenCache::Clock;
+    // Refreshes and stores the user's token; false if the user has no usable token afterwards.
+    // Failures are the callee's to log.
+    using Refresh = std::function<boost::asio::awaitable<bool>(std::string userId)>;
+
+    TokenRefresher(boost::asio::any_io_executor executor, Refresh refresh,
+                   AccessTokenCache& cache = AccessTokenCache::instance(), Options options = Options::defaults());
+
+    void touch(std::string_view userId, Clock::time_point now = Clock::now());
+
+    // Users to refresh now, minus those backing off; users idle longer than `activeWindow` are forgotten.
+    std::vector<std::string> due(Clock::time_point now = Clock::now());
+
+    boost::asio::awaitable<void> run();
+    boost::asio::awaitable<void> refreshDue();
+
+private:
+    struct Backoff {
+        unsigned failures = 0;
+        Clock::time_point retryAt;
+    };
+
+    boost::asio::awaitable<void> worker(std::vector<std::string>& users, std::size_t& next,
+                                        std::chrono::steady_clock::time_point start,
+                                        std::chrono::steady_clock::duration spacing);
+    void record(const std::string& userId, bool refreshed, Clock::time_point now = Clock::now());
+
+    boost::asio::any_io_executor executor_;
+    Refresh refresh_;
+    AccessTokenCache& cache_;
+    Options options_;
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, Clock::time_point> lastActive_;
+    std::unordered_map<std::string, Backoff> backoff_;
+};
+
+}   // namespace Network::Auth
@@ -0,0 +1,109 @@
+#include "DocumentFilter.hpp"
+
+#include "Util/ConfigParser.hpp"
+
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <print>
+
+namespace Cache {
+
+const DocumentFilter::Options& DocumentFilter::Options::defaults() {
+    static const Options options = [] {
+        Util::ConfigParser config;
+        Options result;
+        result.enabled = config.flag("DOCUMENT_FILTER_ENABLED", result.enabled);
+        result.capacity = static_cast<std::size_t>(config.number("DOCUMENT_FILTER_CAPACITY", result.capacity));
+        result.falsePositiveRate = config.number("DOCUMENT_FILTER_FP_RATE", result.falsePositiveRate);
+        result.rebuildInterval = std::chrono::seconds(
+            static_cast<std::int64_t>(config.number("DOCUMENT_FILTER_REBUILD_SEC", result.rebuildInterval.count())));
+        return result;
+    }();
+    return options;
+}
+
+DocumentFilter::DocumentFilter(Options options)
+  : options_(options),
+    skipped_(util::metrics::Registry::instance().counter(
+        "anty_document_filter_skips_total", "Document lookups skipped because the id was never stored")) {}
+
+bool DocumentFilter::mightContain(std::string_view documentId) const {
+    std::lock_guard lock(mutex_);
+    if (filter_ == nullptr || filter_->mightContain(documentId)) {
+        return true;
+    }
+    skipped_.inc();
+    return false;
+}
+
+void DocumentFilter::add(std::string_view documentId) {
+    std::lock_guard lock(mutex_);
+    if (filter_ != nullptr) {
+        filter_->add(documentId);
+    }
+    if (rebuilding_) {
+        addedDuringRebuild_.emplace_back(documentId);
+    }
+}
+
+bool DocumentFilter::ready() const {
+    std::lock_guard lock(mutex_);
+    return filter_ != nullptr;
+}
+
+boost::asio::awaitable<void> DocumentFilter::run(Loader load) {
+    if (!options_.enabled) {
+        co_return;
+    }
+
+    boost::asio::steady_timer timer { co_await boost::asio::this_coro::executor };
+    while (true) {
+        const bool loaded = co_await rebuild(load);
+        timer.expires_after(loaded ? options_.rebuildInterval : options_.retryInterval);
+        co_await timer.async_wait(boost::asio::use_awaitable);
+    }
+}
+
+boost::asio::awaitable<bool> DocumentFilter::rebuild(const Loader& load) {
+    {
+        std::lock_guard lock(mutex_);
+        rebuilding_ = true;
+        addedDuringRebuild_.clear();
+    }
+
+    std::optional<std::vector<std::string>> ids;
+    try {
+        ids = co_await load();
+    } catch (const std::exception& e) {
+        std::println(std::cerr, "Document filter load failed: {}", e.what());
+    }
+
+    if (!ids) {
+        std::lock_guard lock(mutex_);
+        rebuilding_ = false;
+        addedDuringRebuild_.clear();
+        co_return false;
+    }
+
+    // Room to grow until the next rebuild resizes it.
+    auto filter = std::make_unique<util::BloomFilter>(
+        std::max(options_.capacity, 2 * ids->size()), options_.falsePositiveRate);
+    for (const auto& id : *ids) {
+        filter->add(id);
+    }
+
+    std::lock_guard lock(mutex_);
+    for (const auto& id : addedDuringRebuild_) {
+        filter->add(id);
+    }
+    filter_ = std::move(filter);
+    rebuilding_ = false;
+    addedDuringRebuild_.clear();
+    co_return true;
+}
+
+}   // namespace Cache
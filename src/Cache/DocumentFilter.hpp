@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Util/BloomFilter.hpp"
+#include "Util/Metrics.hpp"
+
+#include <boost/asio/awaitable.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Cache {
+
+// Bloom filter of every stored document id, so analyze requests skip the database lookup for
+// files that were certainly never stored. Filled from one bulk read at start-up and rebuilt
+// every `rebuildInterval`, which also forgets deleted documents; ids stored in between are
+// added as they are written here or announced by other instances, so it is only run where
+// every document write is announced. Until the first load finishes every id counts as possibly stored.
+class DocumentFilter {
+public:
+    struct Options {
+        bool enabled = true;
+        std::size_t capacity = 1'000'000;
+        double falsePositiveRate = 0.01;
+        std::chrono::seconds rebuildInterval { 3600 };
+        std::chrono::seconds retryInterval { 30 };
+
+        static const Options& defaults();
+    };
+
+    // All stored document ids, or nothing if they could not be read.
+    using Loader = std::function<boost::asio::awaitable<std::optional<std::vector<std::string>>>()>;
+
+    explicit DocumentFilter(Options options = Options::defaults());
+
+    // False only if `documentId` is surely not stored.
+    bool mightContain(std::string_view documentId) const;
+    void add(std::string_view documentId);
+    bool ready() const;
+
+    boost::asio::awaitable<void> run(Loader load);
+    // One bulk load; ids added while it runs are kept. False if the loader failed.
+    boost::asio::awaitable<bool> rebuild(const Loader& load);
+
+private:
+    Options options_;
+
+    mutable std::mutex mutex_;
+    std::unique_ptr<util::BloomFilter> filter_;
+    bool rebuilding_ = false;
+    std::vector<std::string> addedDuringRebuild_;
+
+    util::metrics::Counter& skipped_;
+};
+
+}   // namespace Cache
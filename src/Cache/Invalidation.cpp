@@ -0,0 +1,145 @@
+#include "Invalidation.hpp"
+
+#include "Util/ConfigParser.hpp"
+
+#include <boost/asio/post.hpp>
+
+#include <pqxx/pqxx>
+
+#include <format>
+#include <iostream>
+#include <print>
+#include <random>
+#include <thread>
+
+namespace {
+
+using Cache::Invalidation;
+
+constexpr std::string_view kindName(Invalidation::Kind kind) {
+    switch (kind) {
+    case Invalidation::Kind::Session:
+        return "session";
+    case Invalidation::Kind::Document:
+        return "document";
+    case Invalidation::Kind::Tokens:
+        return "tokens";
+    }
+    return "unknown";
+}
+
+std::optional<Invalidation::Kind> kindFromName(std::string_view name) {
+    for (auto kind : { Invalidation::Kind::Session, Invalidation::Kind::Document, Invalidation::Kind::Tokens }) {
+        if (kindName(kind) == name) {
+            return kind;
+        }
+    }
+    return std::nullopt;
+}
+
+// Seconds between checks of the stop flag while no notification arrives.
+constexpr long WAIT_SECONDS = 1;
+
+}   // namespace
+
+namespace Cache {
+
+const std::string& nodeId() {
+    static const std::string id = [] {
+        std::random_device random;
+        return std::format("{:08x}{:08x}", random(), random());
+    }();
+    return id;
+}
+
+std::string encodeInvalidation(const Invalidation& invalidation, std::string_view node) {
+    return std::format("{} {} {}", node, kindName(invalidation.kind), invalidation.key);
+}
+
+std::optional<ReceivedInvalidation> decodeInvalidation(std::string_view payload) {
+    auto first = payload.find(' ');
+    if (first == std::string_view::npos) {
+        return std::nullopt;
+    }
+    auto second = payload.find(' ', first + 1);
+    if (second == std::string_view::npos || second + 1 == payload.size()) {
+        return std::nullopt;
+    }
+
+    auto kind = kindFromName(payload.substr(first + 1, second - first - 1));
+    if (!kind || first == 0) {
+        return std::nullopt;
+    }
+    return ReceivedInvalidation {
+        .node = std::string(payload.substr(0, first)),
+        .invalidation = { .kind = *kind, .key = std::string(payload.substr(second + 1)) },
+    };
+}
+
+const InvalidationListener::Options& InvalidationListener::Options::defaults() {
+    static const Options options = [] {
+        Util::ConfigParser config;
+        Options result;
+        result.reconnectDelay = std::chrono::milliseconds(static_cast<std::int64_t>(
+            config.number("CACHE_INVALIDATION_RECONNECT_MS", result.reconnectDelay.count())));
+        return result;
+    }();
+    return options;
+}
+
+InvalidationListener::InvalidationListener(
+    std::string connectionString, boost::asio::any_io_executor executor, Handler handler, Options options)
+  : connectionString_(std::move(connectionString)), executor_(std::move(executor)), handler_(std::move(handler)),
+    options_(options) {}
+
+InvalidationListener::~InvalidationListener() {
+    stopping_ = true;
+    thread_.join();
+}
+
+void InvalidationListener::start() {
+    boost::asio::post(thread_, [this] { listen(); });
+}
+
+void InvalidationListener::deliver(std::string_view payload) {
+    auto received = decodeInvalidation(payload);
+    if (!received) {
+        std::println(std::cerr, "Ignoring cache invalidation '{}'", payload);
+        return;
+    }
+    if (received->node == nodeId()) {
+        return;
+    }
+    boost::asio::post(executor_, [handler = handler_, invalidation = std::move(received->invalidation)] {
+        handler(invalidation);
+    });
+}
+
+void InvalidationListener::listen() {
+    class Receiver : public pqxx::notification_receiver {
+    public:
+        Receiver(pqxx::connection& connection, InvalidationListener& listener)
+          : pqxx::notification_receiver(connection, std::string(INVALIDATION_CHANNEL)), listener_(listener) {}
+
+        void operator()(const std::string& payload, int) override { listener_.deliver(payload); }
+
+    private:
+        InvalidationListener& listener_;
+    };
+
+    while (!stopping_) {
+        try {
+            pqxx::connection connection { connectionString_ };
+            Receiver receiver { connection, *this };
+            std::println("Listening for cache invalidations as node {}", nodeId());
+            while (!stopping_) {
+                connection.await_notification(WAIT_SECONDS, 0);
+            }
+        } catch (const std::exception& e) {
+            std::println(std::cerr, "Cache invalidation listener failed: {}", e.what());
+            std::this_thread::sleep_for(options_.reconnectDelay);
+        }
+    }
+}
+
+}   // namespace Cache
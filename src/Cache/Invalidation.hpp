@@ -0,0 +1,80 @@
+#pragma once
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/thread_pool.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace Cache {
+
+// PostgreSQL channel that carries cache invalidations between instances.
+inline constexpr std::string_view INVALIDATION_CHANNEL = "cache_invalidation";
+
+// One row changed on some instance: the others drop whatever they cached for `key`.
+struct Invalidation {
+    enum class Kind {
+        Session,    // key: session hash
+        Document,   // key: document external id, stored or deleted
+        Tokens      // key: user id
+    };
+
+    Kind kind;
+    std::string key;
+};
+
+// Random id of this process, written into every payload so an instance skips its own events.
+const std::string& nodeId();
+
+// NOTIFY payload: "<node> <kind> <key>".
+std::string encodeInvalidation(const Invalidation& invalidation, std::string_view node = nodeId());
+
+struct ReceivedInvalidation {
+    std::string node;
+    Invalidation invalidation;
+};
+
+std::optional<ReceivedInvalidation> decodeInvalidation(std::string_view payload);
+
+// LISTENs on INVALIDATION_CHANNEL over its own libpqxx connection and hands every event from
+// another instance to `handler` on `executor`. The connection blocks while it waits, so it
+// lives on a thread of its own. After a dropped connection it reconnects; events sent in
+// between are lost, which the caches' TTLs still cover.
+class InvalidationListener {
+public:
+    struct Options {
+        std::chrono::milliseconds reconnectDelay { 1000 };
+
+        static const Options& defaults();
+    };
+
+    using Handler = std::function<void(const Invalidation&)>;
+
+    InvalidationListener(std::string connectionString, boost::asio::any_io_executor executor, Handler handler,
+                         Options options = Options::defaults());
+    InvalidationListener(const InvalidationListener&) = delete;
+    InvalidationListener& operator=(const InvalidationListener&) = delete;
+    ~InvalidationListener();
+
+    void start();
+
+    // A payload as it arrives from the channel; exposed so the routing can be tested without a database.
+    void deliver(std::string_view payload);
+
+private:
+    void listen();
+
+    std::string connectionString_;
+    boost::asio::any_io_executor executor_;
+    Handler handler_;
+    Options options_;
+
+    std::atomic<bool> stopping_ { false };
+    boost::asio::thread_pool thread_ { 1 };
+};
+
+}   // namespace Cache
@@ -0,0 +1,241 @@
+#include "ResponseCache.hpp"
+
+#include "Util/ConfigParser.hpp"
+
+namespace http = boost::beast::http;
+
+namespace Cache {
+
+const ResponseCache::Options& ResponseCache::Options::defaults() {
+    static const Options options = [] {
+        Util::ConfigParser config;
+        Options result;
+        result.ttl = std::chrono::seconds(
+            static_cast<std::int64_t>(config.number("CLASSROOM_CACHE_TTL_SEC", result.ttl.count())));
+        result.staleWindow = std::chrono::seconds(
+            static_cast<std::int64_t>(config.number("CLASSROOM_CACHE_STALE_SEC", result.staleWindow.count())));
+        result.maxBytesPerUser =
+            static_cast<std::size_t>(config.number("CLASSROOM_CACHE_USER_BYTES", result.maxBytesPerUser));
+        result.maxUsers = static_cast<std::size_t>(config.number("CLASSROOM_CACHE_MAX_USERS", result.maxUsers));
+        result.maxBytes = static_cast<std::size_t>(config.number("CLASSROOM_CACHE_MAX_BYTES", result.maxBytes));
+        return result;
+    }();
+    return options;
+}
+
+ResponseCache::ResponseCache(Options options) : options_(options) {}
+
+ResponseCache::Users::iterator ResponseCache::touchUser(std::string_view userId) {
+    if (auto it = userIndex_.find(userId); it != userIndex_.end()) {
+        users_.splice(users_.begin(), users_, it->second);
+        return it->second;
+    }
+
+    users_.emplace_front();
+    users_.front().userId = std::string(userId);
+    userIndex_.emplace(users_.front().userId, users_.begin());
+
+    while (users_.size() > options_.maxUsers) {
+        eraseUser(std::prev(users_.end()));
+    }
+    return users_.begin();
+}
+
+ResponseCache::Entry* ResponseCache::findEntry(std::string_view userId, std::string_view key) {
+    auto user = userIndex_.find(userId);
+    if (user == userIndex_.end()) {
+        return nullptr;
+    }
+    auto entry = user->second->index.find(key);
+    return entry == user->second->index.end() ? nullptr : &*entry->second;
+}
+
+std::optional<ResponseCache::Hit> ResponseCache::find(std::string_view userId, std::string_view key,
+                                                      Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+
+    auto user = userIndex_.find(userId);
+    if (user == userIndex_.end()) {
+        return std::nullopt;
+    }
+    auto entry = user->second->index.find(key);
+    if (entry == user->second->index.end()) {
+        return std::nullopt;
+    }
+
+    users_.splice(users_.begin(), users_, user->second);
+    auto& entries = user->second->entries;
+    entries.splice(entries.begin(), entries, entry->second);
+
+    const auto age = now - entry->second->response->storedAt;
+    auto freshness = age < options_.ttl                         ? Freshness::Fresh
+                     : age < options_.ttl + options_.staleWindow ? Freshness::Stale
+                                                                 : Freshness::Expired;
+    return Hit { entry->second->response, freshness };
+}
+
+std::uint64_t ResponseCache::generation() const {
+    std::lock_guard lock(mutex_);
+    return generation_;
+}
+
+void ResponseCache::store(std::string_view userId, std::string_view key, CachedResponse response,
+                          std::optional<std::uint64_t> fetchedAt) {
+    if (response.bytes() > options_.maxBytesPerUser) {
+        return;
+    }
+
+    std::lock_guard lock(mutex_);
+    if (fetchedAt) {
+        if (*fetchedAt < forgottenBefore_) {
+            return;
+        }
+        if (auto it = evicted_.find(std::string(userId)); it != evicted_.end() && it->second > *fetchedAt) {
+            return;
+        }
+    }
+    auto& user = *touchUser(userId);
+
+    if (auto it = user.index.find(key); it != user.index.end()) {
+        user.bytes -= it->second->response->bytes();
+        totalBytes_ -= it->second->response->bytes();
+        user.entries.erase(it->second);
+        user.index.erase(it);
+    }
+
+    user.bytes += response.bytes();
+    totalBytes_ += response.bytes();
+    user.entries.push_front(Entry { std::string(key), std::make_shared<const CachedResponse>(std::move(response)) });
+    user.index.emplace(user.entries.front().key, user.entries.begin());
+
+    trim(user);
+    trimTotal();
+}
+
+void ResponseCache::trim(UserCache& user) {
+    while (user.bytes > options_.maxBytesPerUser && !user.entries.empty()) {
+        dropOldest(user);
+    }
+}
+
+void ResponseCache::trimTotal() {
+    while (totalBytes_ > options_.maxBytes && !users_.empty()) {
+        auto user = std::prev(users_.end());
+        if (user->entries.empty()) {
+            eraseUser(user);
+        } else {
+            dropOldest(*user);
+        }
+    }
+}
+
+void ResponseCache::dropOldest(UserCache& user) {
+    auto& oldest = user.entries.back();
+    user.bytes -= oldest.response->bytes();
+    totalBytes_ -= oldest.response->bytes();
+    user.index.erase(oldest.key);
+    user.entries.pop_back();
+}
+
+void ResponseCache::eraseUser(Users::iterator user) {
+    totalBytes_ -= user->bytes;
+    userIndex_.erase(user->userId);
+    users_.erase(user);
+}
+
+void ResponseCache::refresh(std::string_view userId, std::string_view key, Clock::time_point now) {
+    refresh(userId, key, {}, {}, now);
+}
+
+void ResponseCache::refresh(std::string_view userId, std::string_view key, std::string_view etag,
+                            std::string_view lastModified, Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+    auto user = userIndex_.find(userId);
+    if (user == userIndex_.end()) {
+        return;
+    }
+    auto entry = user->second->index.find(key);
+    if (entry == user->second->index.end()) {
+        return;
+    }
+
+    auto renewed = std::make_shared<CachedResponse>(*entry->second->response);
+    renewed->storedAt = now;
+    if (!etag.empty()) {
+        renewed->etag = std::string(etag);
+    }
+    if (!lastModified.empty()) {
+        renewed->lastModified = std::string(lastModified);
+    }
+
+    user->second->bytes += renewed->bytes();
+    user->second->bytes -= entry->second->response->bytes();
+    totalBytes_ += renewed->bytes();
+    totalBytes_ -= entry->second->response->bytes();
+    entry->second->response = std::move(renewed);
+}
+
+bool ResponseCache::beginRevalidation(std::string_view userId, std::string_view key) {
+    std::lock_guard lock(mutex_);
+    auto* entry = findEntry(userId, key);
+    if (entry == nullptr || entry->revalidating) {
+        return false;
+    }
+    entry->revalidating = true;
+    return true;
+}
+
+void ResponseCache::endRevalidation(std::string_view userId, std::string_view key) {
+    std::lock_guard lock(mutex_);
+    if (auto* entry = findEntry(userId, key); entry != nullptr) {
+        entry->revalidating = false;
+    }
+}
+
+void ResponseCache::evictUser(std::string_view userId) {
+    std::lock_guard lock(mutex_);
+
+    if (evicted_.size() >= options_.maxUsers) {
+        evicted_.clear();
+        forgottenBefore_ = generation_ + 1;
+    }
+    evicted_[std::string(userId)] = ++generation_;
+    if (auto it = userIndex_.find(userId); it != userIndex_.end()) {
+        eraseUser(it->second);
+    }
+}
+
+std::size_t ResponseCache::userBytes(std::string_view userId) const {
+    std::lock_guard lock(mutex_);
+    auto it = userIndex_.find(userId);
+    return it == userIndex_.end() ? 0 : it->second->bytes;
+}
+
+std::size_t ResponseCache::totalBytes() const {
+    std::lock_guard lock(mutex_);
+    return totalBytes_;
+}
+
+CachedResponse toCachedResponse(const http::response<http::string_body>& res) {
+    return CachedResponse {
+        .body = res.body(),
+        .contentType = std::string(res[http::field::content_type]),
+        .etag = std::string(res[http::field::etag]),
+        .lastModified = std::string(res[http::field::last_modified]),
+        .storedAt = std::chrono::steady_clock::now(),
+    };
+}
+
+http::response<http::string_body> toResponse(const CachedResponse& cached, unsigned version,
+                                             std::string_view cacheStatus) {
+    http::response<http::string_body> res { http::status::ok, version };
+    res.body() = cached.body;
+    if (!cached.contentType.empty()) {
+        res.set(http::field::content_type, cached.contentType);
+    }
+    res.set("X-Cache", std::string(cacheStatus));
+    res.prepare_payload();
+    return res;
+}
+
+}   // namespace Cache
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <boost/beast/http.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Cache {
+
+// A cached upstream response together with the validators needed to revalidate it.
+struct CachedResponse {
+    std::string body;
+    std::string contentType;
+    std::string etag;
+    std::string lastModified;
+    std::chrono::steady_clock::time_point storedAt;
+
+    std::size_t bytes() const { return body.size() + contentType.size() + etag.size() + lastModified.size(); }
+};
+
+// Per-user, size-bounded cache of GET responses. Within `ttl` an entry is fresh; up to
+// `ttl + staleWindow` it may be served while one background revalidation runs; after that it
+// is only kept for its validators so the next request can be a conditional one. Besides the
+// per-user limit, all users together stay within `maxBytes`: past it, the oldest entries of the
+// least recently used users go first.
+class ResponseCache {
+public:
+    enum class Freshness {
+        Fresh,
+        Stale,
+        Expired
+    };
+
+    struct Options {
+        std::chrono::seconds ttl { 30 };
+        std::chrono::seconds staleWindow { 300 };
+        std::size_t maxBytesPerUser = 4 * 1024 * 1024;
+        std::size_t maxUsers = 1024;
+        std::size_t maxBytes = 128 * 1024 * 1024;
+
+        static const Options& defaults();
+    };
+
+    struct Hit {
+        std::shared_ptr<const CachedResponse> response;
+        Freshness freshness;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    explicit ResponseCache(Options options = Options::defaults());
+
+    std::optional<Hit> find(std::string_view userId, std::string_view key, Clock::time_point now = Clock::now());
+
+    // Taken before fetching what is then passed to store(), so a response that was still in flight
+    // when the user was evicted (logout) does not put their data back.
+    std::uint64_t generation() const;
+
+    void store(std::string_view userId, std::string_view key, CachedResponse response,
+               std::optional<std::uint64_t> fetchedAt = std::nullopt);
+    // A 304 confirmed the entry: it becomes fresh again without touching the body. Validators the
+    // 304 carries replace the stored ones, so the next conditional request uses the current ETag.
+    void refresh(std::string_view userId, std::string_view key, Clock::time_point now = Clock::now());
+    void refresh(std::string_view userId, std::string_view key, std::string_view etag, std::string_view lastModified,
+                 Clock::time_point now = Clock::now());
+
+    // Only one background revalidation per entry at a time.
+    bool beginRevalidation(std::string_view userId, std::string_view key);
+    void endRevalidation(std::string_view userId, std::string_view key);
+
+    void evictUser(std::string_view userId);
+
+    std::size_t userBytes(std::string_view userId) const;
+    std::size_t totalBytes() const;
+
+private:
+    struct Entry {
+        std::string key;
+        std::shared_ptr<const CachedResponse> response;
+        bool revalidating = false;
+    };
+
+    struct UserCache {
+        std::string userId;
+        std::list<Entry> entries;
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+        std::size_t bytes = 0;
+    };
+
+    using Users = std::list<UserCache>;
+
+    Users::iterator touchUser(std::string_view userId);
+    Entry* findEntry(std::string_view userId, std::string_view key);
+    void trim(UserCache& user);
+    void trimTotal();
+    void dropOldest(UserCache& user);
+    void eraseUser(Users::iterator user);
+
+    Options options_;
+
+    mutable std::mutex mutex_;
+    Users users_;
+    std::unordered_map<std::string_view, Users::iterator> userIndex_;
+    std::size_t totalBytes_ = 0;
+
+    // Generation of each user's last eviction. When the map outgrows maxUsers it is cleared and
+    // every fetch started before that point is refused instead.
+    std::uint64_t generation_ = 0;
+    std::uint64_t forgottenBefore_ = 0;
+    std::unordered_map<std::string, std::uint64_t> evicted_;
+};
+
+CachedResponse toCachedResponse(const boost::beast::http::response<boost::beast::http::string_body>& res);
+
+boost::beast::http::response<boost::beast::http::string_body> toResponse(
+    const CachedResponse& cached, unsigned version, std::string_view cacheStatus);
+
+}   // namespace Cache
@@ -0,0 +1,140 @@
+#include "SessionCache.hpp"
+
+#include "Util/ConfigParser.hpp"
+#include "Util/TimeFunc.hpp"
+
+#include <algorithm>
+#include <functional>
+
+namespace Cache {
+
+const SessionCache::Options& SessionCache::Options::defaults() {
+    static const Options options = [] {
+        Util::ConfigParser config;
+        Options result;
+        result.maxEntries = static_cast<std::size_t>(config.number("SESSION_CACHE_MAX_ENTRIES", result.maxEntries));
+        result.maxMissing = static_cast<std::size_t>(config.number("SESSION_CACHE_MAX_MISSING", result.maxMissing));
+        result.ttl = std::chrono::seconds(
+            static_cast<std::int64_t>(config.number("SESSION_CACHE_TTL_SEC", result.ttl.count())));
+        result.negativeTtl = std::chrono::seconds(
+            static_cast<std::int64_t>(config.number("SESSION_CACHE_NEGATIVE_TTL_SEC", result.negativeTtl.count())));
+        return result;
+    }();
+    return options;
+}
+
+SessionCache::SessionCache(Options options)
+  : options_(options),
+    maxPerShard_(std::max<std::size_t>(1, options.maxEntries / std::max<std::size_t>(1, options.shards))),
+    maxMissingPerShard_(std::max<std::size_t>(1, options.maxMissing / std::max<std::size_t>(1, options.shards))),
+    hits_(util::metrics::Registry::instance().counter(
+        "anty_session_cache_hits_total", "Session lookups answered from the cache")),
+    negativeHits_(util::metrics::Registry::instance().counter(
+        "anty_session_cache_negative_hits_total", "Lookups of unknown session hashes answered from the cache")),
+    misses_(util::metrics::Registry::instance().counter(
+        "anty_session_cache_misses_total", "Session lookups that went to the database")) {
+    shards_.reserve(std::max<std::size_t>(1, options_.shards));
+    for (std::size_t i = 0; i < std::max<std::size_t>(1, options_.shards); ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+}
+
+SessionCache::Shard& SessionCache::shardFor(std::string_view sessionHash) {
+    return *shards_[std::hash<std::string_view> {}(sessionHash) % shards_.size()];
+}
+
+std::optional<SessionCache::Hit> SessionCache::find(std::string_view sessionHash, Clock::time_point now) {
+    auto& shard = shardFor(sessionHash);
+    std::lock_guard lock(shard.mutex);
+
+    auto it = shard.entries.find(std::string(sessionHash));
+    if (it == shard.entries.end() || it->second.validUntil <= now) {
+        if (it != shard.entries.end()) {
+            erase(shard, it);
+        }
+        misses_.inc();
+        return std::nullopt;
+    }
+
+    (it->second.session ? hits_ : negativeHits_).inc();
+    return Hit { it->second.session };
+}
+
+void SessionCache::store(std::string_view sessionHash, const Network::AppSession& session, Clock::time_point now) {
+    auto validUntil = now + options_.ttl;
+    if (auto expiresAt = util::time::parseTimestamp(session.expiresAt)) {
+        validUntil = std::min<Clock::time_point>(validUntil, *expiresAt);
+    }
+    if (validUntil <= now) {
+        return;
+    }
+
+    auto& shard = shardFor(sessionHash);
+    std::lock_guard lock(shard.mutex);
+
+    // A live negative entry means the session was revoked (or unknown) after this lookup began.
+    if (auto it = shard.entries.find(std::string(sessionHash));
+        it != shard.entries.end() && !it->second.session && it->second.validUntil > now) {
+        return;
+    }
+    put(shard, sessionHash, { session, validUntil });
+}
+
+void SessionCache::storeMissing(std::string_view sessionHash, Clock::time_point now) {
+    auto& shard = shardFor(sessionHash);
+    std::lock_guard lock(shard.mutex);
+    put(shard, sessionHash, { std::nullopt, now + options_.negativeTtl, true });
+}
+
+void SessionCache::revoke(std::string_view sessionHash, Clock::time_point now) {
+    auto& shard = shardFor(sessionHash);
+    std::lock_guard lock(shard.mutex);
+    put(shard, sessionHash, { std::nullopt, now + options_.ttl });
+}
+
+void SessionCache::forget(std::string_view sessionHash) {
+    auto& shard = shardFor(sessionHash);
+    std::lock_guard lock(shard.mutex);
+    if (auto it = shard.entries.find(std::string(sessionHash)); it != shard.entries.end()) {
+        erase(shard, it);
+    }
+}
+
+void SessionCache::put(Shard& shard, std::string_view sessionHash, Entry entry) {
+    auto key = std::string(sessionHash);
+    if (auto it = shard.entries.find(key); it != shard.entries.end()) {
+        erase(shard, it);
+    }
+
+    if (entry.missing && shard.missing.size() >= maxMissingPerShard_) {
+        evictOldest(shard, shard.missing);
+    }
+    if (shard.entries.size() >= maxPerShard_) {
+        evictOldest(shard, shard.missing.empty() ? shard.order : shard.missing);
+    }
+
+    auto& keys = entry.missing ? shard.missing : shard.order;
+    entry.position = keys.insert(keys.end(), key);
+    shard.entries.emplace(std::move(key), std::move(entry));
+}
+
+void SessionCache::erase(Shard& shard, std::unordered_map<std::string, Entry>::iterator it) {
+    (it->second.missing ? shard.missing : shard.order).erase(it->second.position);
+    shard.entries.erase(it);
+}
+
+void SessionCache::evictOldest(Shard& shard, std::list<std::string>& keys) {
+    shard.entries.erase(keys.front());
+    keys.pop_front();
+}
+
+std::size_t SessionCache::size() const {
+    std::size_t total = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard lock(shard->mutex);
+        total += shard->entries.size();
+    }
+    return total;
+}
+
+}   // namespace Cache
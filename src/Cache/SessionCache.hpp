@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Session/DataBaseSession.hpp"
+#include "Util/Metrics.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Cache {
+
+// Session hash -> active AppSession, so authenticated requests skip the database lookup.
+// Entries live until the session's expiresAt or `ttl`, whichever comes first; the short TTL
+// bounds how long a revocation made by another instance can go unnoticed when no
+// InvalidationListener reports it sooner. Unknown hashes are
+// remembered for `negativeTtl` so floods of bogus cookies do not reach the database; they are
+// capped at `maxMissing` and evicted first, so such a flood cannot push out live sessions. The
+// map is split into shards, each with its own lock, and evicts its oldest entries first.
+class SessionCache {
+public:
+    struct Options {
+        std::size_t shards = 16;
+        std::size_t maxEntries = 65536;
+        std::size_t maxMissing = 16384;
+        std::chrono::seconds ttl { 30 };
+        std::chrono::seconds negativeTtl { 5 };
+
+        static const Options& defaults();
+    };
+
+    // `session` is empty for a hash known not to belong to an active session.
+    struct Hit {
+        std::optional<Network::AppSession> session;
+    };
+
+    using Clock = std::chrono::system_clock;
+
+    explicit SessionCache(Options options = Options::defaults());
+
+    std::optional<Hit> find(std::string_view sessionHash, Clock::time_point now = Clock::now());
+
+    void store(std::string_view sessionHash, const Network::AppSession& session, Clock::time_point now = Clock::now());
+    void storeMissing(std::string_view sessionHash, Clock::time_point now = Clock::now());
+
+    // Logout: the hash reads as unknown at once, and a lookup that raced the revocation
+    // cannot put the session back.
+    void revoke(std::string_view sessionHash, Clock::time_point now = Clock::now());
+    // Login: drop anything remembered about a hash that now names a fresh session.
+    void forget(std::string_view sessionHash);
+
+    std::size_t size() const;
+
+private:
+    struct Entry {
+        std::optional<Network::AppSession> session;
+        Clock::time_point validUntil;
+        // Unknown hash from storeMissing(), kept in Shard::missing rather than Shard::order.
+        bool missing = false;
+        std::list<std::string>::iterator position;
+    };
+
+    // Keys in insertion order; with a fixed TTL per kind, the front is also the first to expire.
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+        std::list<std::string> order;
+        std::list<std::string> missing;
+    };
+
+    Shard& shardFor(std::string_view sessionHash);
+    void put(Shard& shard, std::string_view sessionHash, Entry entry);
+    static void erase(Shard& shard, std::unordered_map<std::string, Entry>::iterator it);
+    static void evictOldest(Shard& shard, std::list<std::string>& keys);
+
+    Options options_;
+    std::size_t maxPerShard_;
+    std::size_t maxMissingPerShard_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    util::metrics::Counter& hits_;
+    util::metrics::Counter& negativeHits_;
+    util::metrics::Counter& misses_;
+};
+
+}   // namespace Cache
@@ -33,19 +33,7 @@ inline Document tag_invoke(value_to_tag<Document>, value const& jv) {
 
     std::vector<Documents::Paragraph> text;
 
-    if (auto const* sections = obj.if_contains("document_sections")) {
-        auto const& sections_array = sections->as_array();
-        text.reserve(sections_array.size());
-
-        for (auto const& section_value : sections_array) {
-            auto const& section = section_value.as_object();
-
-            text.emplace_back(
-                std::string(section.at("title").as_string()),
-                std::string(section.at("content").as_string())
-            );
-        }
-    } else if (auto const* text_value = obj.if_contains("text")) {
+    if (auto const* text_value = obj.if_contains("text")) {
         auto const& text_array = text_value->as_array();
         text.reserve(text_array.size());
 
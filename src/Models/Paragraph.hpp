@@ -1,7 +1,12 @@
 #pragma once
+#include "Util/Compression.hpp"
+
 #include <string>
 #include <boost/json.hpp>
 
+#include <optional>
+#include <stdexcept>
+
 namespace Documents {
 
 struct Paragraph {
@@ -15,4 +20,35 @@ inline void tag_invoke(boost::json::value_from_tag, boost::json::value& jv, Para
         {"text", par.text},
     };
 }
-}
\ No newline at end of file
+
+// How a section's text sits in document_sections: short or incompressible text as `content`,
+// the rest as a zstd frame in `content_zstd` (util::ZstdCodec::sections()), exactly one set.
+struct StoredContent {
+    std::optional<std::string> content;
+    std::optional<std::string> compressed;
+};
+
+inline constexpr std::size_t MAX_SECTION_BYTES = 64 * 1024 * 1024;
+
+inline StoredContent storeContent(std::string_view text) {
+    if (auto frame = util::ZstdCodec::sections().compress(text)) {
+        return { std::nullopt, std::move(frame) };
+    }
+    return { std::string(text), std::nullopt };
+}
+
+// Throws if the frame is corrupt or was written with a dictionary this codec does not hold.
+inline std::string loadContent(std::optional<std::string_view> content, std::optional<std::string_view> compressed) {
+    if (content) {
+        return std::string(*content);
+    }
+    if (!compressed) {
+        return {};
+    }
+    auto text = util::ZstdCodec::sections().decompress(*compressed, MAX_SECTION_BYTES);
+    if (!text) {
+        throw std::runtime_error("document section does not decompress with any configured zstd dictionary");
+    }
+    return std::move(*text);
+}
+}
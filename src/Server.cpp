@@ -3,8 +3,14 @@
 #include "Auth/GoogleOAuthClient.hpp"
 #include "DocumentReader/DocReader.hpp"
 #include "Models/Document.hpp"
+#include "Session/CircuitBreaker.hpp"
+#include "Session/ContentEncoding.hpp"
+#include "Session/HedgedRequest.hpp"
+#include "Session/RangeDownload.hpp"
 #include "Session/SimpleSession.hpp"
+#include "Util/Compression.hpp"
 #include "Util/Encrypt.hpp"
+#include "Util/Metrics.hpp"
 #include "Util/NetworkHealper.hpp"
 #include "Util/TimeFunc.hpp"
 
@@ -44,21 +50,124 @@ constexpr std::string_view GOOGLE_HOST = "www.googleapis.com";
 
 namespace X = boost::asio::experimental;
 
+namespace {
+boost::asio::awaitable<Network::http::response<Network::PooledBody>> downloadOnce(
+    Network::http::request<Network::http::string_body> req) {
+    co_return co_await Network::downloadRanged<Network::SslSession>(std::move(req), "443");
+}
+}
+
 namespace Network {
 Server::Server(
     asio::io_context& io,
     const std::string& address,
     const std::string& port)
-  : ioc_(io), address_(address), port_(port), databaseSession(std::make_shared<DataBaseSession>()) {}
+  : ioc_(io), address_(address), port_(port), databaseSession(makeDataBaseSession(Util::ConfigParser {})),
+    writeBehind_(io.get_executor()),
+    tokenRefresher_(io.get_executor(), [this](std::string userId) -> asio::awaitable<bool> {
+        Auth::GoogleTokenManager tokenManager{
+            ioc_.get_executor(),
+            databaseSession,
+            config
+        };
+        auto token = co_await tokenManager.refreshAhead(userId, Auth::TokenRefresher::Options::defaults().refreshAhead);
+        co_return token.has_value();
+    }) {
+    writeBehind_.registerKind("last_seen", [this](std::vector<WriteBehind::Entry> batch) -> asio::awaitable<bool> {
+        std::vector<SessionLastSeen> sessions;
+        sessions.reserve(batch.size());
+        for (auto& entry : batch) {
+            sessions.push_back({ .sessionHash = std::move(entry.key), .lastSeenAt = std::move(entry.value) });
+        }
+        co_return co_await databaseSession->updateAppSessionsLastSeen(sessions);
+    });
+
+    // Loads the section dictionaries now, so a missing one stops start-up instead of leaving
+    // every stored frame written with it unreadable.
+    util::ZstdCodec::sections();
+
+    if (auto databaseUrl = config["DATABASE_URL"]; !databaseUrl.empty()) {
+        invalidations_ = std::make_unique<Cache::InvalidationListener>(
+            std::string(databaseUrl), io.get_executor(), [this](const Cache::Invalidation& invalidation) {
+                invalidate(invalidation);
+            });
+    }
+}
+
+void Server::start() {
+    asio::co_spawn(ioc_, listen(), asio::detached);
+    asio::co_spawn(ioc_, writeBehind_.run(), asio::detached);
+    asio::co_spawn(ioc_, tokenRefresher_.run(), asio::detached);
+    // Without invalidations the filter would miss documents other instances store until its next
+    // rebuild, and send those off to be downloaded again. Unloaded, it lets every id through.
+    if (invalidations_ && databaseSession->notifiesDocumentWrites()) {
+        asio::co_spawn(
+            ioc_, documentFilter_.run([this] { return databaseSession->selectDocumentIds(); }), asio::detached);
+    }
+    asio::co_spawn(ioc_, warmUp(), asio::detached);
+    if (sessionTokens_.enabled()) {
+        asio::co_spawn(ioc_, revocations_.run([this]() -> asio::awaitable<std::optional<std::vector<std::string>>> {
+            auto now = util::time::getCurrentTimestamp();
+            co_return co_await databaseSession->selectRevokedSessionHashes(now);
+        }), asio::detached);
+    }
+    if (invalidations_) {
+        invalidations_->start();
+    }
+}
+
+void Server::invalidate(const Cache::Invalidation& invalidation) {
+    switch (invalidation.kind) {
+    case Cache::Invalidation::Kind::Session:
+        sessionCache_.revoke(invalidation.key);
+        revocations_.revoke(invalidation.key);
+        break;
+    case Cache::Invalidation::Kind::Tokens:
+        Auth::AccessTokenCache::instance().evict(invalidation.key);
+        break;
+    case Cache::Invalidation::Kind::Document:
+        // A deleted id stays in the filter until the next rebuild, which only costs a lookup.
+        documentFilter_.add(invalidation.key);
+        break;
+    }
+}
 
-void Server::start() { asio::co_spawn(ioc_, listen(), asio::detached); }
+asio::awaitable<void> Server::warmUp() {
+    if (!config.flag("WARMUP_ENABLED", true)) {
+        ready_ = true;
+        co_return;
+    }
+
+    const auto started = std::chrono::steady_clock::now();
+    const auto connections = static_cast<std::size_t>(config.number("WARMUP_CONNECTIONS", 2));
+
+    WarmUp warmUp;
+    warmUp.add("drive", [connections] { return preconnect(std::string(GOOGLE_HOST), "443", connections); });
+    warmUp.add("tls context", []() -> asio::awaitable<void> {
+        SslSession::clientContext();
+        co_return;
+    });
+    warmUp.add("document readers", [this]() -> asio::awaitable<void> {
+        co_await asio::post(tp.get_executor(), asio::use_awaitable);
+        primeDocumentReaders();
+    });
+    // Hot caches (e.g. the Classroom response cache) register their loaders here once they have any.
+
+    co_await warmUp.run();
+
+    ready_ = true;
+    std::println(std::cout, "Warm-up finished in {} ms",
+                 std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count());
+}
 
 const std::unordered_map<std::string, Server::RequesType> Server::changeReqToEnum = {
     { "/api/analyze", GetStudentAnalizis },
     { "/api/auth/google/start", AuthGoogleStart },
+    { "/readyz", Readyz },
     { "/api/auth/google/callback", AuthGoogleCallback },
     { "/api/auth/me", AuthMe },
-    { "/api/auth/logout", AuthLogout }
+    { "/api/auth/logout", AuthLogout },
+    { "/metrics", Metrics }
 };
 
 template <typename T>
@@ -82,6 +191,7 @@ void Server::applyCorsHeaders(http::response<http::string_body>& res) const {
     res.set("Access-Control-Allow-Credentials", "true");
     res.set(http::field::access_control_allow_methods, "GET, POST, OPTIONS");
     res.set(http::field::access_control_allow_headers, "Content-Type, Authorization");
+    res.set(http::field::access_control_expose_headers, "X-Cache, X-Skipped-Files");
 }
 
 asio::awaitable<void> Server::doSession(tcp_stream stream) {
@@ -98,7 +208,18 @@ asio::awaitable<void> Server::doSession(tcp_stream stream) {
 
             beast::get_lowest_layer(stream).expires_never();
 
-            http::response<http::string_body> res = co_await requestHandler(std::move(req));
+            const auto version = req.version();
+            http::response<http::string_body> res;
+            try {
+                res = co_await requestHandler(std::move(req));
+            } catch (const boost::system::system_error& e) {
+                std::println(std::cerr, "Upstream error: {}", e.what());
+                res = http::response<http::string_body> {
+                    e.code() == CircuitError::open ? http::status::service_unavailable : http::status::bad_gateway,
+                    version
+                };
+                res.prepare_payload();
+            }
 
             beast::get_lowest_layer(stream).expires_after(std::chrono::seconds(10));
             applyCorsHeaders(res);
@@ -187,10 +308,22 @@ asio::awaitable<http::response<http::string_body>> Server::requestHandler(http::
                 co_return co_await authMeHandler(req);
             }
             co_return http::response<http::string_body> { http::status::method_not_allowed, req.version() };
+        case Metrics:
+            if (req.method() == http::verb::get) {
+                co_return metricsHandler(req);
+            }
+            co_return http::response<http::string_body> { http::status::method_not_allowed, req.version() };
+        case Readyz:
+            if (req.method() == http::verb::get) {
+                co_return readyzHandler(req);
+            }
+            co_return http::response<http::string_body> { http::status::method_not_allowed, req.version() };
     }
 }
 
 asio::awaitable<http::response<http::string_body>> Server::analyzesHandler(http::request<http::string_body> req) {
+    // Bounds the whole analysis; the ML call gets whatever the downloads left of it.
+    const auto deadline = deadlineAfter("ANALYZE_DEADLINE_MS", std::chrono::minutes(15));
     std::vector<Document> doc_vec;
 
     auto [session, _] = co_await getSessionFromCookie(req);
@@ -204,6 +337,7 @@ asio::awaitable<http::response<http::string_body>> Server::analyzesHandler(http:
         config
     };
 
+    tokenRefresher_.touch(session->userId);
     auto accessToken = co_await tokenManager.getValidAccessToken(session->userId);
     if (accessToken == std::nullopt) {
         co_return http::response<http::string_body> {http::status::unauthorized, req.version()};
@@ -213,13 +347,32 @@ asio::awaitable<http::response<http::string_body>> Server::analyzesHandler(http:
 
     std::vector<DocumentRequest> req_vec;
 
-    for (auto&& item : json_data.at("filesList").as_array()) {
+    const auto& files_list = json_data.at("filesList").as_array();
+
+    std::vector<std::string> file_ids;
+    file_ids.reserve(files_list.size());
+    for (auto&& item : files_list) {
+        file_ids.emplace_back(item.at("file").at("file_id").as_string());
+    }
+
+    // One lookup for the whole request, then every file is either a hit or a download. Files
+    // the filter has never seen are downloaded without asking the database.
+    std::erase_if(file_ids, [this](const std::string& id) { return !documentFilter_.mightContain(id); });
+    std::vector<Document> cached;
+    if (!file_ids.empty()) {
+        cached = co_await databaseSession->selectDocumentsByIds(file_ids);
+    }
+    std::unordered_map<std::string_view, const Document*> hits;
+    for (const auto& document : cached) {
+        hits.emplace(document.docId, &document);
+    }
+
+    for (auto&& item : files_list) {
         const auto& file_obj = item.at("file");
         auto file_id = std::string(file_obj.at("file_id").as_string());
 
-        auto&& result = co_await databaseSession->selectDocumentById(file_id);
-        if (result.has_value()) {
-            doc_vec.push_back(result.value());
+        if (auto hit = hits.find(file_id); hit != hits.end()) {
+            doc_vec.push_back(*hit->second);
             continue;
         }
 
@@ -233,7 +386,7 @@ asio::awaitable<http::response<http::string_body>> Server::analyzesHandler(http:
         req_vec.push_back({ .req = g_req, .id = file_id, .file_type = file_type });
     }
 
-    auto res = co_await handle_document_request(req_vec, doc_vec, tp.get_executor());
+    auto res = co_await handle_document_request(req_vec, doc_vec, tp.get_executor(), deadline);
     co_return res;
 }
 asio::awaitable<http::response<http::string_body>>
@@ -247,15 +400,20 @@ Server::authGoogleStartHandler(http::request<http::string_body> req) {
         co_return res;
     }
 
-    auto randomToken = util::randomUrlSafeToken();
-    auto randomTokenHash = util::sha256Hex(randomToken);
-    auto expiresAt = util::time::getCurrentTimeAfterMinutes(5);
-
-    if (auto stateResult = co_await databaseSession->insertOAuthState(randomTokenHash, expiresAt); !stateResult) {
-        http::response<http::string_body> res{http::status::internal_server_error, req.version()};
-        res.body() = "Failed to create OAuth state";
-        res.prepare_payload();
-        co_return res;
+    std::string randomToken;
+    if (oauthStates_.enabled()) {
+        randomToken = oauthStates_.issue();
+    } else {
+        randomToken = util::randomUrlSafeToken();
+        auto randomTokenHash = util::sha256Hex(randomToken);
+        auto expiresAt = util::time::getCurrentTimeAfterMinutes(5);
+
+        if (auto stateResult = co_await databaseSession->insertOAuthState(randomTokenHash, expiresAt); !stateResult) {
+            http::response<http::string_body> res{http::status::internal_server_error, req.version()};
+            res.body() = "Failed to create OAuth state";
+            res.prepare_payload();
+            co_return res;
+        }
     }
 
     auto scope = googleOAuthScopes | std::views::join_with(" "sv) | std::ranges::to<std::string>();
@@ -305,11 +463,19 @@ Server::authGoogleCallbackHandler(http::request<http::string_body> req) {
 
     auto stateValue = (*state).value;
 
-    auto stateHash = util::sha256Hex(stateValue);
-    auto now = util::time::getCurrentTimestamp();
+    // Signed states are checked in memory; states stored before signing was enabled still
+    // go through oauth_states.
+    if (Auth::OAuthStates::isSigned(stateValue)) {
+        if (!oauthStates_.consume(stateValue)) {
+            co_return http::response<http::string_body> {http::status::unauthorized, req.version()};
+        }
+    } else {
+        auto stateHash = util::sha256Hex(stateValue);
+        auto now = util::time::getCurrentTimestamp();
 
-    if (auto ok = co_await databaseSession->consumeOAuthState(stateHash, now); ok == false) {
-        co_return http::response<http::string_body> {http::status::unauthorized, req.version()};
+        if (auto ok = co_await databaseSession->consumeOAuthState(stateHash, now); ok == false) {
+            co_return http::response<http::string_body> {http::status::unauthorized, req.version()};
+        }
     }
 
     GoogleUserInfo client;
@@ -400,6 +566,17 @@ Server::authGoogleCallbackHandler(http::request<http::string_body> req) {
     if (!resAppSession) {
         co_return http::response<http::string_body> {http::status::internal_server_error, req.version()};;
     }
+    sessionCache_.forget(sessionHash);
+
+    auto cookieToken = sessionId;
+    if (sessionTokens_.enabled()) {
+        cookieToken = sessionTokens_.issue({
+            .sessionId = sessionId,
+            .userId = authUser->id,
+            .expiresAt = util::time::parseTimestamp(sessionExpiresAt).value(),
+        });
+    }
+
     http::response<http::string_body> ress{http::status::found, req.version()};
     ress.set(http::field::location, config["APP_ORIGIN"]);
     ress.set(http::field::server, "AntyCopyRightCppServer");
@@ -410,7 +587,7 @@ Server::authGoogleCallbackHandler(http::request<http::string_body> req) {
     auto cookie_value = std::format(
         "{}={}; HttpOnly; Secure; SameSite=None; Path=/; Max-Age={}",
         cookieName,
-        sessionId,
+        cookieToken,
         sessionMaxAge
     );
     ress.set(http::field::set_cookie, cookie_value);
@@ -425,13 +602,7 @@ asio::awaitable<http::response<http::string_body>> Server::authMeHandler(http::r
         co_return http::response<http::string_body> {http::status::unauthorized, req.version()};
     }
 
-    auto now = util::time::getCurrentTimestamp();
-
-    auto sessionUpdate = co_await databaseSession->updateAppSessionLastSeen(sessionHash, now);
-
-    if (!sessionUpdate) {
-        std::println(std::cerr, "Failed to update app session last_seen_at");
-    }
+    writeBehind_.enqueue("last_seen", sessionHash, util::time::getCurrentTimestamp());
 
     auto user = co_await databaseSession->selectAuthUserById(session->userId);
     if (user == std::nullopt) {
@@ -467,10 +638,19 @@ asio::awaitable<http::response<http::string_body>> Server::authLogoutHandler(htt
         co_return http::response<http::string_body> {http::status::no_content, req.version()};
     }
 
-    auto sessionHash = util::sha256Hex(sessionId.value());
-    auto now = util::time::getCurrentTimestamp();
+    auto [session, sessionHash] = co_await getSessionFromCookie(req);
+    if (session) {
+        classroomCache_.evictUser(session->userId);
+    }
+
+    // Empty for a signed cookie that does not verify: there is no session to revoke.
+    if (!sessionHash.empty()) {
+        auto now = util::time::getCurrentTimestamp();
 
-    co_await databaseSession->revokeAppSession(sessionHash, now);
+        co_await databaseSession->revokeAppSession(sessionHash, now);
+        sessionCache_.revoke(sessionHash);
+        revocations_.revoke(sessionHash);
+    }
 
     http::response<http::string_body> res{http::status::no_content, req.version()};
     auto cookie_value = std::format(
@@ -482,6 +662,38 @@ asio::awaitable<http::response<http::string_body>> Server::authLogoutHandler(htt
     res.prepare_payload();
     co_return res;
 }
+http::response<http::string_body> Server::metricsHandler(const http::request<http::string_body>& req) const {
+    // Metrics name upstreams and traffic patterns, so they are only served to a scraper holding
+    // METRICS_TOKEN; without one configured the endpoint does not exist.
+    const auto token = config["METRICS_TOKEN"];
+    if (token.empty()) {
+        return http::response<http::string_body>{http::status::not_found, req.version()};
+    }
+    if (!util::constantTimeEquals(req[http::field::authorization], std::format("Bearer {}", token))) {
+        http::response<http::string_body> denied{http::status::unauthorized, req.version()};
+        denied.set(http::field::www_authenticate, "Bearer");
+        denied.prepare_payload();
+        return denied;
+    }
+
+    http::response<http::string_body> res{http::status::ok, req.version()};
+    res.body() = util::metrics::Registry::instance().render();
+    res.set(http::field::content_type, "text/plain; version=0.0.4");
+    res.set(http::field::cache_control, "no-store");
+    res.prepare_payload();
+    return res;
+}
+
+http::response<http::string_body> Server::readyzHandler(const http::request<http::string_body>& req) const {
+    const bool ready = ready_.load();
+    http::response<http::string_body> res{ready ? http::status::ok : http::status::service_unavailable, req.version()};
+    res.body() = ready ? "ready" : "warming up";
+    res.set(http::field::content_type, "text/plain");
+    res.set(http::field::cache_control, "no-store");
+    res.prepare_payload();
+    return res;
+}
+
 asio::awaitable<http::response<http::string_body>> Server::classroomProxyHandler(http::request<http::string_body> req, boost::url_view target) {
     if (req.method() != http::verb::get) {
         co_return http::response<http::string_body> {http::status::method_not_allowed, req.version()};
@@ -504,37 +716,84 @@ asio::awaitable<http::response<http::string_body>> Server::classroomProxyHandler
         newTarget += "?courseStates=ACTIVE";
     }
 
-    http::request<http::string_body> request{http::verb::get, newTarget, 11};
+    auto [session , _] = co_await getSessionFromCookie(req);
+    if (session == std::nullopt) {
+        co_return http::response<http::string_body> {http::status::unauthorized, req.version()};
+    }
+
+    auto hit = classroomCache_.find(session->userId, newTarget);
+    if (hit && hit->freshness != Cache::ResponseCache::Freshness::Expired) {
+        if (hit->freshness == Cache::ResponseCache::Freshness::Stale &&
+            classroomCache_.beginRevalidation(session->userId, newTarget)) {
+            asio::co_spawn(ioc_, revalidateClassroom(session->userId, newTarget, hit->response), asio::detached);
+        }
+        const bool fresh = hit->freshness == Cache::ResponseCache::Freshness::Fresh;
+        co_return Cache::toResponse(*hit->response, req.version(), fresh ? "HIT" : "STALE");
+    }
+
+    co_return co_await fetchClassroom(session->userId, newTarget, hit ? hit->response : nullptr);
+}
+
+asio::awaitable<http::response<http::string_body>> Server::fetchClassroom(
+    std::string userId, std::string target, std::shared_ptr<const Cache::CachedResponse> cached) {
+    const auto deadline = deadlineAfter("CLASSROOM_DEADLINE_MS", std::chrono::seconds(30));
     Auth::GoogleTokenManager tokenManager{
         ioc_.get_executor(),
         databaseSession,
         config
     };
 
-    auto [session , _] = co_await getSessionFromCookie(req);
-    if (session == std::nullopt) {
-        co_return http::response<http::string_body> {http::status::unauthorized, req.version()};
-    }
-
-    auto token = co_await tokenManager.getValidAccessToken(session->userId);
+    tokenRefresher_.touch(userId);
+    const auto generation = classroomCache_.generation();
+    auto token = co_await tokenManager.getValidAccessToken(userId);
     if (token == std::nullopt) {
-        co_return http::response<http::string_body> {http::status::unauthorized, req.version()};
+        co_return http::response<http::string_body> {http::status::unauthorized, 11};
     }
 
+    http::request<http::string_body> request{http::verb::get, target, 11};
     request.set(http::field::content_type, "application/json");
     request.set(http::field::authorization, "Bearer " + token.value());
     request.set(http::field::host, GOOGLE_CLASSROOM_HOST);
+    if (cached && !cached->etag.empty()) {
+        request.set(http::field::if_none_match, cached->etag);
+    }
+    if (cached && !cached->lastModified.empty()) {
+        request.set(http::field::if_modified_since, cached->lastModified);
+    }
     request.prepare_payload();
 
-    auto googleSession = std::make_shared<SslSession>(ioc_.get_executor());
-    auto googleResponse = co_await googleSession->sendRequest<http::string_body>(std::move(request));
+    auto googleResponse =
+        co_await sendHedged<SslSession, http::string_body>(ioc_.get_executor(), std::move(request), "443", deadline);
 
+    if (googleResponse.result() == http::status::not_modified && cached) {
+        classroomCache_.refresh(userId, target, std::string(googleResponse[http::field::etag]),
+                                std::string(googleResponse[http::field::last_modified]));
+        co_return Cache::toResponse(*cached, 11, "REVALIDATED");
+    }
+    if (googleResponse.result() == http::status::ok) {
+        classroomCache_.store(userId, target, Cache::toCachedResponse(googleResponse), generation);
+    }
+
+    googleResponse.set("X-Cache", "MISS");
     co_return googleResponse;
 }
 
+asio::awaitable<void> Server::revalidateClassroom(
+    std::string userId, std::string target, std::shared_ptr<const Cache::CachedResponse> cached) {
+    try {
+        co_await fetchClassroom(userId, target, std::move(cached));
+    } catch (const std::exception& e) {
+        std::println(std::cerr, "Classroom revalidation of {} failed: {}", target, e.what());
+    }
+    classroomCache_.endRevalidation(userId, target);
+}
+
 asio::awaitable<http::response<http::string_body>> Server::handle_document_request(
-    std::vector<DocumentRequest> vreq, std::span<Document> cache_docs, asio::any_io_executor cpu_ex) {
-    auto container = std::make_shared<std::vector<Document>>();
+    std::vector<DocumentRequest> vreq, std::span<Document> cache_docs, asio::any_io_executor cpu_ex,
+    Network::Deadline deadline) {
+    auto collected = std::make_shared<CollectedDocuments>();
+    // Comma-separated ids of files that could not be downloaded or read, sent as X-Skipped-Files.
+    std::string skipped;
 
     if (!vreq.empty()) {
         auto net_ex = co_await asio::this_coro::executor;
@@ -543,10 +802,16 @@ asio::awaitable<http::response<http::string_body>> Server::handle_document_reque
 
         auto make_op = [&](DocumentRequest document_request) {
             return asio::co_spawn(
-                net_ex, download_extract_store(std::move(document_request), cpu_ex, stor_strand, container),
+                net_ex, download_extract_store(std::move(document_request), cpu_ex, stor_strand, collected),
                 asio::deferred);
         };
 
+        std::vector<std::string> ids;
+        ids.reserve(vreq.size());
+        for (const auto& document_request : vreq) {
+            ids.push_back(document_request.id);
+        }
+
         auto first = make_op(std::move(vreq.front()));
 
         using Op = decltype(first);
@@ -564,66 +829,151 @@ asio::awaitable<http::response<http::string_body>> Server::handle_document_reque
 
         auto [order, errors] = co_await std::move(group).async_wait(X::wait_for_all(), asio::use_awaitable);
 
-        for (const auto& i : errors) {
-            if (i) {
-                std::rethrow_exception(i);
+        for (std::size_t i = 0; i < errors.size(); ++i) {
+            if (!errors[i]) {
+                continue;
+            }
+            try {
+                std::rethrow_exception(errors[i]);
+            } catch (const std::exception& e) {
+                std::println(std::cerr, "Skipping document {}: {}", ids[i], e.what());
             }
+            skipped += skipped.empty() ? ids[i] : "," + ids[i];
         }
+    }
 
-        for (auto&& doc : *container) {
-            co_await databaseSession->insertDocument(doc);
-        }
+    if (collected->documents.empty() && cache_docs.empty() && !skipped.empty()) {
+        http::response<http::string_body> res { http::status::bad_gateway, 11 };
+        res.set("X-Skipped-Files", skipped);
+        res.body() = "None of the files could be fetched";
+        res.prepare_payload();
+        co_return res;
     }
 
     http::request<http::string_body> request { http::verb::post, "/analysis", 11 };
 
     boost::json::array obj_array;
 
-    if (!cache_docs.empty()) {
-        std::ranges::copy(cache_docs, std::back_inserter(*container));
+    for (auto&& item : collected->documents) {
+        boost::json::value jv = boost::json::value_from(item);
+        obj_array.emplace_back(jv);
     }
-
-    for (auto&& item : *container) {
+    for (auto&& item : cache_docs) {
         boost::json::value jv = boost::json::value_from(item);
         obj_array.emplace_back(jv);
     }
 
     request.body() = boost::json::serialize(obj_array);
+
     request.set(http::field::content_type, "application/json");
     request.set(http::field::host, config["ML_SERVER_HOST"]);
     request.prepare_payload();
 
+    if (config.flag("ML_REQUEST_GZIP")) {
+        gzipRequestBody(request, static_cast<std::size_t>(config.number("ML_REQUEST_GZIP_MIN_BYTES", 64 * 1024)));
+    }
+
     auto session = std::make_shared<SimpleSession>(ioc_.get_executor());
+    // Analysis time grows with the submitted text, so quick runs must not shorten the wait for a thesis.
+    session->setResponseTimeout(
+        std::chrono::milliseconds(static_cast<std::int64_t>(config.number("ML_RESPONSE_TIMEOUT_MS", 600'000))));
+    session->setDeadline(deadline);
     auto res_message = co_await session->sendRequest<http::string_body>(request);
 
     http::response<http::string_body> res { http::status::ok, 11 };
+    if (!skipped.empty()) {
+        res.set("X-Skipped-Files", skipped);
+    }
     res.body() = res_message.body();
     co_return res;
 }
 
 asio::awaitable<void> Server::download_extract_store(
     DocumentRequest req, asio::any_io_executor cpu_ex, asio::strand<asio::any_io_executor> store_strand,
-    std::shared_ptr<std::vector<Document>> container) {
-    auto download_session = std::make_shared<SslSession>(ioc_.get_executor());
-    auto doc_req = co_await download_session->downloadWithRedirect(req.req);
+    std::shared_ptr<CollectedDocuments> collected) {
+    auto id = req.id;
+    auto document = co_await documentFlights_.run(id, [this, req = std::move(req), cpu_ex] {
+        return fetchDocument(req, cpu_ex);
+    });
+
+    co_await asio::post(store_strand, asio::use_awaitable);
+
+    collected->documents.push_back(std::move(document));
+}
+
+asio::awaitable<Document> Server::fetchDocument(DocumentRequest req, asio::any_io_executor cpu_ex) {
+    // Not hedged: a second full download of a large file costs more than the tail it would cut.
+    auto doc_req = co_await downloadOnce(req.req);
 
     std::println(std::cout, "Попытка скачать файл {}.", req.id);
 
     if (doc_req.result() != http::status::ok) {
-        auto temp = std::string(doc_req.body().begin(), doc_req.body().end());
-
         std::println(
             std::cerr, "ОШИБКА СКАЧИВАНИЯ {}: Код {}. Тело: {}", req.id, static_cast<unsigned>(doc_req.result()),
-            std::string(doc_req.body().begin(), doc_req.body().end()));
+            doc_req.body().view());
+        throw std::runtime_error(std::format(
+            "Download of {} failed with status {}", req.id, static_cast<unsigned>(doc_req.result())));
     }
 
+    auto net_ex = co_await asio::this_coro::executor;
     co_await asio::post(cpu_ex, asio::use_awaitable);
 
     auto doc_text = DocReader::DocumentReaderFromRaw(doc_req.body(), req.file_type);
+    if (!doc_text.has_value()) {
+        throw std::runtime_error(std::format("Unsupported file type {} for {}", req.file_type, req.id));
+    }
 
-    co_await asio::post(store_strand, asio::use_awaitable);
+    co_await asio::post(net_ex, asio::use_awaitable);
 
-    container->emplace_back(std::move(doc_text.value()), req.id);
+    Document document { std::move(doc_text.value()), req.id };
+    queueForStore(document);
+    co_return document;
+}
+
+void Server::queueForStore(Document document) {
+    {
+        std::lock_guard lock(storeMutex_);
+        storeQueue_.push_back(std::move(document));
+        if (std::exchange(storing_, true)) {
+            return;
+        }
+    }
+    asio::co_spawn(ioc_, storeQueued(), asio::detached);
+}
+
+asio::awaitable<void> Server::storeQueued() {
+    // Documents queued while a batch is written go into the next one.
+    for (;;) {
+        std::vector<Document> batch;
+        {
+            std::lock_guard lock(storeMutex_);
+            if (storeQueue_.empty()) {
+                storing_ = false;
+                co_return;
+            }
+            batch.swap(storeQueue_);
+        }
+        try {
+            co_await persistDocuments(std::move(batch));
+        } catch (const std::exception& e) {
+            std::println(std::cerr, "Failed to store documents: {}", e.what());
+        }
+    }
+}
+
+Network::Deadline Server::deadlineAfter(const std::string& key, std::chrono::milliseconds fallback) const {
+    return std::chrono::steady_clock::now() +
+           std::chrono::milliseconds(static_cast<std::int64_t>(config.number(key, fallback.count())));
+}
+
+asio::awaitable<void> Server::persistDocuments(std::vector<Document> documents) {
+    if (!co_await databaseSession->insertDocuments(documents)) {
+        std::println(std::cerr, "Failed to store {} documents; they will be downloaded again", documents.size());
+        co_return;
+    }
+    for (const auto& document : documents) {
+        documentFilter_.add(document.docId);
+    }
 }
 
 asio::awaitable<std::tuple<std::optional<AppSession>, std::string>> Server::getSessionFromCookie(http::request<http::string_body>& req) {
@@ -638,11 +988,49 @@ asio::awaitable<std::tuple<std::optional<AppSession>, std::string>> Server::getS
         co_return std::make_tuple(std::nullopt, "");
     }
 
-    const auto sessionHash = util::sha256Hex(sessionId.value());
+    std::string sessionHash;
+    if (Auth::SessionTokens::isSigned(*sessionId)) {
+        auto claims = sessionTokens_.verify(*sessionId);
+        if (!claims) {
+            co_return std::make_tuple(std::nullopt, "");
+        }
+        sessionHash = util::sha256Hex(claims->sessionId);
+
+        // With a current revocation set the token is all we need; otherwise it is checked
+        // against the database like an opaque cookie.
+        if (revocations_.current()) {
+            if (revocations_.contains(sessionHash)) {
+                co_return std::make_tuple(std::nullopt, std::move(sessionHash));
+            }
+            AppSession session {
+                .userId = claims->userId,
+                .sessionHash = sessionHash,
+                .expiresAt = std::format("{:%FT%TZ}", claims->expiresAt),
+            };
+            co_return std::make_tuple(std::optional { std::move(session) }, std::move(sessionHash));
+        }
+    } else {
+        sessionHash = util::sha256Hex(sessionId.value());
+    }
+
+    if (auto hit = sessionCache_.find(sessionHash)) {
+        co_return std::make_tuple(std::move(hit->session), std::move(sessionHash));
+    }
+
     std::string now;
     now = util::time::getCurrentTimestamp();
 
-    auto session = co_await databaseSession->selectActiveAppSession(sessionHash, now);
-    co_return std::make_tuple(session, std::move(sessionHash));
+    auto lookup = co_await databaseSession->selectActiveAppSession(sessionHash, now);
+    if (!lookup) {
+        // Nothing is cached: a failed lookup says nothing about the session.
+        co_return std::make_tuple(std::nullopt, std::move(sessionHash));
+    }
+    auto& session = *lookup;
+    if (session) {
+        sessionCache_.store(sessionHash, *session);
+    } else {
+        sessionCache_.storeMissing(sessionHash);
+    }
+    co_return std::make_tuple(std::move(session), std::move(sessionHash));
 }
 }   // namespace Network
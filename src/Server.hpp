@@ -1,16 +1,29 @@
 #pragma once
 
 #include "Auth/GoogleTokenManager.hpp"
+#include "Auth/OAuthStates.hpp"
+#include "Auth/RevocationSet.hpp"
+#include "Auth/SessionTokens.hpp"
+#include "Auth/TokenRefresher.hpp"
+#include "Cache/DocumentFilter.hpp"
+#include "Cache/Invalidation.hpp"
+#include "Cache/ResponseCache.hpp"
+#include "Cache/SessionCache.hpp"
 #include "Models/Paragraph.hpp"
 #include "Models/Document.hpp"
 #include "Session/DataBaseSession.hpp"
 #include "Session/SslSession.hpp"
+#include "Session/WriteBehind.hpp"
 #include "Util/ConfigParser.hpp"
+#include "Util/SingleFlight.hpp"
+#include "WarmUp.hpp"
 
 #include <boost/asio.hpp>
 #include <boost/asio/awaitable.hpp>
 #include <boost/beast.hpp>
 #include <boost/beast/http.hpp>
+#include <atomic>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <boost/url/error_types.hpp>
@@ -35,7 +48,9 @@ private:
         AuthGoogleStart,
         AuthGoogleCallback,
         AuthMe,
-        AuthLogout
+        AuthLogout,
+        Metrics,
+        Readyz
     };
 
     struct DocumentRequest {
@@ -44,6 +59,11 @@ private:
         std::string file_type;
     };
 
+    // Documents gathered for one analyze request.
+    struct CollectedDocuments {
+        std::vector<Document> documents;
+    };
+
     static const std::unordered_map<std::string, RequesType> changeReqToEnum;
 
     asio::io_context& ioc_;
@@ -53,11 +73,44 @@ private:
     asio::thread_pool tp { std::thread::hardware_concurrency() / 2 };
     std::shared_ptr<DataBaseSession> databaseSession;
 
+    // Fire-and-forget database writes (session last_seen_at), journaled and flushed in batches.
+    WriteBehind writeBehind_;
+
     Util::ConfigParser config;
 
+    // Download, parse and store of one Drive file, shared by concurrent analyze requests.
+    util::SingleFlight<std::string, Document> documentFlights_;
+
+    // Downloaded documents waiting to be stored. The flights queue them, so storing does not depend
+    // on any request staying around; one persister at a time drains the queue in batches.
+    std::mutex storeMutex_;
+    std::vector<Document> storeQueue_;
+    bool storing_ = false;
+
+    Cache::ResponseCache classroomCache_;
+    Cache::SessionCache sessionCache_;
+    // Signed session cookies and the revoked sessions they are checked against.
+    Auth::SessionTokens sessionTokens_;
+    Auth::RevocationSet revocations_;
+    // Signed OAuth `state` values, which replace the oauth_states rows when signing keys are set.
+    Auth::OAuthStates oauthStates_;
+    // Ids of stored documents, so files never seen before skip the database lookup.
+    Cache::DocumentFilter documentFilter_;
+
+    // Renews Google tokens of recently active users ahead of expiry, off the request path.
+    Auth::TokenRefresher tokenRefresher_;
+
+    // Evictions announced by other instances; runs only when DATABASE_URL is set.
+    std::unique_ptr<Cache::InvalidationListener> invalidations_;
+
+    // Set once start-up warm-up has finished; /readyz answers 503 until then.
+    std::atomic<bool> ready_ { false };
+
     asio::awaitable<void> doSession(tcp_stream stream);
     asio::awaitable<void> listen();
+    asio::awaitable<void> warmUp();
     void applyCorsHeaders(http::response<http::string_body>& res) const;
+    void invalidate(const Cache::Invalidation& invalidation);
 
     asio::awaitable<http::response<http::string_body>> requestHandler(http::request<http::string_body> req);
     asio::awaitable<http::response<http::string_body>> analyzesHandler(http::request<http::string_body> req);
@@ -69,12 +122,25 @@ private:
     asio::awaitable<http::response<http::string_body>> authMeHandler(http::request<http::string_body> req);
 
     asio::awaitable<http::response<http::string_body>> authLogoutHandler(http::request<http::string_body> req);
+    http::response<http::string_body> metricsHandler(const http::request<http::string_body>& req) const;
+    http::response<http::string_body> readyzHandler(const http::request<http::string_body>& req) const;
     asio::awaitable<http::response<http::string_body>> classroomProxyHandler(http::request<http::string_body> req, boost::urls::url_view target);
+    asio::awaitable<http::response<http::string_body>> fetchClassroom(
+        std::string userId, std::string target, std::shared_ptr<const Cache::CachedResponse> cached);
+    asio::awaitable<void> revalidateClassroom(
+        std::string userId, std::string target, std::shared_ptr<const Cache::CachedResponse> cached);
     asio::awaitable<http::response<http::string_body>> handle_document_request(
-        std::vector<DocumentRequest> vreq, std::span<Document> cache_docs, asio::any_io_executor cpu_ex);
+        std::vector<DocumentRequest> vreq, std::span<Document> cache_docs, asio::any_io_executor cpu_ex,
+        Network::Deadline deadline);
     asio::awaitable<void> download_extract_store(
         DocumentRequest req, asio::any_io_executor cpu_ex, asio::strand<asio::any_io_executor> store_strand,
-        std::shared_ptr<std::vector<Document>> container);
+        std::shared_ptr<CollectedDocuments> collected);
+    asio::awaitable<Document> fetchDocument(DocumentRequest req, asio::any_io_executor cpu_ex);
+    // now + the `key` milliseconds from the config, `fallback` when unset.
+    Network::Deadline deadlineAfter(const std::string& key, std::chrono::milliseconds fallback) const;
+    void queueForStore(Document document);
+    asio::awaitable<void> storeQueued();
+    asio::awaitable<void> persistDocuments(std::vector<Document> documents);
 
     template<typename T>
     std::optional<std::string> getCookie(const http::request<T>& req, std::string_view cookieName);
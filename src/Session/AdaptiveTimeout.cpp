@@ -0,0 +1,70 @@
+#include "AdaptiveTimeout.hpp"
+
+#include "Util/ConfigParser.hpp"
+
+#include <boost/asio/error.hpp>
+#include <boost/system/system_error.hpp>
+
+#include <algorithm>
+
+namespace {
+
+std::chrono::milliseconds millis(const Util::ConfigParser& config, const std::string& key,
+                                 std::chrono::milliseconds fallback) {
+    return std::chrono::milliseconds(static_cast<std::int64_t>(config.number(key, fallback.count())));
+}
+
+}   // namespace
+
+namespace Network {
+
+const TimeoutPolicy& TimeoutPolicy::defaults() {
+    static const TimeoutPolicy policy = [] {
+        Util::ConfigParser config;
+        TimeoutPolicy result;
+        result.quantile = config.number("TIMEOUT_QUANTILE", result.quantile);
+        result.multiplier = config.number("TIMEOUT_MULTIPLIER", result.multiplier);
+        result.responseFloor = millis(config, "RESPONSE_TIMEOUT_MIN_MS", result.responseFloor);
+        result.responseCeiling = millis(config, "RESPONSE_TIMEOUT_MAX_MS", result.responseCeiling);
+        result.connectFloor = millis(config, "CONNECT_TIMEOUT_MIN_MS", result.connectFloor);
+        result.connectCeiling = millis(config, "CONNECT_TIMEOUT_MAX_MS", result.connectCeiling);
+        return result;
+    }();
+    return policy;
+}
+
+std::chrono::milliseconds adaptiveTimeout(const LatencyHistogram& histogram, double quantile, double multiplier,
+                                          std::chrono::milliseconds floor, std::chrono::milliseconds ceiling) {
+    auto observed = histogram.quantile(quantile);
+    if (!observed) {
+        return ceiling;
+    }
+
+    auto scaled = std::chrono::duration_cast<std::chrono::milliseconds>(*observed * multiplier);
+    return std::clamp(scaled, floor, std::max(floor, ceiling));
+}
+
+std::chrono::milliseconds responseTimeout(std::string_view upstream, const TimeoutPolicy& policy) {
+    return adaptiveTimeout(UpstreamLatency::instance().response(upstream), policy.quantile, policy.multiplier,
+                           policy.responseFloor, policy.responseCeiling);
+}
+
+std::chrono::milliseconds connectTimeout(std::string_view upstream, const TimeoutPolicy& policy) {
+    return adaptiveTimeout(UpstreamLatency::instance().connect(upstream), policy.quantile, policy.multiplier,
+                           policy.connectFloor, policy.connectCeiling);
+}
+
+void recordTimeout(LatencyHistogram& histogram, std::chrono::milliseconds timeout) { histogram.record(timeout); }
+
+std::chrono::steady_clock::time_point expiryFor(std::chrono::milliseconds timeout, const Deadline& deadline,
+                                                std::chrono::steady_clock::time_point now) {
+    if (!deadline) {
+        return now + timeout;
+    }
+    if (*deadline <= now) {
+        throw boost::system::system_error(boost::asio::error::timed_out, "Request deadline exceeded");
+    }
+    return std::min(now + timeout, *deadline);
+}
+
+}   // namespace Network
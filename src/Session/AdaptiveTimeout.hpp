@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Session/UpstreamLatency.hpp"
+
+#include <chrono>
+#include <optional>
+#include <string_view>
+
+namespace Network {
+
+using Deadline = std::optional<std::chrono::steady_clock::time_point>;
+
+// Timeouts derived from the live latency of an upstream: quantile * multiplier, clamped to
+// [floor, ceiling]. Until the histogram has enough samples the ceiling is used.
+struct TimeoutPolicy {
+    double quantile = 0.999;
+    double multiplier = 3.0;
+    std::chrono::milliseconds responseFloor { 1000 };
+    std::chrono::milliseconds responseCeiling { 300'000 };
+    std::chrono::milliseconds connectFloor { 250 };
+    std::chrono::milliseconds connectCeiling { 30'000 };
+
+    static const TimeoutPolicy& defaults();
+};
+
+std::chrono::milliseconds adaptiveTimeout(const LatencyHistogram& histogram, double quantile, double multiplier,
+                                          std::chrono::milliseconds floor, std::chrono::milliseconds ceiling);
+
+// Time allowed from sending the request until the response headers arrive.
+std::chrono::milliseconds responseTimeout(std::string_view upstream,
+                                          const TimeoutPolicy& policy = TimeoutPolicy::defaults());
+
+// Time allowed for TCP connect plus the TLS handshake.
+std::chrono::milliseconds connectTimeout(std::string_view upstream,
+                                         const TimeoutPolicy& policy = TimeoutPolicy::defaults());
+
+// Counts a wait that ran into `timeout` as a sample at the timeout. Timed-out calls otherwise
+// never reach the histogram, and a timeout that is too short could never widen again.
+void recordTimeout(LatencyHistogram& histogram, std::chrono::milliseconds timeout);
+
+// now + timeout, cut short by the request deadline. Throws timed_out when the deadline has already passed.
+std::chrono::steady_clock::time_point expiryFor(
+    std::chrono::milliseconds timeout, const Deadline& deadline,
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+}   // namespace Network
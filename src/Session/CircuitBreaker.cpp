@@ -0,0 +1,213 @@
+#include "CircuitBreaker.hpp"
+
+#include "Util/ConfigParser.hpp"
+#include "Util/Metrics.hpp"
+
+#include <boost/asio/error.hpp>
+
+#include <format>
+#include <utility>
+
+namespace {
+
+class CircuitCategory : public boost::system::error_category {
+public:
+    const char* name() const noexcept override { return "circuit_breaker"; }
+
+    std::string message(int ev) const override {
+        if (static_cast<Network::CircuitError>(ev) == Network::CircuitError::open) {
+            return "Circuit breaker is open";
+        }
+        return "Unknown circuit breaker error";
+    }
+};
+
+}   // namespace
+
+namespace Network {
+
+const boost::system::error_category& circuitCategory() {
+    static const CircuitCategory category;
+    return category;
+}
+
+const CircuitBreaker::Options& CircuitBreaker::Options::defaults() {
+    static const Options options = [] {
+        Util::ConfigParser config;
+        Options result;
+        result.minRequests = static_cast<std::uint64_t>(config.number("CIRCUIT_MIN_REQUESTS", result.minRequests));
+        result.failureRatio = config.number("CIRCUIT_FAILURE_RATIO", result.failureRatio);
+        result.slowCall = std::chrono::milliseconds(
+            static_cast<std::int64_t>(config.number("CIRCUIT_SLOW_CALL_MS", result.slowCall.count())));
+        result.slowRatio = config.number("CIRCUIT_SLOW_RATIO", result.slowRatio);
+        result.openDuration = std::chrono::milliseconds(
+            static_cast<std::int64_t>(config.number("CIRCUIT_OPEN_MS", result.openDuration.count())));
+        return result;
+    }();
+    return options;
+}
+
+CircuitBreaker::CircuitBreaker(Options options) : options_(options), windowStart_(Clock::now()) {}
+
+void CircuitBreaker::rotate(Clock::time_point now) {
+    if (now - windowStart_ < options_.window) {
+        return;
+    }
+    previous_ = now - windowStart_ < 2 * options_.window ? current_ : Window {};
+    current_ = {};
+    windowStart_ = now;
+}
+
+bool CircuitBreaker::allow(Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+
+    if (state_ == State::Open) {
+        if (now < openUntil_) {
+            ++rejected_;
+            return false;
+        }
+        state_ = State::HalfOpen;
+        probesInFlight_ = 0;
+        probeSuccesses_ = 0;
+    }
+
+    if (state_ == State::HalfOpen) {
+        if (probesInFlight_ >= options_.halfOpenProbes) {
+            ++rejected_;
+            return false;
+        }
+        ++probesInFlight_;
+    }
+
+    return true;
+}
+
+void CircuitBreaker::onResult(boost::beast::http::status status, std::chrono::microseconds latency,
+                              Clock::time_point now) {
+    const bool failure = static_cast<unsigned>(status) >= 500;
+    const bool slow = options_.slowCall.count() > 0 && latency > options_.slowCall;
+    record(failure, slow, now);
+}
+
+void CircuitBreaker::onError(const boost::system::error_code& ec, Clock::time_point now) {
+    if (ec == boost::asio::error::operation_aborted) {
+        std::lock_guard lock(mutex_);
+        if (state_ == State::HalfOpen && probesInFlight_ > 0) {
+            --probesInFlight_;
+        }
+        return;
+    }
+    record(true, false, now);
+}
+
+CircuitBreaker::Call::~Call() {
+    if (breaker_ != nullptr) {
+        breaker_->record(true, false, Clock::now());
+    }
+}
+
+void CircuitBreaker::Call::onResult(boost::beast::http::status status, std::chrono::microseconds latency) {
+    if (auto* breaker = std::exchange(breaker_, nullptr)) {
+        breaker->onResult(status, latency);
+    }
+}
+
+void CircuitBreaker::Call::onError(const boost::system::error_code& ec) {
+    if (auto* breaker = std::exchange(breaker_, nullptr)) {
+        breaker->onError(ec);
+    }
+}
+
+void CircuitBreaker::record(bool failure, bool slow, Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+
+    if (state_ == State::HalfOpen) {
+        if (probesInFlight_ > 0) {
+            --probesInFlight_;
+        }
+        if (failure || slow) {
+            trip(now);
+        } else if (++probeSuccesses_ >= options_.halfOpenProbes) {
+            state_ = State::Closed;
+            current_ = {};
+            previous_ = {};
+            windowStart_ = now;
+        }
+        return;
+    }
+
+    if (state_ == State::Open) {
+        return;
+    }
+
+    rotate(now);
+    ++current_.total;
+    current_.failures += failure ? 1 : 0;
+    current_.slow += slow ? 1 : 0;
+
+    const auto total = current_.total + previous_.total;
+    if (total < options_.minRequests) {
+        return;
+    }
+
+    const auto failureRatio = static_cast<double>(current_.failures + previous_.failures) / static_cast<double>(total);
+    const auto slowRatio = static_cast<double>(current_.slow + previous_.slow) / static_cast<double>(total);
+    if (failureRatio >= options_.failureRatio || (options_.slowCall.count() > 0 && slowRatio >= options_.slowRatio)) {
+        trip(now);
+    }
+}
+
+void CircuitBreaker::trip(Clock::time_point now) {
+    state_ = State::Open;
+    openUntil_ = now + options_.openDuration;
+    probesInFlight_ = 0;
+    probeSuccesses_ = 0;
+}
+
+CircuitBreaker::State CircuitBreaker::state() const {
+    std::lock_guard lock(mutex_);
+    return state_;
+}
+
+std::uint64_t CircuitBreaker::rejected() const {
+    std::lock_guard lock(mutex_);
+    return rejected_;
+}
+
+CircuitBreakers& CircuitBreakers::instance() {
+    static CircuitBreakers breakers;
+    return breakers;
+}
+
+CircuitBreakers::CircuitBreakers() {
+    util::metrics::Registry::instance().addCollector([this](std::string& out) { collect(out); });
+}
+
+CircuitBreaker& CircuitBreakers::get(std::string_view upstream) {
+    std::lock_guard lock(mutex_);
+    auto it = breakers_.find(upstream);
+    if (it == breakers_.end()) {
+        it = breakers_.emplace(std::string(upstream), std::make_unique<CircuitBreaker>()).first;
+    }
+    return *it->second;
+}
+
+void CircuitBreakers::collect(std::string& out) const {
+    std::lock_guard lock(mutex_);
+
+    util::metrics::appendHeader(out, "anty_circuit_breaker_state", "gauge",
+                                "Circuit breaker state per upstream (0 closed, 1 open, 2 half-open)");
+    for (const auto& [upstream, breaker] : breakers_) {
+        util::metrics::appendSample(out, "anty_circuit_breaker_state", std::format("upstream=\"{}\"", upstream),
+                                    static_cast<double>(breaker->state()));
+    }
+
+    util::metrics::appendHeader(out, "anty_circuit_breaker_rejected_total", "counter",
+                                "Calls rejected while the breaker was open");
+    for (const auto& [upstream, breaker] : breakers_) {
+        util::metrics::appendSample(out, "anty_circuit_breaker_rejected_total",
+                                    std::format("upstream=\"{}\"", upstream), static_cast<double>(breaker->rejected()));
+    }
+}
+
+}   // namespace Network
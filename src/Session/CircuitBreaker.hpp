@@ -0,0 +1,129 @@
+#pragma once
+
+#include <boost/beast/http/status.hpp>
+#include <boost/system/error_code.hpp>
+#include <boost/system/system_error.hpp>
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace Network {
+
+enum class CircuitError {
+    open = 1
+};
+
+const boost::system::error_category& circuitCategory();
+
+inline boost::system::error_code make_error_code(CircuitError e) {
+    return { static_cast<int>(e), circuitCategory() };
+}
+
+}   // namespace Network
+
+template <>
+struct boost::system::is_error_code_enum<Network::CircuitError> : std::true_type {};
+
+namespace Network {
+
+struct CircuitOpenError : boost::system::system_error {
+    explicit CircuitOpenError(const std::string& upstream) : boost::system::system_error(make_error_code(CircuitError::open), upstream) {}
+};
+
+// Closed -> Open when the failure (or slow-call) ratio over the window crosses the threshold,
+// Open -> HalfOpen after the cool-down, HalfOpen -> Closed after enough successful probes.
+class CircuitBreaker {
+public:
+    enum class State {
+        Closed,
+        Open,
+        HalfOpen
+    };
+
+    struct Options {
+        std::chrono::seconds window { 10 };
+        std::uint64_t minRequests = 20;
+        double failureRatio = 0.5;
+        std::chrono::milliseconds slowCall { 0 };
+        double slowRatio = 0.8;
+        std::chrono::milliseconds openDuration { 5000 };
+        std::uint64_t halfOpenProbes = 2;
+
+        static const Options& defaults();
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    explicit CircuitBreaker(Options options = Options::defaults());
+
+    bool allow(Clock::time_point now = Clock::now());
+
+    void onResult(boost::beast::http::status status, std::chrono::microseconds latency,
+                  Clock::time_point now = Clock::now());
+    void onError(const boost::system::error_code& ec, Clock::time_point now = Clock::now());
+
+    State state() const;
+    std::uint64_t rejected() const;
+
+    // One admitted call. Reports its outcome exactly once; a call dropped without an outcome (an
+    // exception that is not a network error, or a destroyed coroutine) counts as a failure, so a
+    // half-open probe slot is always given back.
+    class Call {
+    public:
+        explicit Call(CircuitBreaker& breaker) : breaker_(&breaker) {}
+        Call(const Call&) = delete;
+        Call& operator=(const Call&) = delete;
+        ~Call();
+
+        void onResult(boost::beast::http::status status, std::chrono::microseconds latency);
+        void onError(const boost::system::error_code& ec);
+
+    private:
+        CircuitBreaker* breaker_;
+    };
+
+private:
+    struct Window {
+        std::uint64_t total = 0;
+        std::uint64_t failures = 0;
+        std::uint64_t slow = 0;
+    };
+
+    void record(bool failure, bool slow, Clock::time_point now);
+    void trip(Clock::time_point now);
+    void rotate(Clock::time_point now);
+
+    Options options_;
+
+    mutable std::mutex mutex_;
+    State state_ = State::Closed;
+    Window current_;
+    Window previous_;
+    Clock::time_point windowStart_;
+    Clock::time_point openUntil_;
+    std::uint64_t probesInFlight_ = 0;
+    std::uint64_t probeSuccesses_ = 0;
+    std::uint64_t rejected_ = 0;
+};
+
+// One breaker per upstream "host:port"; exports their state as metrics.
+class CircuitBreakers {
+public:
+    static CircuitBreakers& instance();
+
+    CircuitBreaker& get(std::string_view upstream);
+
+    void collect(std::string& out) const;
+
+private:
+    CircuitBreakers();
+
+    mutable std::mutex mutex_;
+    std::map<std::string, std::unique_ptr<CircuitBreaker>, std::less<>> breakers_;
+};
+
+}   // namespace Network
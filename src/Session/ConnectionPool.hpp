@@ -0,0 +1,89 @@
+#pragma once
+
+#include <boost/asio/any_io_executor.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Network {
+
+// Idle sessions kept per upstream "host:port" so follow-up requests reuse an open keep-alive
+// connection instead of paying for TCP + TLS again. A session is only given back after a
+// complete response; one that failed mid-request is simply dropped. Sessions whose connection
+// closed, or that now talk to another host after a redirect, are never pooled (see
+// Session::reusableFor), which also catches connections the server closed while they sat idle.
+// `maxIdleTime` is only a backstop for connections dropped without a FIN, so it is long enough
+// to keep the connections opened at warm-up until the first requests arrive.
+template <typename Session>
+class ConnectionPool {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static ConnectionPool& instance() {
+        static ConnectionPool pool;
+        return pool;
+    }
+
+    explicit ConnectionPool(std::size_t maxIdlePerUpstream = 8,
+                            std::chrono::seconds maxIdleTime = std::chrono::hours(1))
+      : maxIdlePerUpstream_(maxIdlePerUpstream), maxIdleTime_(maxIdleTime) {}
+
+    std::shared_ptr<Session> acquire(boost::asio::any_io_executor executor, std::string_view upstream,
+                                     Clock::time_point now = Clock::now()) {
+        {
+            std::lock_guard lock(mutex_);
+            if (auto it = idle_.find(upstream); it != idle_.end()) {
+                auto& sessions = it->second;
+                while (!sessions.empty()) {
+                    auto idle = std::move(sessions.back());
+                    sessions.pop_back();
+                    if (now - idle.since < maxIdleTime_ && idle.session->reusableFor(upstream)) {
+                        return std::move(idle.session);
+                    }
+                }
+            }
+        }
+        return std::make_shared<Session>(executor);
+    }
+
+    void release(std::string_view upstream, std::shared_ptr<Session> session, Clock::time_point now = Clock::now()) {
+        if (!session->reusableFor(upstream)) {
+            return;
+        }
+
+        std::lock_guard lock(mutex_);
+        auto it = idle_.find(upstream);
+        if (it == idle_.end()) {
+            it = idle_.emplace(std::string(upstream), std::vector<Idle> {}).first;
+        }
+        if (it->second.size() < maxIdlePerUpstream_) {
+            it->second.push_back({ std::move(session), now });
+        }
+    }
+
+    std::size_t idle(std::string_view upstream) const {
+        std::lock_guard lock(mutex_);
+        auto it = idle_.find(upstream);
+        return it == idle_.end() ? 0 : it->second.size();
+    }
+
+private:
+    struct Idle {
+        std::shared_ptr<Session> session;
+        Clock::time_point since;
+    };
+
+    std::size_t maxIdlePerUpstream_;
+    std::chrono::seconds maxIdleTime_;
+
+    mutable std::mutex mutex_;
+    std::map<std::string, std::vector<Idle>, std::less<>> idle_;
+};
+
+}   // namespace Network
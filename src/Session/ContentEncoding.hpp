@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Session/PooledBody.hpp"
+#include "Util/Compression.hpp"
+
+#include <boost/beast/http.hpp>
+#include <boost/system/error_code.hpp>
+#include <boost/system/system_error.hpp>
+
+#include <cstddef>
+#include <type_traits>
+
+namespace Network {
+
+// Asks for a gzip response unless the caller chose an encoding itself or wants a byte range:
+// ranges apply to the encoded representation and could not be stitched back together.
+inline void requestGzip(boost::beast::http::request<boost::beast::http::string_body>& req) {
+    namespace http = boost::beast::http;
+    if (req.find(http::field::accept_encoding) == req.end() && req.find(http::field::range) == req.end()) {
+        req.set(http::field::accept_encoding, "gzip");
+    }
+}
+
+// Compresses the body with gzip once it reaches `minSize` bytes.
+inline void gzipRequestBody(boost::beast::http::request<boost::beast::http::string_body>& req, std::size_t minSize) {
+    namespace http = boost::beast::http;
+    if (req.body().size() < minSize || req.find(http::field::content_encoding) != req.end()) {
+        return;
+    }
+    req.body() = util::gzipCompress(req.body());
+    req.set(http::field::content_encoding, "gzip");
+    req.prepare_payload();
+}
+
+// Leaves `res` with a decoded body and headers that describe it. PooledBody inflates while
+// reading; a string body is inflated here in one go.
+template <typename Body>
+void decodeContentEncoding(boost::beast::http::response<Body>& res) {
+    namespace http = boost::beast::http;
+    if (!isGzipEncoded(res[http::field::content_encoding])) {
+        return;
+    }
+
+    if constexpr (std::is_same_v<Body, http::string_body>) {
+        auto decoded = util::gzipDecompress(res.body(), PooledBody::maxBodySize);
+        if (!decoded) {
+            throw boost::system::system_error(make_error_code(boost::system::errc::illegal_byte_sequence),
+                                              "Corrupt gzip response body");
+        }
+        res.body() = std::move(*decoded);
+    }
+
+    res.erase(http::field::content_encoding);
+    res.content_length(res.body().size());
+}
+
+}   // namespace Network
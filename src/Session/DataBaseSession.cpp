@@ -3,7 +3,14 @@
 //
 
 #include "DataBaseSession.hpp"
-
+#include "HedgedRequest.hpp"
+#include "PgDataBaseSession.hpp"
+#include "PostgrestRows.hpp"
+#include "Util/Encrypt.hpp"
+#include "Util/NetworkHealper.hpp"
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
 #include <boost/beast.hpp>
 #include <boost/beast/http/message.hpp>
 
@@ -16,6 +23,13 @@ namespace {
     namespace beast = boost::beast;
     namespace http = beast::http;
 
+    // Keeps batched lookups below the 8 KiB request-line limit common to proxies in front of PostgREST.
+    constexpr std::size_t MAX_TARGET_LENGTH = 6144;
+
+    // Rows per page of a full-table read. A server whose db-max-rows is lower just returns shorter
+    // pages; paging ends at the first empty one.
+    constexpr std::size_t PAGE_ROWS = 1000;
+
     void setSupabaseHeaders(http::request<http::string_body>& request, const Util::ConfigParser& config) {
         request.set(http::field::authorization, config["SUPABASE_KEY"]);
         request.set("apikey", config["SUPABASE_KEY"]);
@@ -31,114 +45,153 @@ namespace {
     asio::awaitable<http::response<Body>> sendDatabaseRequest(
         asio::any_io_executor executor,
         http::request<http::string_body> req) {
-        auto session = std::make_shared<Network::SslSession>(executor);
-        co_return co_await session->sendRequest<Body>(std::move(req));
+        if (req.method() == http::verb::get) {
+            co_return co_await Network::sendHedged<Network::SslSession, Body>(executor, std::move(req), "443");
+        }
+        co_return co_await Network::sendOnce<Network::SslSession, Body>(executor, std::move(req));
     }
 
-    std::optional<std::string> optionalString(const boost::json::object& json, std::string_view key) {
-        auto value = json.if_contains(key);
-        if (value == nullptr || value->is_null()) {
+    // First row of a PostgREST response as a model struct; empty if there is none or the body
+    // does not decode as `Row`s.
+    template <typename Row>
+    auto firstModel(std::string_view method, std::string_view body)
+        -> std::optional<decltype(Network::postgrest::toModel(std::declval<Row>()))> {
+        auto rows = Network::postgrest::decodeRows<Row>(body);
+        if (!rows) {
+            std::println(std::cerr, "{}: unexpected response body", method);
             return std::nullopt;
         }
-        return std::string(value->as_string());
-    }
-
-    Network::AuthUser authUserFromJson(const boost::json::object& json) {
-        return Network::AuthUser {
-            .id = std::string(json.at("id").as_string()),
-            .googleSub = std::string(json.at("google_sub").as_string()),
-            .email = std::string(json.at("email").as_string()),
-            .name = optionalString(json, "name").value_or(""),
-            .pictureUrl = optionalString(json, "picture_url").value_or(""),
-        };
-    }
-
-    Network::GoogleOAuthTokens googleOAuthTokensFromJson(const boost::json::object& json) {
-        return Network::GoogleOAuthTokens {
-            .userId = std::string(json.at("user_id").as_string()),
-            .accessTokenEnc = std::string(json.at("access_token_enc").as_string()),
-            .refreshTokenEnc = optionalString(json, "refresh_token_enc"),
-            .expiresAt = std::string(json.at("expires_at").as_string()),
-            .scope = optionalString(json, "scope").value_or(""),
-            .tokenType = optionalString(json, "token_type").value_or(""),
-        };
-    }
-
-    Network::AppSession appSessionFromJson(const boost::json::object& json) {
-        return Network::AppSession {
-            .id = std::string(json.at("id").as_string()),
-            .userId = std::string(json.at("user_id").as_string()),
-            .sessionHash = std::string(json.at("session_hash").as_string()),
-            .expiresAt = std::string(json.at("expires_at").as_string()),
-            .revokedAt = optionalString(json, "revoked_at"),
-        };
+        if (rows->empty()) {
+            return std::nullopt;
+        }
+        return Network::postgrest::toModel(std::move(rows->front()));
     }
 }
 
 namespace Network {
 
-DataBaseSession::DataBaseSession() = default;
+std::shared_ptr<DataBaseSession> makeDataBaseSession(const Util::ConfigParser& config) {
+    if (auto backend = config["DATABASE_BACKEND"]; backend == "postgres") {
+        return std::make_shared<PgDataBaseSession>(std::string(config["DATABASE_URL"]), PgDataBaseSession::Options::defaults());
+    } else if (!backend.empty() && backend != "rest") {
+        std::println(std::cerr, "Unknown DATABASE_BACKEND '{}', using rest", backend);
+    }
+    return std::make_shared<RestDataBaseSession>();
+}
 
-asio::awaitable<bool> DataBaseSession::insertDocument(const Document& document) {
-    boost::json::object documentJson {
-        {"external_id", document.docId},
-        {"title", document.text.empty() ? document.docId : document.text.front().title},
-    };
+RestDataBaseSession::RestDataBaseSession() : router_(std::string(config["SUPABASE_HOST"])) {
+    if (router_.hasReadEndpoints()) {
+        asio::co_spawn(
+            threadPool,
+            router_.run([this](std::string endpoint) { return probe(std::move(endpoint)); }),
+            asio::detached);
+    }
+}
 
-    http::request<http::string_body> req{http::verb::post,  baseUrl + "/documents?select=id", 11};
+asio::awaitable<RestDataBaseSession::Response> RestDataBaseSession::sendRead(std::string_view key, Request req) {
+    co_return co_await sendReadTo(router_.route(ReadRouter::Access::Read, key), std::move(req));
+}
 
-    req.body() = boost::json::serialize(documentJson);
-    req.set("Prefer", "return=representation");
+asio::awaitable<RestDataBaseSession::Response> RestDataBaseSession::sendRead(std::span<const std::string> keys, Request req) {
+    co_return co_await sendReadTo(router_.route(ReadRouter::Access::Read, keys), std::move(req));
+}
 
-    setSupabaseHeaders(req, config);
-    req.prepare_payload();
+// A read endpoint that fails or answers 5xx counts against its health, and the read is
+// repeated on the primary.
+asio::awaitable<RestDataBaseSession::Response> RestDataBaseSession::sendReadTo(std::string endpoint, Request req) {
+    if (endpoint == router_.primary()) {
+        co_return co_await sendDatabaseRequest<PooledBody>(threadPool.get_executor(), std::move(req));
+    }
 
-    auto res = co_await sendDatabaseRequest<http::string_body>(threadPool.get_executor(), std::move(req));
-    if (auto status = res.result(); status != http::status::created && status != http::status::ok) {
-        co_return false;
+    auto onPrimary = req;
+    req.set(http::field::host, endpoint);
+    const auto start = std::chrono::steady_clock::now();
+    std::optional<Response> res;
+    try {
+        res = co_await sendDatabaseRequest<PooledBody>(threadPool.get_executor(), std::move(req));
+    } catch (const std::exception& e) {
+        std::println(std::cerr, "Read from {} failed: {}", endpoint, e.what());
     }
 
-    auto insertedDocuments = boost::json::parse(res.body()).as_array();
-    if (insertedDocuments.empty()) {
-        co_return false;
+    if (res && res->result_int() < 500) {
+        router_.report(endpoint, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start));
+        co_return std::move(*res);
     }
+    router_.report(endpoint, std::nullopt);
+    co_return co_await sendDatabaseRequest<PooledBody>(threadPool.get_executor(), std::move(onPrimary));
+}
 
-    auto const& documentId = insertedDocuments.front().as_object().at("id").as_string();
+// Health check of a read endpoint: the PostgREST root answers without touching a table.
+asio::awaitable<std::optional<std::chrono::microseconds>> RestDataBaseSession::probe(std::string endpoint) {
+    Request req{http::verb::get, baseUrl + "/", 11};
+    setSupabaseHeaders(req, config);
+    req.set(http::field::host, endpoint);
+    req.prepare_payload();
 
-    if (document.text.empty()) {
-        co_return true;
+    const auto start = std::chrono::steady_clock::now();
+    auto res = co_await sendOnce<SslSession, PooledBody>(threadPool.get_executor(), std::move(req));
+    if (res.result_int() >= 500) {
+        co_return std::nullopt;
     }
+    co_return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+}
 
-    boost::json::array sectionsJson;
-    sectionsJson.reserve(document.text.size());
+// Sections may carry a zstd frame, which plain POST /document_sections cannot take as base64,
+// so a single document goes through the same RPC as a batch.
+asio::awaitable<bool> RestDataBaseSession::insertDocument(const Document& document) {
+    co_return co_await insertDocuments(std::span<const Document> { &document, 1 });
+}
 
-    for (auto const& paragraph : document.text) {
-        sectionsJson.emplace_back(boost::json::object {
-            {"document_id", documentId},
-            {"title", paragraph.title},
-            {"content", paragraph.text},
-        });
+asio::awaitable<bool> RestDataBaseSession::insertDocuments(std::span<const Document> documents) {
+    if (documents.empty()) {
+        co_return true;
     }
 
-    http::request<http::string_body> sectionsReq{http::verb::post,  baseUrl + "/document_sections", 11};
+    // sql/insert_documents.sql: documents and sections in one transaction.
+    boost::json::array documentsJson;
+    documentsJson.reserve(documents.size());
+    for (auto const& document : documents) {
+        boost::json::array sectionsJson;
+        sectionsJson.reserve(document.text.size());
+        for (auto const& paragraph : document.text) {
+            auto stored = Documents::storeContent(paragraph.text);
+            boost::json::object section {{"title", paragraph.title}};
+            section["content"] = stored.content ? boost::json::value(*stored.content) : nullptr;
+            section["content_zstd"] = stored.compressed ? boost::json::value(util::base64Encode(*stored.compressed)) : nullptr;
+            sectionsJson.emplace_back(std::move(section));
+        }
+        documentsJson.emplace_back(boost::json::object {
+            {"external_id", document.docId},
+            {"title", document.text.empty() ? document.docId : document.text.front().title},
+            {"sections", std::move(sectionsJson)},
+        });
+    }
 
-    sectionsReq.body() = boost::json::serialize(sectionsJson);
-    sectionsReq.set("Prefer", "return=representation");
-    setSupabaseHeaders(sectionsReq, config);
-    sectionsReq.prepare_payload();
+    http::request<http::string_body> req{http::verb::post, baseUrl + "/rpc/insert_documents", 11};
+    req.body() = boost::json::serialize(boost::json::object {{"documents", std::move(documentsJson)}});
+    setSupabaseHeaders(req, config);
+    req.prepare_payload();
 
-    auto sectionsRes = co_await sendDatabaseRequest<http::string_body>(threadPool.get_executor(), std::move(sectionsReq));
-    if (auto status = sectionsRes.result(); status != http::status::created && status != http::status::ok) {
+    auto res = co_await sendDatabaseRequest<PooledBody>(threadPool.get_executor(), std::move(req));
+    if (!isWriteSuccess(res.result())) {
+        std::println(
+            std::cerr,
+            "insertDocuments failed: status={}, body={}",
+            static_cast<unsigned>(res.result()),
+            res.body().view());
         co_return false;
     }
-
+    for (auto const& document : documents) {
+        router_.wrote("document:" + document.docId);
+    }
     co_return true;
 }
 
-asio::awaitable<std::optional<Document>> DataBaseSession::selectDocumentById(std::string_view documentId) {
+asio::awaitable<std::optional<Document>> RestDataBaseSession::selectDocumentById(std::string_view documentId) {
     std::string target = std::format(
-        "/rest/v1/documents?external_id=eq.{}&select=id,external_id,title,document_sections(id,title,content)",
-        documentId
+        "/rest/v1/documents?external_id=eq.{}&select={}",
+        documentId,
+        postgrest::DOCUMENT_SELECT
     );
 
     http::request<http::string_body> requestToGetListDocumentSections{http::verb::get, target, 11};
@@ -146,23 +199,111 @@ asio::awaitable<std::optional<Document>> DataBaseSession::selectDocumentById(std
     setSupabaseHeaders(requestToGetListDocumentSections, config);
     requestToGetListDocumentSections.prepare_payload();
 
-    auto resToDocumentSections = co_await sendDatabaseRequest<http::string_body>(threadPool.get_executor(), std::move(requestToGetListDocumentSections));
+    auto resToDocumentSections = co_await sendRead(
+        std::format("document:{}", documentId), std::move(requestToGetListDocumentSections));
 
     if (const auto status = resToDocumentSections.result(); status != http::status::ok) {
         co_return std::nullopt;
     }
 
-    auto json = boost::json::parse(resToDocumentSections.body());
-    auto const& documents = json.as_array();
+    // An unreadable stored copy is a miss; the re-download's insert replaces its sections.
+    try {
+        co_return firstModel<postgrest::DocumentRow>("selectDocumentById", resToDocumentSections.body().view());
+    } catch (const std::exception& e) {
+        std::println(std::cerr, "selectDocumentById: document {} unreadable: {}", documentId, e.what());
+    }
+    co_return std::nullopt;
+}
 
-    if (documents.empty()) {
-        co_return std::nullopt;
+asio::awaitable<std::vector<Document>> RestDataBaseSession::selectDocumentsByIds(std::span<const std::string> documentIds) {
+    const auto prefix = std::format("/rest/v1/documents?select={}&external_id=in.", postgrest::DOCUMENT_SELECT);
+
+    std::vector<std::string> keys;
+    keys.reserve(documentIds.size());
+    for (auto const& id : documentIds) {
+        keys.push_back("document:" + id);
+    }
+
+    std::vector<Document> documents;
+    for (auto const& list : util::network::postgrestInLists(documentIds, MAX_TARGET_LENGTH - prefix.size())) {
+        http::request<http::string_body> req{http::verb::get, prefix + list, 11};
+        setSupabaseHeaders(req, config);
+        req.prepare_payload();
+
+        auto res = co_await sendRead(keys, std::move(req));
+        if (res.result() != http::status::ok) {
+            // Ids from a failed chunk count as misses and are downloaded again.
+            std::println(std::cerr, "selectDocumentsByIds failed: status={}", static_cast<unsigned>(res.result()));
+            continue;
+        }
+
+        auto rows = postgrest::decodeRows<postgrest::DocumentRow>(res.body().view());
+        if (!rows) {
+            std::println(std::cerr, "selectDocumentsByIds: unexpected response body");
+            continue;
+        }
+        // An unreadable stored copy is a miss; the re-download's insert replaces its sections.
+        for (auto& row : *rows) {
+            auto externalId = row.external_id;
+            try {
+                documents.push_back(postgrest::toModel(std::move(row)));
+            } catch (const std::exception& e) {
+                std::println(std::cerr, "selectDocumentsByIds: document {} unreadable: {}", externalId, e.what());
+            }
+        }
     }
 
-    co_return boost::json::value_to<Document>(documents.front());
+    co_return documents;
+}
+
+template <typename Row>
+asio::awaitable<std::optional<std::vector<std::string>>> RestDataBaseSession::selectColumn(
+    std::string_view method, std::string_view table, std::string_view filter, std::string_view column,
+    std::string Row::*field, bool onPrimary) {
+    std::vector<std::string> values;
+    while (true) {
+        auto target = std::format(
+            "{}/{}?{}select={}&order={}.asc&limit={}", baseUrl, table, filter, column, column, PAGE_ROWS);
+        if (!values.empty()) {
+            target += std::format("&{}=gt.{}", column, util::network::percentEncode(values.back()));
+        }
+
+        Request req{http::verb::get, target, 11};
+        setSupabaseHeaders(req, config);
+        req.prepare_payload();
+
+        Response res;
+        if (onPrimary) {
+            res = co_await sendDatabaseRequest<PooledBody>(threadPool.get_executor(), std::move(req));
+        } else {
+            res = co_await sendRead(std::span<const std::string> {}, std::move(req));
+        }
+        if (res.result() != http::status::ok) {
+            std::println(std::cerr, "{} failed: status={}", method, static_cast<unsigned>(res.result()));
+            co_return std::nullopt;
+        }
+
+        auto rows = postgrest::decodeRows<Row>(res.body().view());
+        if (!rows) {
+            std::println(std::cerr, "{}: unexpected response body", method);
+            co_return std::nullopt;
+        }
+        if (rows->empty()) {
+            co_return values;
+        }
+        for (auto& row : *rows) {
+            values.push_back(std::move(row.*field));
+        }
+    }
+}
 
+asio::awaitable<std::optional<std::vector<std::string>>> RestDataBaseSession::selectDocumentIds() {
+    // A cut-off list would pass stored documents off as new, so every page is read.
+    co_return co_await selectColumn<postgrest::DocumentIdRow>(
+        "selectDocumentIds", "documents", "", "external_id", &postgrest::DocumentIdRow::external_id, false);
 }
-asio::awaitable<bool> DataBaseSession::deleteDocument(std::string_view documentId) {
+
+asio::awaitable<bool> RestDataBaseSession::deleteDocument(std::string_view documentId) {
     std::string target = std::format(
         "/rest/v1/documents?external_id=eq.{}",
         documentId
@@ -173,13 +314,14 @@ asio::awaitable<bool> DataBaseSession::deleteDocument(std::string_view documentI
     setSupabaseHeaders(req, config);
     req.prepare_payload();
 
-    auto res = co_await sendDatabaseRequest<http::string_body>(threadPool.get_executor(), std::move(req));
+    auto res = co_await sendDatabaseRequest<PooledBody>(threadPool.get_executor(), std::move(req));
+    router_.wrote(std::format("document:{}", documentId));
     if (auto status = res.result(); status != http::status::ok && status != http::status::no_content) {
         co_return false;
     }
     co_return true;
 }
-asio::awaitable<bool> DataBaseSession::insertOAuthState(std::string_view stateHash, std::string_view expiresAt) {
+asio::awaitable<bool> RestDataBaseSession::insertOAuthState(std::string_view stateHash, std::string_view expiresAt) {
     std::string target = std::format(
         "/rest/v1/oauth_states"
     );
@@ -193,7 +335,7 @@ asio::awaitable<bool> DataBaseSession::insertOAuthState(std::string_view stateHa
     req.body() = boost::json::serialize(json);
     req.prepare_payload();
 
-    auto res = co_await sendDatabaseRequest<http::string_body>(threadPool.get_executor(), std::move(req));
+    auto res = co_await sendDatabaseRequest<PooledBody>(threadPool.get_executor(), std::move(req));
     if (auto status = res.result(); status != http::status::created && status != http::status::ok) {
         co_return false;
     }
@@ -201,9 +343,9 @@ asio::awaitable<bool> DataBaseSession::insertOAuthState(std::string_view stateHa
 }
 
 asio::awaitable<bool>
-DataBaseSession::consumeOAuthState(std::string_view stateHash, std::string_view consumedAt) {
+RestDataBaseSession::consumeOAuthState(std::string_view stateHash, std::string_view consumedAt) {
     std::string target = std::format(
-    "/rest/v1/oauth_states?state_hash=eq.{}&consumed_at=is.null&expires_at=gt.{}" ,
+    "/rest/v1/oauth_states?state_hash=eq.{}&consumed_at=is.null&expires_at=gt.{}&select=state_hash" ,
     stateHash,
     consumedAt
     );
@@ -217,23 +359,19 @@ DataBaseSession::consumeOAuthState(std::string_view stateHash, std::string_view
     req.body() = boost::json::serialize(json);
     req.prepare_payload();
 
-    auto res = co_await sendDatabaseRequest<http::string_body>(threadPool.get_executor(), std::move(req));
+    auto res = co_await sendDatabaseRequest<PooledBody>(threadPool.get_executor(), std::move(req));
     if (auto status = res.result(); status != http::status::created && status != http::status::ok) {
         co_return false;
     }
-    auto body = boost::json::parse(res.body());
-
-    auto arr = body.as_array();
-    if (arr.empty()) {
-        co_return false;
-    }
-    co_return true;
+    auto rows = postgrest::decodeRows<postgrest::OAuthStateRow>(res.body().view());
+    co_return rows && !rows->empty();
 
 }
-asio::awaitable<std::optional<AuthUser>> DataBaseSession::selectAuthUserByGoogleSub(std::string_view googleSub) {
+asio::awaitable<std::optional<AuthUser>> RestDataBaseSession::selectAuthUserByGoogleSub(std::string_view googleSub) {
     std::string target = std::format(
-        "/rest/v1/auth_users?google_sub=eq.{}&select=id,google_sub,email,name,picture_url",
-        googleSub
+        "/rest/v1/auth_users?google_sub=eq.{}&select={}",
+        googleSub,
+        postgrest::AUTH_USER_SELECT
     );
 
     http::request<http::string_body> req{http::verb::get, target, 11};
@@ -241,25 +379,21 @@ asio::awaitable<std::optional<AuthUser>> DataBaseSession::selectAuthUserByGoogle
     req.set("Prefer", "return=representation");
     req.prepare_payload();
 
-    auto res = co_await sendDatabaseRequest<http::string_body>(threadPool.get_executor(), std::move(req));
+    auto res = co_await sendRead(std::format("auth_user_sub:{}", googleSub), std::move(req));
     if (res.result() != http::status::ok) {
         co_return std::nullopt;
     }
 
-    auto users = boost::json::parse(res.body()).as_array();
-    if (users.empty()) {
-        co_return std::nullopt;
-    }
-
-    co_return authUserFromJson(users.front().as_object());
+    co_return firstModel<postgrest::AuthUserRow>("selectAuthUserByGoogleSub", res.body().view());
 }
 
-asio::awaitable<std::optional<AuthUser>> DataBaseSession::insertAuthUser(
+asio::awaitable<std::optional<AuthUser>> RestDataBaseSession::insertAuthUser(
     std::string_view googleSub, std::string_view email, std::string_view name, std::string_view pictureUrl,
     std::string_view lastLoginAt) {
 
     std::string target = std::format(
-        "/rest/v1/auth_users?select=id,google_sub,email,name,picture_url"
+        "/rest/v1/auth_users?select={}",
+        postgrest::AUTH_USER_SELECT
     );
 
     http::request<http::string_body> req{http::verb::post, target, 11};
@@ -276,31 +410,32 @@ asio::awaitable<std::optional<AuthUser>> DataBaseSession::insertAuthUser(
     req.set("Prefer", "return=representation");
     req.prepare_payload();
 
-    auto res = co_await sendDatabaseRequest<http::string_body>(threadPool.get_executor(), std::move(req));
+    auto res = co_await sendDatabaseRequest<PooledBody>(threadPool.get_executor(), std::move(req));
 
     if (auto status = res.result(); status != http::status::created && status != http::status::ok) {
         std::println(
             std::cerr,
             "insertAuthUser failed: status={}, body={}",
             static_cast<unsigned>(status),
-            res.body());
+            res.body().view());
         co_return std::nullopt;
     }
 
-    auto users = boost::json::parse(res.body()).as_array();
-    if (users.empty()) {
-        co_return std::nullopt;
+    auto user = firstModel<postgrest::AuthUserRow>("insertAuthUser", res.body().view());
+    router_.wrote(std::format("auth_user_sub:{}", googleSub));
+    if (user) {
+        router_.wrote("auth_user:" + user->id);
     }
-
-    co_return authUserFromJson(users.front().as_object());
+    co_return user;
 }
 
-asio::awaitable<std::optional<AuthUser>> DataBaseSession::updateAuthUserLogin(
+asio::awaitable<std::optional<AuthUser>> RestDataBaseSession::updateAuthUserLogin(
     std::string_view id, std::string_view email, std::string_view name, std::string_view pictureUrl,
     std::string_view lastLoginAt) {
     std::string target = std::format(
-        "/rest/v1/auth_users?id=eq.{}&select=id,google_sub,email,name,picture_url",
-        id
+        "/rest/v1/auth_users?id=eq.{}&select={}",
+        id,
+        postgrest::AUTH_USER_SELECT
     );
 
     http::request<http::string_body> req{http::verb::patch, target, 11};
@@ -317,20 +452,20 @@ asio::awaitable<std::optional<AuthUser>> DataBaseSession::updateAuthUserLogin(
     req.set("Prefer", "return=representation");
     req.prepare_payload();
 
-    auto res = co_await sendDatabaseRequest<http::string_body>(threadPool.get_executor(), std::move(req));
+    auto res = co_await sendDatabaseRequest<PooledBody>(threadPool.get_executor(), std::move(req));
     if (res.result() != http::status::ok) {
         co_return std::nullopt;
     }
 
-    auto users = boost::json::parse(res.body()).as_array();
-    if (users.empty()) {
-        co_return std::nullopt;
+    auto user = firstModel<postgrest::AuthUserRow>("updateAuthUserLogin", res.body().view());
+    router_.wrote(std::format("auth_user:{}", id));
+    if (user) {
+        router_.wrote("auth_user_sub:" + user->googleSub);
     }
-
-    co_return authUserFromJson(users.front().as_object());
+    co_return user;
 }
 
-asio::awaitable<bool> DataBaseSession::upsertGoogleOAuthTokens(const GoogleOAuthTokens& tokens) {
+asio::awaitable<bool> RestDataBaseSession::upsertGoogleOAuthTokens(const GoogleOAuthTokens& tokens) {
     http::request<http::string_body> req{
         http::verb::post,
         "/rest/v1/google_oauth_tokens?on_conflict=user_id",
@@ -352,42 +487,39 @@ asio::awaitable<bool> DataBaseSession::upsertGoogleOAuthTokens(const GoogleOAuth
     req.body() = boost::json::serialize(json);
     req.prepare_payload();
 
-    auto res = co_await sendDatabaseRequest<http::string_body>(threadPool.get_executor(), std::move(req));
+    auto res = co_await sendDatabaseRequest<PooledBody>(threadPool.get_executor(), std::move(req));
     if (!isWriteSuccess(res.result())) {
         std::println(
             std::cerr,
             "upsertGoogleOAuthTokens failed: status={}, body={}",
             static_cast<unsigned>(res.result()),
-            res.body());
+            res.body().view());
         co_return false;
     }
+    router_.wrote("tokens:" + tokens.userId);
     co_return true;
 }
 
-asio::awaitable<std::optional<GoogleOAuthTokens>> DataBaseSession::selectGoogleOAuthTokens(std::string_view userId) {
+asio::awaitable<std::optional<GoogleOAuthTokens>> RestDataBaseSession::selectGoogleOAuthTokens(std::string_view userId) {
     std::string target = std::format(
-        "/rest/v1/google_oauth_tokens?user_id=eq.{}&select=user_id,access_token_enc,refresh_token_enc,expires_at,scope,token_type",
-        userId
+        "/rest/v1/google_oauth_tokens?user_id=eq.{}&select={}",
+        userId,
+        postgrest::GOOGLE_OAUTH_TOKENS_SELECT
     );
 
     http::request<http::string_body> req{http::verb::get, target, 11};
     setSupabaseHeaders(req, config);
     req.prepare_payload();
 
-    auto res = co_await sendDatabaseRequest<http::string_body>(threadPool.get_executor(), std::move(req));
+    auto res = co_await sendRead(std::format("tokens:{}", userId), std::move(req));
     if (res.result() != http::status::ok) {
         co_return std::nullopt;
     }
 
-    auto rows = boost::json::parse(res.body()).as_array();
-    if (rows.empty()) {
-        co_return std::nullopt;
-    }
-
-    co_return googleOAuthTokensFromJson(rows.front().as_object());
+    co_return firstModel<postgrest::GoogleOAuthTokensRow>("selectGoogleOAuthTokens", res.body().view());
 }
 
-asio::awaitable<bool> DataBaseSession::insertAppSession(
+asio::awaitable<bool> RestDataBaseSession::insertAppSession(
     std::string_view id,
     std::string_view userId,
     std::string_view sessionHash,
@@ -408,45 +540,59 @@ asio::awaitable<bool> DataBaseSession::insertAppSession(
     req.body() = boost::json::serialize(json);
     req.prepare_payload();
 
-    auto res = co_await sendDatabaseRequest<http::string_body>(threadPool.get_executor(), std::move(req));
+    auto res = co_await sendDatabaseRequest<PooledBody>(threadPool.get_executor(), std::move(req));
+    router_.wrote(std::format("app_session:{}", sessionHash));
     if (!isWriteSuccess(res.result())) {
         std::println(
             std::cerr,
             "insertAppSession failed: status={}, body={}",
             static_cast<unsigned>(res.result()),
-            res.body());
+            res.body().view());
         co_return false;
     }
     co_return true;
 }
 
-asio::awaitable<std::optional<AppSession>> DataBaseSession::selectActiveAppSession(
+asio::awaitable<AppSessionLookup> RestDataBaseSession::selectActiveAppSession(
     std::string_view sessionHash,
     std::string_view now) {
     std::string target = std::format(
-        "/rest/v1/app_sessions?session_hash=eq.{}&revoked_at=is.null&expires_at=gt.{}&select=id,user_id,session_hash,expires_at,revoked_at",
+        "/rest/v1/app_sessions?session_hash=eq.{}&revoked_at=is.null&expires_at=gt.{}&select={}",
         sessionHash,
-        now
+        now,
+        postgrest::APP_SESSION_SELECT
     );
 
     http::request<http::string_body> req{http::verb::get, target, 11};
     setSupabaseHeaders(req, config);
     req.prepare_payload();
 
-    auto res = co_await sendDatabaseRequest<http::string_body>(threadPool.get_executor(), std::move(req));
-    if (res.result() != http::status::ok) {
-        co_return std::nullopt;
+    std::optional<Response> res;
+    try {
+        // Always the primary: stickiness is per process, so a session created on another instance
+        // could still be missing on a replica, and a miss here is negatively cached.
+        res = co_await sendReadTo(router_.primary(), std::move(req));
+    } catch (const std::exception& e) {
+        std::println(std::cerr, "selectActiveAppSession failed: {}", e.what());
+        co_return std::unexpected(LookupFailed {});
     }
-
-    auto rows = boost::json::parse(res.body()).as_array();
-    if (rows.empty()) {
-        co_return std::nullopt;
+    if (res->result() != http::status::ok) {
+        std::println(std::cerr, "selectActiveAppSession failed: status={}", static_cast<unsigned>(res->result()));
+        co_return std::unexpected(LookupFailed {});
     }
 
-    co_return appSessionFromJson(rows.front().as_object());
+    auto rows = postgrest::decodeRows<postgrest::AppSessionRow>(res->body().view());
+    if (!rows) {
+        std::println(std::cerr, "selectActiveAppSession: unexpected response body");
+        co_return std::unexpected(LookupFailed {});
+    }
+    if (rows->empty()) {
+        co_return AppSessionLookup { std::nullopt };
+    }
+    co_return AppSessionLookup { postgrest::toModel(std::move(rows->front())) };
 }
 
-asio::awaitable<bool> DataBaseSession::revokeAppSession(std::string_view sessionHash, std::string_view revokedAt) {
+asio::awaitable<bool> RestDataBaseSession::revokeAppSession(std::string_view sessionHash, std::string_view revokedAt) {
     std::string target = std::format("/rest/v1/app_sessions?session_hash=eq.{}", sessionHash);
 
     http::request<http::string_body> req{http::verb::patch, target, 11};
@@ -458,11 +604,12 @@ asio::awaitable<bool> DataBaseSession::revokeAppSession(std::string_view session
     req.body() = boost::json::serialize(json);
     req.prepare_payload();
 
-    auto res = co_await sendDatabaseRequest<http::string_body>(threadPool.get_executor(), std::move(req));
+    auto res = co_await sendDatabaseRequest<PooledBody>(threadPool.get_executor(), std::move(req));
+    router_.wrote(std::format("app_session:{}", sessionHash));
     co_return isWriteSuccess(res.result());
 }
 
-asio::awaitable<bool> DataBaseSession::updateAppSessionLastSeen(
+asio::awaitable<bool> RestDataBaseSession::updateAppSessionLastSeen(
     std::string_view sessionHash,
     std::string_view lastSeenAt) {
     std::string target = std::format("/rest/v1/app_sessions?session_hash=eq.{}", sessionHash);
@@ -476,13 +623,45 @@ asio::awaitable<bool> DataBaseSession::updateAppSessionLastSeen(
     req.body() = boost::json::serialize(json);
     req.prepare_payload();
 
-    auto res = co_await sendDatabaseRequest<http::string_body>(threadPool.get_executor(), std::move(req));
+    auto res = co_await sendDatabaseRequest<PooledBody>(threadPool.get_executor(), std::move(req));
+    co_return isWriteSuccess(res.result());
+}
+
+asio::awaitable<bool> RestDataBaseSession::updateAppSessionsLastSeen(std::span<const SessionLastSeen> sessions) {
+    if (sessions.empty()) {
+        co_return true;
+    }
+
+    // sql/touch_app_sessions.sql
+    boost::json::array sessionsJson;
+    sessionsJson.reserve(sessions.size());
+    for (auto const& session : sessions) {
+        sessionsJson.emplace_back(boost::json::object {
+            {"session_hash", session.sessionHash},
+            {"last_seen_at", session.lastSeenAt},
+        });
+    }
+
+    http::request<http::string_body> req{http::verb::post, baseUrl + "/rpc/touch_app_sessions", 11};
+    req.body() = boost::json::serialize(boost::json::object {{"sessions", std::move(sessionsJson)}});
+    setSupabaseHeaders(req, config);
+    req.prepare_payload();
+
+    auto res = co_await sendDatabaseRequest<PooledBody>(threadPool.get_executor(), std::move(req));
     co_return isWriteSuccess(res.result());
 }
 
-asio::awaitable<std::optional<AuthUser>> DataBaseSession::selectAuthUserById(std::string_view userId) {
+asio::awaitable<std::optional<std::vector<std::string>>> RestDataBaseSession::selectRevokedSessionHashes(
+    std::string_view now) {
+    // Revocations must not lag behind a replica, so every page comes from the primary.
+    co_return co_await selectColumn<postgrest::SessionHashRow>(
+        "selectRevokedSessionHashes", "app_sessions", std::format("revoked_at=not.is.null&expires_at=gt.{}&", now),
+        "session_hash", &postgrest::SessionHashRow::session_hash, true);
+}
+
+asio::awaitable<std::optional<AuthUser>> RestDataBaseSession::selectAuthUserById(std::string_view userId) {
     auto target = std::format(
-    "/rest/v1/auth_users?id=eq.{}&select=*", userId
+    "/rest/v1/auth_users?id=eq.{}&select={}", userId, postgrest::AUTH_USER_SELECT
     );
 
     http::request<http::string_body> req{http::verb::get, target, 11};
@@ -490,17 +669,12 @@ asio::awaitable<std::optional<AuthUser>> DataBaseSession::selectAuthUserById(std
     req.set("Prefer", "return=representation");
     req.prepare_payload();
 
-    auto res = co_await sendDatabaseRequest<http::string_body>(threadPool.get_executor(), std::move(req));
+    auto res = co_await sendRead(std::format("auth_user:{}", userId), std::move(req));
     if (res.result() != http::status::ok) {
         co_return std::nullopt;
     }
 
-    auto users = boost::json::parse(res.body()).as_array();
-    if (users.empty()) {
-        co_return std::nullopt;
-    }
-
-    co_return authUserFromJson(users.front().as_object());
+    co_return firstModel<postgrest::AuthUserRow>("selectAuthUserById", res.body().view());
 }
 
 }   // namespace Network
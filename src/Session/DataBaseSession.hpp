@@ -1,12 +1,16 @@
 #pragma once
+#include "Session/PooledBody.hpp"
+#include "Session/ReadRouter.hpp"
 #include "Session/SslSession.hpp"
 #include "Models/Document.hpp"
 #include "Util/ConfigParser.hpp"
 
 #include <boost/asio/awaitable.hpp>
 
+#include <expected>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string_view>
 #include <vector>
 
@@ -37,54 +41,152 @@ struct AppSession {
     std::optional<std::string> revokedAt;
 };
 
+// A lookup that could not be answered (transport error, 5xx, undecodable body), as opposed to
+// one that found no row.
+struct LookupFailed {};
+
+using AppSessionLookup = std::expected<std::optional<AppSession>, LookupFailed>;
+
+struct SessionLastSeen {
+    std::string sessionHash;
+    std::string lastSeenAt;
+};
+
+// Storage used by the server. RestDataBaseSession talks to Supabase through PostgREST;
+// PgDataBaseSession talks to PostgreSQL directly. DATABASE_BACKEND picks one at start-up.
 class DataBaseSession {
 public:
-    DataBaseSession();
+    virtual ~DataBaseSession() = default;
 
-    boost::asio::awaitable<bool> insertDocument(const Document& document);
-    boost::asio::awaitable<std::optional<Document>> selectDocumentById(std::string_view documentId);
-    boost::asio::awaitable<bool> deleteDocument(std::string_view documentId);
+    virtual boost::asio::awaitable<bool> insertDocument(const Document& document) = 0;
+    // All of `documents` and their sections in one transaction; false if nothing was written.
+    // A document already stored keeps its row and has its sections replaced.
+    virtual boost::asio::awaitable<bool> insertDocuments(std::span<const Document> documents) = 0;
+    virtual boost::asio::awaitable<std::optional<Document>> selectDocumentById(std::string_view documentId) = 0;
+    // Documents stored under any of `documentIds`, in no particular order; missing ids are skipped.
+    virtual boost::asio::awaitable<std::vector<Document>> selectDocumentsByIds(std::span<const std::string> documentIds) = 0;
+    // Every stored document id; empty if the full list could not be read.
+    virtual boost::asio::awaitable<std::optional<std::vector<std::string>>> selectDocumentIds() = 0;
+    // Whether document writes are announced on the invalidation channel, so other instances'
+    // document filters hear of them.
+    virtual bool notifiesDocumentWrites() const = 0;
+    virtual boost::asio::awaitable<bool> deleteDocument(std::string_view documentId) = 0;
 
-    boost::asio::awaitable<bool> insertOAuthState(std::string_view stateHash, std::string_view expiresAt);
-    boost::asio::awaitable<bool> consumeOAuthState(std::string_view stateHash, std::string_view consumedAt);
+    virtual boost::asio::awaitable<bool> insertOAuthState(std::string_view stateHash, std::string_view expiresAt) = 0;
+    virtual boost::asio::awaitable<bool> consumeOAuthState(std::string_view stateHash, std::string_view consumedAt) = 0;
 
-    boost::asio::awaitable<std::optional<AuthUser>> selectAuthUserByGoogleSub(std::string_view googleSub);
+    virtual boost::asio::awaitable<std::optional<AuthUser>> selectAuthUserByGoogleSub(std::string_view googleSub) = 0;
+    virtual boost::asio::awaitable<std::optional<AuthUser>> insertAuthUser(
+        std::string_view googleSub,
+        std::string_view email,
+        std::string_view name,
+        std::string_view pictureUrl,
+        std::string_view lastLoginAt) = 0;
+    virtual boost::asio::awaitable<std::optional<AuthUser>> updateAuthUserLogin(
+        std::string_view id,
+        std::string_view email,
+        std::string_view name,
+        std::string_view pictureUrl,
+        std::string_view lastLoginAt) = 0;
+
+    virtual boost::asio::awaitable<bool> upsertGoogleOAuthTokens(const GoogleOAuthTokens& tokens) = 0;
+    virtual boost::asio::awaitable<std::optional<GoogleOAuthTokens>> selectGoogleOAuthTokens(std::string_view userId) = 0;
+
+    virtual boost::asio::awaitable<bool> insertAppSession(
+        std::string_view id,
+        std::string_view userId,
+        std::string_view sessionHash,
+        std::string_view expiresAt,
+        std::string_view userAgent) = 0;
+    // An empty optional when no active session has the hash; LookupFailed when nobody could say.
+    virtual boost::asio::awaitable<AppSessionLookup> selectActiveAppSession(
+        std::string_view sessionHash,
+        std::string_view now) = 0;
+    virtual boost::asio::awaitable<bool> revokeAppSession(std::string_view sessionHash, std::string_view revokedAt) = 0;
+    virtual boost::asio::awaitable<bool> updateAppSessionLastSeen(std::string_view sessionHash, std::string_view lastSeenAt) = 0;
+    virtual boost::asio::awaitable<bool> updateAppSessionsLastSeen(std::span<const SessionLastSeen> sessions) = 0;
+    // Hashes of revoked sessions that expire after `now`; empty if the full list could not be read.
+    virtual boost::asio::awaitable<std::optional<std::vector<std::string>>> selectRevokedSessionHashes(std::string_view now) = 0;
+
+    virtual boost::asio::awaitable<std::optional<AuthUser>> selectAuthUserById(std::string_view userId) = 0;
+};
+
+// Supabase PostgREST over HTTPS.
+class RestDataBaseSession : public DataBaseSession {
+public:
+    RestDataBaseSession();
+
+    boost::asio::awaitable<bool> insertDocument(const Document& document) override;
+    boost::asio::awaitable<bool> insertDocuments(std::span<const Document> documents) override;
+    boost::asio::awaitable<std::optional<Document>> selectDocumentById(std::string_view documentId) override;
+    boost::asio::awaitable<std::vector<Document>> selectDocumentsByIds(std::span<const std::string> documentIds) override;
+    boost::asio::awaitable<std::optional<std::vector<std::string>>> selectDocumentIds() override;
+    bool notifiesDocumentWrites() const override { return false; }
+    boost::asio::awaitable<bool> deleteDocument(std::string_view documentId) override;
+
+    boost::asio::awaitable<bool> insertOAuthState(std::string_view stateHash, std::string_view expiresAt) override;
+    boost::asio::awaitable<bool> consumeOAuthState(std::string_view stateHash, std::string_view consumedAt) override;
+
+    boost::asio::awaitable<std::optional<AuthUser>> selectAuthUserByGoogleSub(std::string_view googleSub) override;
     boost::asio::awaitable<std::optional<AuthUser>> insertAuthUser(
         std::string_view googleSub,
         std::string_view email,
         std::string_view name,
         std::string_view pictureUrl,
-        std::string_view lastLoginAt);
+        std::string_view lastLoginAt) override;
     boost::asio::awaitable<std::optional<AuthUser>> updateAuthUserLogin(
         std::string_view id,
         std::string_view email,
         std::string_view name,
         std::string_view pictureUrl,
-        std::string_view lastLoginAt);
+        std::string_view lastLoginAt) override;
 
-    boost::asio::awaitable<bool> upsertGoogleOAuthTokens(const GoogleOAuthTokens& tokens);
-    boost::asio::awaitable<std::optional<GoogleOAuthTokens>> selectGoogleOAuthTokens(std::string_view userId);
+    boost::asio::awaitable<bool> upsertGoogleOAuthTokens(const GoogleOAuthTokens& tokens) override;
+    boost::asio::awaitable<std::optional<GoogleOAuthTokens>> selectGoogleOAuthTokens(std::string_view userId) override;
 
     boost::asio::awaitable<bool> insertAppSession(
         std::string_view id,
         std::string_view userId,
         std::string_view sessionHash,
         std::string_view expiresAt,
-        std::string_view userAgent);
-    boost::asio::awaitable<std::optional<AppSession>> selectActiveAppSession(
+        std::string_view userAgent) override;
+    boost::asio::awaitable<AppSessionLookup> selectActiveAppSession(
         std::string_view sessionHash,
-        std::string_view now);
-    boost::asio::awaitable<bool> revokeAppSession(std::string_view sessionHash, std::string_view revokedAt);
-    boost::asio::awaitable<bool> updateAppSessionLastSeen(std::string_view sessionHash, std::string_view lastSeenAt);
+        std::string_view now) override;
+    boost::asio::awaitable<bool> revokeAppSession(std::string_view sessionHash, std::string_view revokedAt) override;
+    boost::asio::awaitable<bool> updateAppSessionLastSeen(std::string_view sessionHash, std::string_view lastSeenAt) override;
+    boost::asio::awaitable<bool> updateAppSessionsLastSeen(std::span<const SessionLastSeen> sessions) override;
+    boost::asio::awaitable<std::optional<std::vector<std::string>>> selectRevokedSessionHashes(std::string_view now) override;
 
-    boost::asio::awaitable<std::optional<AuthUser>> selectAuthUserById(std::string_view userId);
+    boost::asio::awaitable<std::optional<AuthUser>> selectAuthUserById(std::string_view userId) override;
 
 private:
+    using Request = boost::beast::http::request<boost::beast::http::string_body>;
+    using Response = boost::beast::http::response<PooledBody>;
+
+    // Reads may go to a SUPABASE_READ_HOSTS endpoint; `key` (or any of `keys`) written within
+    // the stickiness window keeps the read on SUPABASE_HOST.
+    boost::asio::awaitable<Response> sendRead(std::string_view key, Request req);
+    boost::asio::awaitable<Response> sendRead(std::span<const std::string> keys, Request req);
+    boost::asio::awaitable<Response> sendReadTo(std::string endpoint, Request req);
+    // One column of every row matching `filter`, in keyset pages of PAGE_ROWS ordered by `column`,
+    // so PostgREST's db-max-rows cannot cut the result short. Empty if any page fails.
+    template <typename Row>
+    boost::asio::awaitable<std::optional<std::vector<std::string>>> selectColumn(
+        std::string_view method, std::string_view table, std::string_view filter, std::string_view column,
+        std::string Row::*field, bool onPrimary);
+    boost::asio::awaitable<std::optional<std::chrono::microseconds>> probe(std::string endpoint);
+
+    Util::ConfigParser config;
+    ReadRouter router_;
+
     boost::asio::thread_pool threadPool{
         std::max(1u, std::thread::hardware_concurrency() / 2)
     };
-    Util::ConfigParser config;
 
     std::string baseUrl = "/rest/v1";
 };
+
+// Backend named by DATABASE_BACKEND: "rest" (default) or "postgres".
+std::shared_ptr<DataBaseSession> makeDataBaseSession(const Util::ConfigParser& config);
 }
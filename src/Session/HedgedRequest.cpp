@@ -0,0 +1,47 @@
+#include "HedgedRequest.hpp"
+
+#include "Util/ConfigParser.hpp"
+
+#include <algorithm>
+
+namespace Network {
+
+HedgeBudget& HedgeBudget::instance() {
+    static HedgeBudget budget = [] {
+        Util::ConfigParser config;
+        return HedgeBudget(
+            config.flag("HEDGE_REQUESTS"),
+            config.number("HEDGE_BUDGET_PERCENT", 5.0) / 100.0,
+            config.number("HEDGE_BUDGET_BURST", 10.0));
+    }();
+    return budget;
+}
+
+HedgeBudget::HedgeBudget(bool enabled, double ratio, double maxTokens)
+  : enabled_(enabled), ratio_(ratio), maxTokens_(maxTokens) {}
+
+void HedgeBudget::onRequest() {
+    std::lock_guard lock(mutex_);
+    tokens_ = std::min(maxTokens_, tokens_ + ratio_);
+}
+
+bool HedgeBudget::tryAcquire() {
+    std::lock_guard lock(mutex_);
+    if (tokens_ < 1.0) {
+        return false;
+    }
+    tokens_ -= 1.0;
+    return true;
+}
+
+std::optional<std::chrono::microseconds> hedgeDelay(std::string_view upstream, std::string_view requestClass) {
+    auto& latency = UpstreamLatency::instance();
+    auto response = latency.request(upstream, requestClass).quantile(0.95);
+    auto connect = latency.connect(upstream).quantile(0.95);
+    if (!response || !connect) {
+        return std::nullopt;
+    }
+    return *response + *connect;
+}
+
+}   // namespace Network
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "Session/AdaptiveTimeout.hpp"
+#include "Session/RetryPolicy.hpp"
+#include "Session/UpstreamLatency.hpp"
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/cancellation_type.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/deferred.hpp>
+#include <boost/asio/experimental/parallel_group.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/beast/http.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace Network {
+
+// Global allowance for hedged attempts: every primary request credits `ratio` of a token,
+// every hedge spends one, so hedges stay within a fixed share of upstream traffic.
+class HedgeBudget {
+public:
+    static HedgeBudget& instance();
+
+    HedgeBudget(bool enabled, double ratio, double maxTokens);
+
+    bool enabled() const { return enabled_; }
+
+    void onRequest();
+    bool tryAcquire();
+
+private:
+    bool enabled_;
+    double ratio_;
+    double maxTokens_;
+
+    std::mutex mutex_;
+    double tokens_ = 0;
+};
+
+struct HedgeSkipped : std::runtime_error {
+    HedgeSkipped() : std::runtime_error("Hedge budget exhausted") {}
+};
+
+namespace detail {
+
+struct HedgeState {
+    std::atomic<bool> primaryFailed { false };
+    std::atomic<bool> hedgeSent { false };
+};
+
+template <typename Attempt>
+auto primaryAttempt(Attempt attempt, std::shared_ptr<HedgeState> state) -> decltype(attempt()) {
+    try {
+        co_return co_await attempt();
+    } catch (...) {
+        state->primaryFailed = true;
+        throw;
+    }
+}
+
+template <typename Attempt>
+auto delayedAttempt(std::chrono::microseconds delay, Attempt attempt, std::shared_ptr<HedgeState> state)
+    -> decltype(attempt()) {
+    boost::asio::steady_timer timer { co_await boost::asio::this_coro::executor, delay };
+    co_await timer.async_wait(boost::asio::use_awaitable);
+
+    if (!HedgeBudget::instance().tryAcquire()) {
+        throw HedgeSkipped {};
+    }
+    state->hedgeSent = true;
+    co_return co_await attempt();
+}
+
+}   // namespace detail
+
+// How long to wait for the primary attempt before hedging: the p95 of this request class plus the
+// p95 connect time of the upstream, since every attempt opens its own connection and the hedge pays
+// DNS, TCP and TLS again before it can send. Nullopt while either histogram lacks samples.
+std::optional<std::chrono::microseconds> hedgeDelay(std::string_view upstream, std::string_view requestClass);
+
+// Runs `attempt` and, when it has not answered within hedgeDelay(), races a second attempt against
+// it. The first successful response wins and the other one is cancelled. A primary that fails
+// before the hedge went out ends the race: the pending hedge is cancelled and the primary's error
+// rethrown, since `attempt` has already retried what was worth retrying. A hedge already in
+// flight is still awaited. Only use for idempotent requests with small bodies; `attempt` must
+// open its own connection on every call.
+template <typename Attempt>
+auto sendHedged(std::string_view upstream, std::string_view requestClass, Attempt attempt) -> decltype(attempt()) {
+    namespace asio = boost::asio;
+    namespace X = boost::asio::experimental;
+
+    auto& budget = HedgeBudget::instance();
+    if (!budget.enabled()) {
+        co_return co_await attempt();
+    }
+
+    budget.onRequest();
+
+    auto delay = hedgeDelay(upstream, requestClass);
+    if (!delay) {
+        co_return co_await attempt();
+    }
+
+    auto executor = co_await asio::this_coro::executor;
+    auto state = std::make_shared<detail::HedgeState>();
+
+    // Like wait_for_one_success, but a failed primary also ends the group while the hedge is pending.
+    auto done = [state](std::exception_ptr error, const auto&...) {
+        return !error || (state->primaryFailed && !state->hedgeSent) ? asio::cancellation_type::all
+                                                                     : asio::cancellation_type::none;
+    };
+
+    auto [order, primaryError, primary, hedgeError, hedged] =
+        co_await X::make_parallel_group(
+            asio::co_spawn(executor, detail::primaryAttempt(attempt, state), asio::deferred),
+            asio::co_spawn(executor, detail::delayedAttempt(*delay, attempt, state), asio::deferred))
+            .async_wait(done, asio::use_awaitable);
+
+    if (!primaryError) {
+        co_return std::move(primary);
+    }
+    if (!hedgeError) {
+        co_return std::move(hedged);
+    }
+    std::rethrow_exception(primaryError);
+}
+
+template <typename Session, typename Body>
+boost::asio::awaitable<boost::beast::http::response<Body>> sendOnce(
+    boost::asio::any_io_executor executor, boost::beast::http::request<boost::beast::http::string_body> req,
+    Deadline deadline = std::nullopt) {
+    auto session = std::make_shared<Session>(executor);
+    session->setDeadline(deadline);
+    co_return co_await sendWithRetry<Body>(*session, std::move(req));
+}
+
+template <typename Session, typename Body>
+boost::asio::awaitable<boost::beast::http::response<Body>> sendHedged(
+    boost::asio::any_io_executor executor, boost::beast::http::request<boost::beast::http::string_body> req,
+    std::string_view defaultPort, Deadline deadline = std::nullopt) {
+    auto upstream = upstreamKey(std::string(req[boost::beast::http::field::host]), defaultPort);
+    auto kind = requestClass(std::string(req.method_string()), std::string(req.target()));
+    co_return co_await sendHedged(upstream, kind, [executor, req = std::move(req), deadline] {
+        return sendOnce<Session, Body>(executor, req, deadline);
+    });
+}
+
+}   // namespace Network
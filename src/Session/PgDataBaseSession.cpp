@@ -0,0 +1,512 @@
+#include "PgDataBaseSession.hpp"
+
+#include "Cache/Invalidation.hpp"
+#include "Util/ConfigParser.hpp"
+
+#include <algorithm>
+#include <format>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+constexpr std::string_view AUTH_USER_COLUMNS = "id::text, google_sub, email, name, picture_url";
+
+struct Statement {
+    const char* name;
+    std::string sql;
+};
+
+// Timestamps are selected as the JSON text of the column, which is how PostgREST renders them,
+// so callers see the same strings from either backend.
+std::vector<Statement> preparedStatements() {
+    return {
+        { "insert_document",
+          "insert into documents (external_id, title) values ($1, $2) "
+          "on conflict (external_id) do update set title = excluded.title returning id" },
+        { "insert_documents",
+          "insert into documents (external_id, title) "
+          "select distinct on (e) e, t from unnest($1::text[], $2::text[]) as u(e, t) "
+          "on conflict (external_id) do update set title = excluded.title returning id, external_id" },
+        // Run after the upsert, which waits for a concurrent insert of the same document to commit,
+        // so its sections are visible here and are replaced rather than doubled.
+        { "delete_document_sections",
+          "delete from document_sections s using documents d "
+          "where s.document_id = d.id and d.external_id = any($1::text[])" },
+        { "insert_document_sections",
+          "insert into document_sections (document_id, title, content, content_zstd) "
+          "select $1, s.title, s.content, s.content_zstd "
+          "from unnest($2::text[], $3::text[], $4::bytea[]) as s(title, content, content_zstd)" },
+        { "select_document",
+          "select s.title, s.content, s.content_zstd from documents d "
+          "left join document_sections s on s.document_id = d.id "
+          "where d.external_id = $1 order by s.id" },
+        { "select_documents",
+          "select d.external_id, s.title, s.content, s.content_zstd from documents d "
+          "left join document_sections s on s.document_id = d.id "
+          "where d.external_id = any($1::text[]) order by d.external_id, s.id" },
+        { "select_document_ids", "select external_id from documents" },
+        { "delete_document", "delete from documents where external_id = $1" },
+        { "insert_oauth_state", "insert into oauth_states (state_hash, expires_at) values ($1, $2)" },
+        { "consume_oauth_state",
+          "update oauth_states set consumed_at = $2 "
+          "where state_hash = $1 and consumed_at is null and expires_at > $2" },
+        { "select_auth_user_by_google_sub",
+          std::format("select {} from auth_users where google_sub = $1", AUTH_USER_COLUMNS) },
+        { "select_auth_user_by_id", std::format("select {} from auth_users where id = $1", AUTH_USER_COLUMNS) },
+        { "insert_auth_user",
+          std::format("insert into auth_users (google_sub, email, name, picture_url, last_login_at) "
+                      "values ($1, $2, $3, $4, $5) returning {}",
+                      AUTH_USER_COLUMNS) },
+        { "update_auth_user_login",
+          std::format("update auth_users set email = $2, name = $3, picture_url = $4, last_login_at = $5, "
+                      "updated_at = $5 where id = $1 returning {}",
+                      AUTH_USER_COLUMNS) },
+        { "upsert_google_oauth_tokens",
+          "insert into google_oauth_tokens (user_id, access_token_enc, refresh_token_enc, expires_at, scope, token_type) "
+          "values ($1, $2, $3, $4, $5, $6) on conflict (user_id) do update set "
+          "access_token_enc = excluded.access_token_enc, "
+          "refresh_token_enc = coalesce(excluded.refresh_token_enc, google_oauth_tokens.refresh_token_enc), "
+          "expires_at = excluded.expires_at, scope = excluded.scope, token_type = excluded.token_type" },
+        { "select_google_oauth_tokens",
+          "select user_id::text, access_token_enc, refresh_token_enc, to_json(expires_at) #>> '{}', scope, token_type "
+          "from google_oauth_tokens where user_id = $1" },
+        { "insert_app_session",
+          "insert into app_sessions (user_id, session_hash, expires_at, user_agent) values ($1, $2, $3, $4)" },
+        { "insert_app_session_with_id",
+          "insert into app_sessions (id, user_id, session_hash, expires_at, user_agent) values ($1, $2, $3, $4, $5)" },
+        { "select_active_app_session",
+          "select id::text, user_id::text, session_hash, to_json(expires_at) #>> '{}', to_json(revoked_at) #>> '{}' "
+          "from app_sessions where session_hash = $1 and revoked_at is null and expires_at > $2" },
+        { "revoke_app_session", "update app_sessions set revoked_at = $2 where session_hash = $1" },
+        { "select_revoked_session_hashes",
+          "select session_hash from app_sessions where revoked_at is not null and expires_at > $1" },
+        { "update_app_session_last_seen", "update app_sessions set last_seen_at = $2 where session_hash = $1" },
+        { "update_app_sessions_last_seen",
+          "update app_sessions set last_seen_at = touched.last_seen_at::timestamptz "
+          "from unnest($1::text[], $2::text[]) as touched(session_hash, last_seen_at) "
+          "where app_sessions.session_hash = touched.session_hash" },
+        { "notify_invalidation", std::format("select pg_notify('{}', $1)", Cache::INVALIDATION_CHANNEL) },
+    };
+}
+
+std::string text(const pqxx::field& field) { return field.is_null() ? std::string {} : field.as<std::string>(); }
+
+std::optional<std::string> optionalText(const pqxx::field& field) {
+    if (field.is_null()) {
+        return std::nullopt;
+    }
+    return field.as<std::string>();
+}
+
+std::optional<pqxx::bytes> optionalBytes(const std::optional<std::string>& data) {
+    if (!data) {
+        return std::nullopt;
+    }
+    return pqxx::bytes(pqxx::binary_cast(*data));
+}
+
+// `content` and `content_zstd` of a document_sections row.
+std::string sectionText(const pqxx::field& content, const pqxx::field& compressed) {
+    std::optional<pqxx::bytes> frame;
+    if (!compressed.is_null()) {
+        frame = compressed.as<pqxx::bytes>();
+    }
+    return Documents::loadContent(
+        content.is_null() ? std::nullopt : std::optional<std::string_view> { content.view() },
+        frame.transform([](const pqxx::bytes& bytes) {
+            return std::string_view { reinterpret_cast<const char*>(bytes.data()), bytes.size() };
+        }));
+}
+
+// Queued with the transaction: other instances hear of the change only if it commits.
+void notifyInvalidation(pqxx::work& tx, Cache::Invalidation::Kind kind, std::string_view key) {
+    tx.exec_prepared("notify_invalidation", Cache::encodeInvalidation({ .kind = kind, .key = std::string(key) }));
+}
+
+std::optional<Network::AuthUser> authUserFromResult(const pqxx::result& rows) {
+    if (rows.empty()) {
+        return std::nullopt;
+    }
+    const auto& row = rows.front();
+    return Network::AuthUser {
+        .id = text(row[0]),
+        .googleSub = text(row[1]),
+        .email = text(row[2]),
+        .name = text(row[3]),
+        .pictureUrl = text(row[4]),
+    };
+}
+
+}   // namespace
+
+namespace Network {
+
+PgConnectionPool::Lease::~Lease() {
+    if (pool_ != nullptr) {
+        pool_->release(std::move(connection_));
+    }
+}
+
+PgConnectionPool::PgConnectionPool(std::string connectionString, std::size_t size)
+  : connectionString_(std::move(connectionString)), size_(std::max<std::size_t>(1, size)) {}
+
+PgConnectionPool::Lease PgConnectionPool::acquire() {
+    std::unique_lock lock(mutex_);
+    available_.wait(lock, [this] { return !idle_.empty() || opened_ < size_; });
+
+    if (!idle_.empty()) {
+        auto connection = std::move(idle_.back());
+        idle_.pop_back();
+        return Lease { *this, std::move(connection) };
+    }
+
+    ++opened_;
+    lock.unlock();
+    try {
+        return Lease { *this, open() };
+    } catch (...) {
+        release(nullptr);
+        throw;
+    }
+}
+
+std::unique_ptr<pqxx::connection> PgConnectionPool::open() const {
+    auto connection = std::make_unique<pqxx::connection>(connectionString_);
+    pqxx::nontransaction { *connection }.exec("set time zone 'UTC'");
+    for (const auto& statement : preparedStatements()) {
+        connection->prepare(statement.name, statement.sql);
+    }
+    return connection;
+}
+
+void PgConnectionPool::release(std::unique_ptr<pqxx::connection> connection) {
+    {
+        std::lock_guard lock(mutex_);
+        if (connection && connection->is_open()) {
+            idle_.push_back(std::move(connection));
+        } else {
+            --opened_;
+        }
+    }
+    available_.notify_one();
+}
+
+const PgDataBaseSession::Options& PgDataBaseSession::Options::defaults() {
+    static const Options options = [] {
+        Util::ConfigParser config;
+        Options result;
+        result.poolSize = static_cast<std::size_t>(config.number("PG_POOL_SIZE", result.poolSize));
+        return result;
+    }();
+    return options;
+}
+
+// One thread per connection, so a query never waits for a connection while holding a thread.
+PgDataBaseSession::PgDataBaseSession(std::string connectionString, Options options)
+  : pool_(std::move(connectionString), options.poolSize), threadPool_(std::max<std::size_t>(1, options.poolSize)) {}
+
+boost::asio::awaitable<bool> PgDataBaseSession::insertDocument(const Document& document) {
+    co_return co_await query<bool>("insertDocument", [&document](pqxx::work& tx) {
+        const auto& title = document.text.empty() ? document.docId : document.text.front().title;
+        auto documentId = tx.exec_prepared1("insert_document", document.docId, title)[0].as<std::string>();
+        tx.exec_prepared0("delete_document_sections", std::vector { document.docId });
+        notifyInvalidation(tx, Cache::Invalidation::Kind::Document, document.docId);
+
+        if (document.text.empty()) {
+            return true;
+        }
+
+        std::vector<std::string> titles;
+        std::vector<std::optional<std::string>> contents;
+        std::vector<std::optional<pqxx::bytes>> frames;
+        titles.reserve(document.text.size());
+        contents.reserve(document.text.size());
+        frames.reserve(document.text.size());
+        for (const auto& paragraph : document.text) {
+            auto stored = Documents::storeContent(paragraph.text);
+            titles.push_back(paragraph.title);
+            contents.push_back(std::move(stored.content));
+            frames.push_back(optionalBytes(stored.compressed));
+        }
+        tx.exec_prepared0("insert_document_sections", documentId, titles, contents, frames);
+        return true;
+    }, false);
+}
+
+// Document rows go in with one statement; their sections are streamed with COPY.
+boost::asio::awaitable<bool> PgDataBaseSession::insertDocuments(std::span<const Document> documents) {
+    if (documents.empty()) {
+        co_return true;
+    }
+
+    co_return co_await query<bool>("insertDocuments", [documents](pqxx::work& tx) {
+        std::vector<std::string> externalIds;
+        std::vector<std::string> titles;
+        externalIds.reserve(documents.size());
+        titles.reserve(documents.size());
+        for (const auto& document : documents) {
+            externalIds.push_back(document.docId);
+            titles.push_back(document.text.empty() ? document.docId : document.text.front().title);
+        }
+
+        // Documents already stored get their sections replaced, which repairs a copy that could
+        // not be read back.
+        std::unordered_map<std::string, std::string> ids;
+        for (const auto& row : tx.exec_prepared("insert_documents", externalIds, titles)) {
+            ids.emplace(text(row[1]), text(row[0]));
+        }
+        tx.exec_prepared0("delete_document_sections", externalIds);
+
+        std::vector<std::string_view> stored;
+        auto sections = pqxx::stream_to::table(
+            tx, { "document_sections" }, { "document_id", "title", "content", "content_zstd" });
+        for (const auto& document : documents) {
+            auto inserted = ids.find(document.docId);
+            if (inserted == ids.end()) {
+                continue;
+            }
+            for (const auto& paragraph : document.text) {
+                auto content = Documents::storeContent(paragraph.text);
+                sections.write_values(
+                    inserted->second, paragraph.title, content.content, optionalBytes(content.compressed));
+            }
+            stored.push_back(document.docId);
+            ids.erase(inserted);
+        }
+        sections.complete();
+        for (auto documentId : stored) {
+            notifyInvalidation(tx, Cache::Invalidation::Kind::Document, documentId);
+        }
+        return true;
+    }, false);
+}
+
+boost::asio::awaitable<std::optional<Document>> PgDataBaseSession::selectDocumentById(std::string_view documentId) {
+    co_return co_await query<std::optional<Document>>("selectDocumentById", [documentId](pqxx::work& tx) {
+        auto rows = tx.exec_prepared("select_document", documentId);
+        if (rows.empty()) {
+            return std::optional<Document> {};
+        }
+
+        std::vector<Documents::Paragraph> paragraphs;
+        paragraphs.reserve(rows.size());
+        try {
+            for (const auto& row : rows) {
+                // A document without sections comes back as one row of nulls from the left join.
+                if (!row[0].is_null()) {
+                    paragraphs.push_back({ .title = text(row[0]), .text = sectionText(row[1], row[2]) });
+                }
+            }
+        } catch (const std::runtime_error& e) {
+            // A miss; the re-download's insert replaces the sections.
+            std::println(std::cerr, "selectDocumentById: document {} unreadable: {}", documentId, e.what());
+            return std::optional<Document> {};
+        }
+        return std::optional<Document> { Document(std::move(paragraphs), std::string(documentId)) };
+    }, std::nullopt);
+}
+
+boost::asio::awaitable<std::vector<Document>> PgDataBaseSession::selectDocumentsByIds(
+    std::span<const std::string> documentIds) {
+    if (documentIds.empty()) {
+        co_return std::vector<Document> {};
+    }
+
+    std::vector<std::string> ids(documentIds.begin(), documentIds.end());
+    co_return co_await query<std::vector<Document>>("selectDocumentsByIds", [&ids](pqxx::work& tx) {
+        std::vector<Document> documents;
+        std::vector<std::string> unreadable;
+        for (const auto& row : tx.exec_prepared("select_documents", ids)) {
+            auto externalId = text(row[0]);
+            if (!unreadable.empty() && unreadable.back() == externalId) {
+                continue;
+            }
+            if (documents.empty() || documents.back().docId != externalId) {
+                documents.emplace_back(std::vector<Documents::Paragraph> {}, std::move(externalId));
+            }
+            if (!row[1].is_null()) {
+                try {
+                    documents.back().text.push_back({ .title = text(row[1]), .text = sectionText(row[2], row[3]) });
+                } catch (const std::runtime_error& e) {
+                    // A miss; the re-download's insert replaces the sections.
+                    std::println(std::cerr, "selectDocumentsByIds: document {} unreadable: {}",
+                                 documents.back().docId, e.what());
+                    unreadable.push_back(std::move(documents.back().docId));
+                    documents.pop_back();
+                }
+            }
+        }
+        return documents;
+    }, {});
+}
+
+boost::asio::awaitable<std::optional<std::vector<std::string>>> PgDataBaseSession::selectDocumentIds() {
+    co_return co_await query<std::optional<std::vector<std::string>>>("selectDocumentIds", [](pqxx::work& tx) {
+        auto rows = tx.exec_prepared("select_document_ids");
+        std::vector<std::string> ids;
+        ids.reserve(rows.size());
+        for (const auto& row : rows) {
+            ids.push_back(text(row[0]));
+        }
+        return std::optional { std::move(ids) };
+    }, std::nullopt);
+}
+
+boost::asio::awaitable<bool> PgDataBaseSession::deleteDocument(std::string_view documentId) {
+    co_return co_await query<bool>("deleteDocument", [documentId](pqxx::work& tx) {
+        tx.exec_prepared0("delete_document", documentId);
+        notifyInvalidation(tx, Cache::Invalidation::Kind::Document, documentId);
+        return true;
+    }, false);
+}
+
+boost::asio::awaitable<bool> PgDataBaseSession::insertOAuthState(std::string_view stateHash, std::string_view expiresAt) {
+    co_return co_await query<bool>("insertOAuthState", [=](pqxx::work& tx) {
+        tx.exec_prepared0("insert_oauth_state", stateHash, expiresAt);
+        return true;
+    }, false);
+}
+
+boost::asio::awaitable<bool> PgDataBaseSession::consumeOAuthState(std::string_view stateHash, std::string_view consumedAt) {
+    co_return co_await query<bool>("consumeOAuthState", [=](pqxx::work& tx) {
+        return tx.exec_prepared("consume_oauth_state", stateHash, consumedAt).affected_rows() > 0;
+    }, false);
+}
+
+boost::asio::awaitable<std::optional<AuthUser>> PgDataBaseSession::selectAuthUserByGoogleSub(std::string_view googleSub) {
+    co_return co_await query<std::optional<AuthUser>>("selectAuthUserByGoogleSub", [=](pqxx::work& tx) {
+        return authUserFromResult(tx.exec_prepared("select_auth_user_by_google_sub", googleSub));
+    }, std::nullopt);
+}
+
+boost::asio::awaitable<std::optional<AuthUser>> PgDataBaseSession::insertAuthUser(
+    std::string_view googleSub, std::string_view email, std::string_view name, std::string_view pictureUrl,
+    std::string_view lastLoginAt) {
+    co_return co_await query<std::optional<AuthUser>>("insertAuthUser", [=](pqxx::work& tx) {
+        return authUserFromResult(tx.exec_prepared("insert_auth_user", googleSub, email, name, pictureUrl, lastLoginAt));
+    }, std::nullopt);
+}
+
+boost::asio::awaitable<std::optional<AuthUser>> PgDataBaseSession::updateAuthUserLogin(
+    std::string_view id, std::string_view email, std::string_view name, std::string_view pictureUrl,
+    std::string_view lastLoginAt) {
+    co_return co_await query<std::optional<AuthUser>>("updateAuthUserLogin", [=](pqxx::work& tx) {
+        return authUserFromResult(tx.exec_prepared("update_auth_user_login", id, email, name, pictureUrl, lastLoginAt));
+    }, std::nullopt);
+}
+
+boost::asio::awaitable<bool> PgDataBaseSession::upsertGoogleOAuthTokens(const GoogleOAuthTokens& tokens) {
+    co_return co_await query<bool>("upsertGoogleOAuthTokens", [&tokens](pqxx::work& tx) {
+        tx.exec_prepared0("upsert_google_oauth_tokens", tokens.userId, tokens.accessTokenEnc, tokens.refreshTokenEnc,
+                          tokens.expiresAt, tokens.scope, tokens.tokenType);
+        notifyInvalidation(tx, Cache::Invalidation::Kind::Tokens, tokens.userId);
+        return true;
+    }, false);
+}
+
+boost::asio::awaitable<std::optional<GoogleOAuthTokens>> PgDataBaseSession::selectGoogleOAuthTokens(std::string_view userId) {
+    co_return co_await query<std::optional<GoogleOAuthTokens>>("selectGoogleOAuthTokens", [=](pqxx::work& tx) {
+        auto rows = tx.exec_prepared("select_google_oauth_tokens", userId);
+        if (rows.empty()) {
+            return std::optional<GoogleOAuthTokens> {};
+        }
+        const auto& row = rows.front();
+        return std::optional<GoogleOAuthTokens> { GoogleOAuthTokens {
+            .userId = text(row[0]),
+            .accessTokenEnc = text(row[1]),
+            .refreshTokenEnc = optionalText(row[2]),
+            .expiresAt = text(row[3]),
+            .scope = text(row[4]),
+            .tokenType = text(row[5]),
+        } };
+    }, std::nullopt);
+}
+
+boost::asio::awaitable<bool> PgDataBaseSession::insertAppSession(
+    std::string_view id, std::string_view userId, std::string_view sessionHash, std::string_view expiresAt,
+    std::string_view userAgent) {
+    co_return co_await query<bool>("insertAppSession", [=](pqxx::work& tx) {
+        if (id.empty()) {
+            tx.exec_prepared0("insert_app_session", userId, sessionHash, expiresAt, userAgent);
+        } else {
+            tx.exec_prepared0("insert_app_session_with_id", id, userId, sessionHash, expiresAt, userAgent);
+        }
+        return true;
+    }, false);
+}
+
+boost::asio::awaitable<AppSessionLookup> PgDataBaseSession::selectActiveAppSession(
+    std::string_view sessionHash, std::string_view now) {
+    co_return co_await query<AppSessionLookup>("selectActiveAppSession", [=](pqxx::work& tx) {
+        auto rows = tx.exec_prepared("select_active_app_session", sessionHash, now);
+        if (rows.empty()) {
+            return AppSessionLookup { std::nullopt };
+        }
+        const auto& row = rows.front();
+        return AppSessionLookup { AppSession {
+            .id = text(row[0]),
+            .userId = text(row[1]),
+            .sessionHash = text(row[2]),
+            .expiresAt = text(row[3]),
+            .revokedAt = optionalText(row[4]),
+        } };
+    }, std::unexpected(LookupFailed {}));
+}
+
+boost::asio::awaitable<bool> PgDataBaseSession::revokeAppSession(std::string_view sessionHash, std::string_view revokedAt) {
+    co_return co_await query<bool>("revokeAppSession", [=](pqxx::work& tx) {
+        tx.exec_prepared0("revoke_app_session", sessionHash, revokedAt);
+        notifyInvalidation(tx, Cache::Invalidation::Kind::Session, sessionHash);
+        return true;
+    }, false);
+}
+
+boost::asio::awaitable<bool> PgDataBaseSession::updateAppSessionLastSeen(
+    std::string_view sessionHash, std::string_view lastSeenAt) {
+    co_return co_await query<bool>("updateAppSessionLastSeen", [=](pqxx::work& tx) {
+        tx.exec_prepared0("update_app_session_last_seen", sessionHash, lastSeenAt);
+        return true;
+    }, false);
+}
+
+boost::asio::awaitable<bool> PgDataBaseSession::updateAppSessionsLastSeen(std::span<const SessionLastSeen> sessions) {
+    if (sessions.empty()) {
+        co_return true;
+    }
+
+    std::vector<std::string> hashes;
+    std::vector<std::string> lastSeen;
+    hashes.reserve(sessions.size());
+    lastSeen.reserve(sessions.size());
+    for (const auto& session : sessions) {
+        hashes.push_back(session.sessionHash);
+        lastSeen.push_back(session.lastSeenAt);
+    }
+
+    co_return co_await query<bool>("updateAppSessionsLastSeen", [&](pqxx::work& tx) {
+        tx.exec_prepared0("update_app_sessions_last_seen", hashes, lastSeen);
+        return true;
+    }, false);
+}
+
+boost::asio::awaitable<std::optional<std::vector<std::string>>> PgDataBaseSession::selectRevokedSessionHashes(
+    std::string_view now) {
+    co_return co_await query<std::optional<std::vector<std::string>>>("selectRevokedSessionHashes", [now](pqxx::work& tx) {
+        auto rows = tx.exec_prepared("select_revoked_session_hashes", now);
+        std::vector<std::string> hashes;
+        hashes.reserve(rows.size());
+        for (const auto& row : rows) {
+            hashes.push_back(text(row[0]));
+        }
+        return std::optional { std::move(hashes) };
+    }, std::nullopt);
+}
+
+boost::asio::awaitable<std::optional<AuthUser>> PgDataBaseSession::selectAuthUserById(std::string_view userId) {
+    co_return co_await query<std::optional<AuthUser>>("selectAuthUserById", [=](pqxx::work& tx) {
+        return authUserFromResult(tx.exec_prepared("select_auth_user_by_id", userId));
+    }, std::nullopt);
+}
+
+}   // namespace Network
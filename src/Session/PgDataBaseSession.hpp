@@ -0,0 +1,166 @@
+#pragma once
+
+#include "Session/DataBaseSession.hpp"
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include <pqxx/pqxx>
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Network {
+
+// Persistent libpqxx connections, opened lazily up to `size`. Every connection has the
+// statements of PgDataBaseSession prepared once, right after it is opened.
+class PgConnectionPool {
+public:
+    // Gives the connection back on destruction; a discarded one frees its slot for a new connection.
+    class Lease {
+    public:
+        Lease(PgConnectionPool& pool, std::unique_ptr<pqxx::connection> connection)
+          : pool_(&pool), connection_(std::move(connection)) {}
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease();
+
+        pqxx::connection& operator*() const { return *connection_; }
+
+        void discard() { connection_.reset(); }
+
+    private:
+        PgConnectionPool* pool_;
+        std::unique_ptr<pqxx::connection> connection_;
+    };
+
+    PgConnectionPool(std::string connectionString, std::size_t size);
+
+    // Blocks until a connection is free; called on database threads only.
+    Lease acquire();
+
+private:
+    std::unique_ptr<pqxx::connection> open() const;
+    void release(std::unique_ptr<pqxx::connection> connection);
+
+    std::string connectionString_;
+    std::size_t size_;
+
+    std::mutex mutex_;
+    std::condition_variable available_;
+    std::vector<std::unique_ptr<pqxx::connection>> idle_;
+    std::size_t opened_ = 0;
+};
+
+// PostgreSQL directly over the wire protocol on persistent connections instead of PostgREST over
+// HTTPS. Whether that is faster for a given deployment is what bench/database_backend_bench.cpp
+// measures; no numbers are assumed here. libpqxx is blocking, so each query runs on a dedicated
+// thread pool with one connection per thread and the calling coroutine resumes on its own
+// executor afterwards.
+class PgDataBaseSession : public DataBaseSession {
+public:
+    struct Options {
+        std::size_t poolSize = 4;
+
+        static const Options& defaults();
+    };
+
+    PgDataBaseSession(std::string connectionString, Options options = Options::defaults());
+
+    boost::asio::awaitable<bool> insertDocument(const Document& document) override;
+    boost::asio::awaitable<bool> insertDocuments(std::span<const Document> documents) override;
+    boost::asio::awaitable<std::optional<Document>> selectDocumentById(std::string_view documentId) override;
+    boost::asio::awaitable<std::vector<Document>> selectDocumentsByIds(std::span<const std::string> documentIds) override;
+    boost::asio::awaitable<std::optional<std::vector<std::string>>> selectDocumentIds() override;
+    // insertDocuments and deleteDocument NOTIFY in their transaction.
+    bool notifiesDocumentWrites() const override { return true; }
+    boost::asio::awaitable<bool> deleteDocument(std::string_view documentId) override;
+
+    boost::asio::awaitable<bool> insertOAuthState(std::string_view stateHash, std::string_view expiresAt) override;
+    boost::asio::awaitable<bool> consumeOAuthState(std::string_view stateHash, std::string_view consumedAt) override;
+
+    boost::asio::awaitable<std::optional<AuthUser>> selectAuthUserByGoogleSub(std::string_view googleSub) override;
+    boost::asio::awaitable<std::optional<AuthUser>> insertAuthUser(
+        std::string_view googleSub,
+        std::string_view email,
+        std::string_view name,
+        std::string_view pictureUrl,
+        std::string_view lastLoginAt) override;
+    boost::asio::awaitable<std::optional<AuthUser>> updateAuthUserLogin(
+        std::string_view id,
+        std::string_view email,
+        std::string_view name,
+        std::string_view pictureUrl,
+        std::string_view lastLoginAt) override;
+
+    boost::asio::awaitable<bool> upsertGoogleOAuthTokens(const GoogleOAuthTokens& tokens) override;
+    boost::asio::awaitable<std::optional<GoogleOAuthTokens>> selectGoogleOAuthTokens(std::string_view userId) override;
+
+    boost::asio::awaitable<bool> insertAppSession(
+        std::string_view id,
+        std::string_view userId,
+        std::string_view sessionHash,
+        std::string_view expiresAt,
+        std::string_view userAgent) override;
+    boost::asio::awaitable<AppSessionLookup> selectActiveAppSession(
+        std::string_view sessionHash,
+        std::string_view now) override;
+    boost::asio::awaitable<bool> revokeAppSession(std::string_view sessionHash, std::string_view revokedAt) override;
+    boost::asio::awaitable<bool> updateAppSessionLastSeen(std::string_view sessionHash, std::string_view lastSeenAt) override;
+    boost::asio::awaitable<bool> updateAppSessionsLastSeen(std::span<const SessionLastSeen> sessions) override;
+    boost::asio::awaitable<std::optional<std::vector<std::string>>> selectRevokedSessionHashes(std::string_view now) override;
+
+    boost::asio::awaitable<std::optional<AuthUser>> selectAuthUserById(std::string_view userId) override;
+
+private:
+    // Runs `work` in a transaction on a database thread. A connection that broke before the
+    // commit is replaced and the transaction retried once; any other failure is logged and
+    // turned into `onError`, the way the REST backend reports a failed status.
+    template <typename Result>
+    boost::asio::awaitable<Result> query(std::string_view name, std::function<Result(pqxx::work&)> work, Result onError) {
+        co_return co_await boost::asio::co_spawn(
+            threadPool_,
+            [this, name, work = std::move(work), onError = std::move(onError)]() -> boost::asio::awaitable<Result> {
+                for (int attempt = 0;; ++attempt) {
+                    try {
+                        auto connection = pool_.acquire();
+                        try {
+                            pqxx::work tx { *connection };
+                            auto result = work(tx);
+                            tx.commit();
+                            co_return result;
+                        } catch (const pqxx::broken_connection&) {
+                            connection.discard();
+                            throw;
+                        }
+                    } catch (const pqxx::broken_connection& e) {
+                        if (attempt == 0) {
+                            continue;
+                        }
+                        std::println(std::cerr, "{} failed: {}", name, e.what());
+                    } catch (const std::exception& e) {
+                        std::println(std::cerr, "{} failed: {}", name, e.what());
+                    }
+                    co_return onError;
+                }
+            },
+            boost::asio::use_awaitable);
+    }
+
+    // Destroyed in reverse order: the thread pool joins its threads, and with them any query
+    // still holding a connection, before the connection pool goes away.
+    PgConnectionPool pool_;
+    boost::asio::thread_pool threadPool_;
+};
+
+}   // namespace Network
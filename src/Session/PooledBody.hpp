@@ -0,0 +1,121 @@
+#pragma once
+
+#include "Util/BufferPool.hpp"
+#include "Util/Compression.hpp"
+
+#include <boost/asio/buffer.hpp>
+#include <boost/beast/core/buffers_range.hpp>
+#include <boost/beast/core/string.hpp>
+#include <boost/beast/http/error.hpp>
+#include <boost/beast/http/message.hpp>
+#include <boost/optional.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+
+namespace Network {
+
+inline bool isGzipEncoded(boost::beast::string_view contentEncoding) {
+    return boost::beast::iequals(contentEncoding, "gzip") || boost::beast::iequals(contentEncoding, "x-gzip");
+}
+
+// Beast body backed by util::PooledBuffer: preallocates from Content-Length, skips zero-fill,
+// and hands the block back to the pool when the message is destroyed. A gzip-encoded message
+// is inflated while it is read, so the body always holds the decoded bytes.
+struct PooledBody {
+    using value_type = util::PooledBuffer;
+
+    static constexpr std::uint64_t maxBodySize = 512ull * 1024 * 1024;
+
+    static std::uint64_t size(const value_type& body) { return body.size(); }
+
+    class reader {
+    public:
+        // The parser builds the reader before the header is parsed, so the encoding is checked in init().
+        template <bool isRequest, class Fields>
+        explicit reader(boost::beast::http::header<isRequest, Fields>& header, value_type& body)
+          : body_(body), gzipEncoded_([&header] {
+                return isGzipEncoded(header[boost::beast::http::field::content_encoding]);
+            }) {}
+
+        void init(const boost::optional<std::uint64_t>& length, boost::system::error_code& ec) {
+            body_.clear();
+            inflater_.reset();
+            if (gzipEncoded_()) {
+                inflater_ = std::make_unique<util::GzipInflater>();
+                if (length) {
+                    body_.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(*length * 4, maxBodySize)));
+                }
+            } else if (length) {
+                if (*length > maxBodySize) {
+                    ec = boost::beast::http::error::buffer_overflow;
+                    return;
+                }
+                body_.reserve(static_cast<std::size_t>(*length));
+            }
+            ec = {};
+        }
+
+        template <class ConstBufferSequence>
+        std::size_t put(const ConstBufferSequence& buffers, boost::system::error_code& ec) {
+            std::size_t written = 0;
+            for (auto buffer : boost::beast::buffers_range_ref(buffers)) {
+                if (inflater_) {
+                    if (!inflater_->write(buffer.data(), buffer.size(), body_, maxBodySize)) {
+                        ec = body_.size() > maxBodySize
+                                 ? make_error_code(boost::beast::http::error::buffer_overflow)
+                                 : make_error_code(boost::system::errc::illegal_byte_sequence);
+                        return written;
+                    }
+                    written += buffer.size();
+                    continue;
+                }
+                if (body_.size() + buffer.size() > maxBodySize) {
+                    ec = boost::beast::http::error::buffer_overflow;
+                    return written;
+                }
+                body_.append(buffer.data(), buffer.size());
+                written += buffer.size();
+            }
+            ec = {};
+            return written;
+        }
+
+        void finish(boost::system::error_code& ec) {
+            if (inflater_ && !inflater_->finished()) {
+                ec = boost::beast::http::error::partial_message;
+                return;
+            }
+            ec = {};
+        }
+
+    private:
+        value_type& body_;
+        std::function<bool()> gzipEncoded_;
+        std::unique_ptr<util::GzipInflater> inflater_;
+    };
+
+    class writer {
+    public:
+        using const_buffers_type = boost::asio::const_buffer;
+
+        template <bool isRequest, class Fields>
+        explicit writer(const boost::beast::http::header<isRequest, Fields>&, const value_type& body) : body_(body) {}
+
+        void init(boost::system::error_code& ec) { ec = {}; }
+
+        boost::optional<std::pair<const_buffers_type, bool>> get(boost::system::error_code& ec) {
+            ec = {};
+            return { { const_buffers_type { body_.data(), body_.size() }, false } };
+        }
+
+    private:
+        const value_type& body_;
+    };
+};
+
+}   // namespace Network
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "DataBaseSession.hpp"
+#include "Util/Encrypt.hpp"
+
+#include <boost/describe/class.hpp>
+#include <boost/json/parse_into.hpp>
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Rows exactly as RestDataBaseSession selects them from PostgREST, decoded with
+// boost::json::parse_into straight into these structs: no DOM, and each string is allocated
+// once, in the struct that keeps it. Member names are the column names, and every selected
+// column needs a member, since parse_into rejects keys it does not know.
+namespace Network::postgrest {
+
+struct AuthUserRow {
+    std::string id;
+    std::string google_sub;
+    std::string email;
+    std::optional<std::string> name;
+    std::optional<std::string> picture_url;
+};
+BOOST_DESCRIBE_STRUCT(AuthUserRow, (), (id, google_sub, email, name, picture_url))
+
+struct GoogleOAuthTokensRow {
+    std::string user_id;
+    std::string access_token_enc;
+    std::optional<std::string> refresh_token_enc;
+    std::string expires_at;
+    std::optional<std::string> scope;
+    std::optional<std::string> token_type;
+};
+BOOST_DESCRIBE_STRUCT(GoogleOAuthTokensRow, (),
+                      (user_id, access_token_enc, refresh_token_enc, expires_at, scope, token_type))
+
+struct AppSessionRow {
+    std::string id;
+    std::string user_id;
+    std::string session_hash;
+    std::string expires_at;
+    std::optional<std::string> revoked_at;
+};
+BOOST_DESCRIBE_STRUCT(AppSessionRow, (), (id, user_id, session_hash, expires_at, revoked_at))
+
+struct OAuthStateRow {
+    std::string state_hash;
+};
+BOOST_DESCRIBE_STRUCT(OAuthStateRow, (), (state_hash))
+
+// content_zstd is the base64 content_zstd_base64 computed field (sql/document_sections_zstd.sql).
+struct SectionRow {
+    std::string title;
+    std::optional<std::string> content;
+    std::optional<std::string> content_zstd;
+};
+BOOST_DESCRIBE_STRUCT(SectionRow, (), (title, content, content_zstd))
+
+struct DocumentRow {
+    std::string external_id;
+    std::vector<SectionRow> document_sections;
+};
+BOOST_DESCRIBE_STRUCT(DocumentRow, (), (external_id, document_sections))
+
+struct DocumentIdRow {
+    std::string external_id;
+};
+BOOST_DESCRIBE_STRUCT(DocumentIdRow, (), (external_id))
+
+struct SessionHashRow {
+    std::string session_hash;
+};
+BOOST_DESCRIBE_STRUCT(SessionHashRow, (), (session_hash))
+
+inline constexpr std::string_view AUTH_USER_SELECT = "id,google_sub,email,name,picture_url";
+inline constexpr std::string_view GOOGLE_OAUTH_TOKENS_SELECT =
+    "user_id,access_token_enc,refresh_token_enc,expires_at,scope,token_type";
+inline constexpr std::string_view APP_SESSION_SELECT = "id,user_id,session_hash,expires_at,revoked_at";
+inline constexpr std::string_view DOCUMENT_SELECT =
+    "external_id,document_sections(title,content,content_zstd:content_zstd_base64)";
+
+// Empty if `body` is not a JSON array of `Row`.
+template <typename Row>
+std::optional<std::vector<Row>> decodeRows(std::string_view body) {
+    std::vector<Row> rows;
+    boost::system::error_code ec;
+    boost::json::parse_into(rows, body, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    return rows;
+}
+
+inline AuthUser toModel(AuthUserRow&& row) {
+    return AuthUser {
+        .id = std::move(row.id),
+        .googleSub = std::move(row.google_sub),
+        .email = std::move(row.email),
+        .name = std::move(row.name).value_or(""),
+        .pictureUrl = std::move(row.picture_url).value_or(""),
+    };
+}
+
+inline GoogleOAuthTokens toModel(GoogleOAuthTokensRow&& row) {
+    return GoogleOAuthTokens {
+        .userId = std::move(row.user_id),
+        .accessTokenEnc = std::move(row.access_token_enc),
+        .refreshTokenEnc = std::move(row.refresh_token_enc),
+        .expiresAt = std::move(row.expires_at),
+        .scope = std::move(row.scope).value_or(""),
+        .tokenType = std::move(row.token_type).value_or(""),
+    };
+}
+
+inline AppSession toModel(AppSessionRow&& row) {
+    return AppSession {
+        .id = std::move(row.id),
+        .userId = std::move(row.user_id),
+        .sessionHash = std::move(row.session_hash),
+        .expiresAt = std::move(row.expires_at),
+        .revokedAt = std::move(row.revoked_at),
+    };
+}
+
+inline Document toModel(DocumentRow&& row) {
+    std::vector<Documents::Paragraph> paragraphs;
+    paragraphs.reserve(row.document_sections.size());
+    for (auto& section : row.document_sections) {
+        std::string text;
+        if (section.content) {
+            text = std::move(*section.content);
+        } else if (section.content_zstd) {
+            text = Documents::loadContent(std::nullopt, util::base64Decode(*section.content_zstd));
+        }
+        paragraphs.push_back({ .title = std::move(section.title), .text = std::move(text) });
+    }
+    return Document(std::move(paragraphs), std::move(row.external_id));
+}
+
+}   // namespace Network::postgrest
@@ -0,0 +1,59 @@
+#include "RangeDownload.hpp"
+
+#include "Util/ConfigParser.hpp"
+
+#include <charconv>
+#include <format>
+
+namespace {
+
+bool parseNumber(std::string_view text, std::uint64_t& value) {
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return !text.empty() && ec == std::errc() && ptr == text.data() + text.size();
+}
+
+}   // namespace
+
+namespace Network {
+
+std::optional<ContentRange> parseContentRange(std::string_view value) {
+    constexpr std::string_view prefix = "bytes ";
+    if (!value.starts_with(prefix)) {
+        return std::nullopt;
+    }
+    value.remove_prefix(prefix.size());
+
+    auto dash = value.find('-');
+    auto slash = value.find('/');
+    if (dash == std::string_view::npos || slash == std::string_view::npos || dash > slash) {
+        return std::nullopt;
+    }
+
+    ContentRange range;
+    if (!parseNumber(value.substr(0, dash), range.first) ||
+        !parseNumber(value.substr(dash + 1, slash - dash - 1), range.last) ||
+        !parseNumber(value.substr(slash + 1), range.total)) {
+        return std::nullopt;
+    }
+    if (range.first > range.last || range.last >= range.total) {
+        return std::nullopt;
+    }
+    return range;
+}
+
+std::string rangeHeader(std::uint64_t first, std::uint64_t last) { return std::format("bytes={}-{}", first, last); }
+
+const RangeDownloadOptions& RangeDownloadOptions::defaults() {
+    static const RangeDownloadOptions options = [] {
+        Util::ConfigParser config;
+        RangeDownloadOptions result;
+        result.chunkSize = std::max<std::uint64_t>(
+            static_cast<std::uint64_t>(config.number("RANGE_CHUNK_BYTES", result.chunkSize)), 64 * 1024);
+        result.parallelism = std::max<std::size_t>(
+            static_cast<std::size_t>(config.number("RANGE_PARALLELISM", result.parallelism)), 1);
+        return result;
+    }();
+    return options;
+}
+
+}   // namespace Network
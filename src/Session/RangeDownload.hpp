@@ -0,0 +1,181 @@
+#pragma once
+
+#include "Session/ConnectionPool.hpp"
+#include "Session/PooledBody.hpp"
+#include "Session/UpstreamLatency.hpp"
+#include "Util/BufferPool.hpp"
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/deferred.hpp>
+#include <boost/asio/experimental/parallel_group.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/beast/http.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace Network {
+
+struct ContentRange {
+    std::uint64_t first = 0;
+    std::uint64_t last = 0;
+    std::uint64_t total = 0;
+};
+
+// Parses "bytes first-last/total"; an unknown total ("*") is treated as unparsable.
+std::optional<ContentRange> parseContentRange(std::string_view value);
+
+std::string rangeHeader(std::uint64_t first, std::uint64_t last);
+
+struct RangeDownloadOptions {
+    std::uint64_t chunkSize = 4 * 1024 * 1024;
+    std::size_t parallelism = 4;
+
+    static const RangeDownloadOptions& defaults();
+};
+
+namespace detail {
+
+struct RangeJob {
+    util::PooledBuffer body;
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> ranges;
+    std::atomic<std::size_t> next { 0 };
+};
+
+// One worker = one pooled connection that keeps pulling the next pending range until none are left.
+template <typename Session>
+boost::asio::awaitable<void> fetchRanges(std::string upstream,
+                                         boost::beast::http::request<boost::beast::http::string_body> req,
+                                         std::shared_ptr<RangeJob> job) {
+    namespace http = boost::beast::http;
+
+    auto& pool = ConnectionPool<Session>::instance();
+    auto session = pool.acquire(co_await boost::asio::this_coro::executor, upstream);
+
+    for (auto i = job->next++; i < job->ranges.size(); i = job->next++) {
+        const auto [first, last] = job->ranges[i];
+        req.set(http::field::range, rangeHeader(first, last));
+
+        auto res = co_await session->downloadWithRedirect(req);
+        auto range = parseContentRange(std::string(res[http::field::content_range]));
+        if (res.result() != http::status::partial_content || !range || range->first != first ||
+            range->last != last || res.body().size() != last - first + 1) {
+            throw std::runtime_error("Unexpected response to range " + rangeHeader(first, last));
+        }
+
+        std::memcpy(job->body.data() + first, res.body().data(), res.body().size());
+
+        if (!res.keep_alive()) {
+            co_await session->stopConnectToSender();
+            session = pool.acquire(co_await boost::asio::this_coro::executor, upstream);
+        }
+    }
+
+    pool.release(upstream, std::move(session));
+}
+
+}   // namespace detail
+
+// Downloads `req` as parallel byte ranges. The first chunk doubles as the probe: a 206 reveals the
+// total size and the rest is fetched by up to `parallelism` pooled connections into one
+// preallocated buffer. A server that ignores Range answers 200 with the whole file, which is
+// returned as is, so that case costs nothing extra.
+template <typename Session>
+boost::asio::awaitable<boost::beast::http::response<PooledBody>> downloadRanged(
+    boost::beast::http::request<boost::beast::http::string_body> req, std::string_view defaultPort,
+    const RangeDownloadOptions& options = RangeDownloadOptions::defaults()) {
+    namespace asio = boost::asio;
+    namespace http = boost::beast::http;
+    namespace X = boost::asio::experimental;
+
+    auto executor = co_await asio::this_coro::executor;
+    const auto upstream = upstreamKey(std::string(req[http::field::host]), defaultPort);
+    auto& pool = ConnectionPool<Session>::instance();
+
+    auto probe = req;
+    probe.set(http::field::range, rangeHeader(0, options.chunkSize - 1));
+
+    auto session = pool.acquire(executor, upstream);
+    auto res = co_await session->downloadWithRedirect(probe);
+
+    if (res.result() == http::status::range_not_satisfiable) {
+        // Empty files cannot satisfy any range.
+        res = co_await session->downloadWithRedirect(req);
+    }
+    if (res.keep_alive()) {
+        pool.release(upstream, std::move(session));
+    } else {
+        co_await session->stopConnectToSender();
+    }
+
+    if (res.result() != http::status::partial_content) {
+        co_return res;
+    }
+
+    auto range = parseContentRange(std::string(res[http::field::content_range]));
+    if (!range || range->first != 0 || res.body().size() != range->last + 1) {
+        throw std::runtime_error("Malformed Content-Range in probe response");
+    }
+
+    res.result(http::status::ok);
+    res.erase(http::field::content_range);
+
+    const auto total = range->total;
+    if (total <= res.body().size()) {
+        co_return res;
+    }
+    if (total > PooledBody::maxBodySize) {
+        throw std::runtime_error("Download exceeds the body size limit");
+    }
+
+    auto job = std::make_shared<detail::RangeJob>();
+    job->body.resize(static_cast<std::size_t>(total));
+    std::memcpy(job->body.data(), res.body().data(), res.body().size());
+
+    for (std::uint64_t first = res.body().size(); first < total; first += options.chunkSize) {
+        job->ranges.emplace_back(first, std::min(first + options.chunkSize, total) - 1);
+    }
+
+    auto make_op = [&] {
+        return asio::co_spawn(executor, detail::fetchRanges<Session>(upstream, req, job), asio::deferred);
+    };
+
+    auto first = make_op();
+
+    using Op = decltype(first);
+
+    const auto workers = std::clamp<std::size_t>(options.parallelism, 1, job->ranges.size());
+    std::vector<Op> ops;
+    ops.reserve(workers);
+    ops.emplace_back(std::move(first));
+    for (std::size_t i = 1; i < workers; ++i) {
+        ops.emplace_back(make_op());
+    }
+
+    auto [order, errors] =
+        co_await X::make_parallel_group(std::move(ops)).async_wait(X::wait_for_one_error(), asio::use_awaitable);
+
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    res.body() = std::move(job->body);
+    res.content_length(total);
+    co_return res;
+}
+
+}   // namespace Network
@@ -0,0 +1,165 @@
+#include "ReadRouter.hpp"
+
+#include "Util/ConfigParser.hpp"
+
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include <algorithm>
+#include <ranges>
+
+namespace {
+
+// Weight of the newest sample in the smoothed latency.
+constexpr double LATENCY_ALPHA = 0.3;
+
+// Expired stickiness entries are swept once the map grows past this.
+constexpr std::size_t STICKY_SWEEP_SIZE = 4096;
+
+}   // namespace
+
+namespace Network {
+
+const ReadRouter::Options& ReadRouter::Options::defaults() {
+    static const Options options = [] {
+        Util::ConfigParser config;
+        Options result;
+        for (auto part : config["SUPABASE_READ_HOSTS"] | std::views::split(',')) {
+            std::string endpoint(std::ranges::begin(part), std::ranges::end(part));
+            std::erase(endpoint, ' ');
+            if (!endpoint.empty()) {
+                result.readEndpoints.push_back(std::move(endpoint));
+            }
+        }
+        result.stickiness = std::chrono::milliseconds(
+            static_cast<std::int64_t>(config.number("DB_PRIMARY_STICKY_MS", result.stickiness.count())));
+        result.probeInterval = std::chrono::milliseconds(
+            static_cast<std::int64_t>(config.number("DB_READ_PROBE_MS", result.probeInterval.count())));
+        return result;
+    }();
+    return options;
+}
+
+ReadRouter::ReadRouter(std::string primary, Options options) : primary_(std::move(primary)), options_(std::move(options)) {
+    for (auto& endpoint : options_.readEndpoints) {
+        endpoints_.push_back({ .name = endpoint });
+    }
+}
+
+ReadRouter::Endpoint* ReadRouter::find(std::string_view endpoint) {
+    auto it = std::ranges::find(endpoints_, endpoint, &Endpoint::name);
+    return it == endpoints_.end() ? nullptr : &*it;
+}
+
+const ReadRouter::Endpoint* ReadRouter::find(std::string_view endpoint) const {
+    auto it = std::ranges::find(endpoints_, endpoint, &Endpoint::name);
+    return it == endpoints_.end() ? nullptr : &*it;
+}
+
+bool ReadRouter::stickyLocked(std::string_view key, Clock::time_point now) {
+    auto it = lastWrite_.find(std::string(key));
+    if (it == lastWrite_.end()) {
+        return false;
+    }
+    if (now - it->second < options_.stickiness) {
+        return true;
+    }
+    lastWrite_.erase(it);
+    return false;
+}
+
+std::string ReadRouter::fastestLocked() const {
+    // Unmeasured endpoints sort first, so each gets traffic before latencies decide.
+    const Endpoint* best = nullptr;
+    for (const auto& endpoint : endpoints_) {
+        if (endpoint.failures >= options_.failuresToEject) {
+            continue;
+        }
+        if (best == nullptr || (endpoint.measured ? endpoint.latencyUs : 0.0) < (best->measured ? best->latencyUs : 0.0)) {
+            best = &endpoint;
+        }
+    }
+    return best != nullptr ? best->name : primary_;
+}
+
+std::string ReadRouter::route(Access access, std::string_view key, Clock::time_point now) {
+    if (access == Access::Write || endpoints_.empty()) {
+        return primary_;
+    }
+
+    std::lock_guard lock(mutex_);
+    return stickyLocked(key, now) ? primary_ : fastestLocked();
+}
+
+std::string ReadRouter::route(Access access, std::span<const std::string> keys, Clock::time_point now) {
+    if (access == Access::Write || endpoints_.empty()) {
+        return primary_;
+    }
+
+    std::lock_guard lock(mutex_);
+    for (const auto& key : keys) {
+        if (stickyLocked(key, now)) {
+            return primary_;
+        }
+    }
+    return fastestLocked();
+}
+
+void ReadRouter::wrote(std::string_view key, Clock::time_point now) {
+    if (endpoints_.empty()) {
+        return;
+    }
+
+    std::lock_guard lock(mutex_);
+    if (lastWrite_.size() >= STICKY_SWEEP_SIZE) {
+        std::erase_if(lastWrite_, [&](const auto& item) { return now - item.second >= options_.stickiness; });
+    }
+    lastWrite_.insert_or_assign(std::string(key), now);
+}
+
+void ReadRouter::report(std::string_view endpoint, std::optional<std::chrono::microseconds> latency) {
+    std::lock_guard lock(mutex_);
+    auto* state = find(endpoint);
+    if (state == nullptr) {
+        return;
+    }
+    if (!latency) {
+        ++state->failures;
+        return;
+    }
+
+    state->failures = 0;
+    const auto sample = static_cast<double>(latency->count());
+    state->latencyUs = state->measured ? LATENCY_ALPHA * sample + (1 - LATENCY_ALPHA) * state->latencyUs : sample;
+    state->measured = true;
+}
+
+bool ReadRouter::healthy(std::string_view endpoint) const {
+    std::lock_guard lock(mutex_);
+    const auto* state = find(endpoint);
+    return state != nullptr && state->failures < options_.failuresToEject;
+}
+
+boost::asio::awaitable<void> ReadRouter::run(Probe probe) {
+    boost::asio::steady_timer timer { co_await boost::asio::this_coro::executor };
+    while (true) {
+        co_await probeAll(probe);
+        timer.expires_after(options_.probeInterval);
+        co_await timer.async_wait(boost::asio::use_awaitable);
+    }
+}
+
+boost::asio::awaitable<void> ReadRouter::probeAll(const Probe& probe) {
+    for (const auto& endpoint : options_.readEndpoints) {
+        std::optional<std::chrono::microseconds> latency;
+        try {
+            latency = co_await probe(endpoint);
+        } catch (const std::exception&) {
+            latency = std::nullopt;
+        }
+        report(endpoint, latency);
+    }
+}
+
+}   // namespace Network
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <boost/asio/awaitable.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Network {
+
+// Picks the database endpoint for each call. Writes go to the primary. Reads go to the
+// healthy read endpoint with the lowest smoothed latency. Two cases still send a read to the
+// primary: there is no healthy read endpoint, or the same key was written within
+// `stickiness`, which keeps read-your-writes despite replica lag. Endpoints are host[:port]
+// strings, as in a Host header.
+//
+// Stickiness only covers writes made through this router, i.e. in this process. A read on
+// another instance can still hit a replica that has not caught up, so reads whose misses are
+// remembered (app sessions, negatively cached for a while) must not go through route().
+class ReadRouter {
+public:
+    enum class Access {
+        Read,
+        Write
+    };
+
+    struct Options {
+        std::vector<std::string> readEndpoints;
+        std::chrono::milliseconds stickiness { 2000 };
+        std::chrono::milliseconds probeInterval { 5000 };
+        // Consecutive failed calls or probes before an endpoint stops getting reads.
+        unsigned failuresToEject = 2;
+
+        static const Options& defaults();
+    };
+
+    using Clock = std::chrono::steady_clock;
+    // Round-trip time of a cheap request to `endpoint`, or nothing if it failed.
+    using Probe = std::function<boost::asio::awaitable<std::optional<std::chrono::microseconds>>(std::string endpoint)>;
+
+    explicit ReadRouter(std::string primary, Options options = Options::defaults());
+
+    const std::string& primary() const { return primary_; }
+    bool hasReadEndpoints() const { return !endpoints_.empty(); }
+
+    // `key` names what the call reads or writes (say "app_session:<hash>").
+    std::string route(Access access, std::string_view key, Clock::time_point now = Clock::now());
+    // A read of several rows stays on the primary if any of `keys` was written recently.
+    std::string route(Access access, std::span<const std::string> keys, Clock::time_point now = Clock::now());
+
+    // After a successful write: reads of `key` stay on the primary for the stickiness window.
+    void wrote(std::string_view key, Clock::time_point now = Clock::now());
+
+    // Outcome of a call or probe; an empty latency is a failure.
+    void report(std::string_view endpoint, std::optional<std::chrono::microseconds> latency);
+
+    bool healthy(std::string_view endpoint) const;
+
+    // Probes every read endpoint each probeInterval, so ejected endpoints come back and idle
+    // ones keep a current latency.
+    boost::asio::awaitable<void> run(Probe probe);
+    boost::asio::awaitable<void> probeAll(const Probe& probe);
+
+private:
+    struct Endpoint {
+        std::string name;
+        double latencyUs = 0;
+        bool measured = false;
+        unsigned failures = 0;
+    };
+
+    bool stickyLocked(std::string_view key, Clock::time_point now);
+    std::string fastestLocked() const;
+    Endpoint* find(std::string_view endpoint);
+    const Endpoint* find(std::string_view endpoint) const;
+
+    std::string primary_;
+    Options options_;
+
+    mutable std::mutex mutex_;
+    std::vector<Endpoint> endpoints_;
+    std::unordered_map<std::string, Clock::time_point> lastWrite_;
+};
+
+}   // namespace Network
@@ -0,0 +1,183 @@
+#include "RetryPolicy.hpp"
+
+#include "Util/ConfigParser.hpp"
+
+#include <boost/asio/error.hpp>
+#include <boost/beast/core/error.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <functional>
+#include <spanstream>
+
+namespace {
+namespace http = boost::beast::http;
+
+constexpr std::size_t MAX_QUOTA_BUCKETS = 10'000;
+constexpr auto QUOTA_BUCKET_IDLE = std::chrono::minutes(10);
+
+bool isGoogleApiHost(std::string_view host) {
+    auto colon = host.find(':');
+    if (colon != std::string_view::npos) {
+        host = host.substr(0, colon);
+    }
+    return host.ends_with("googleapis.com");
+}
+
+}   // namespace
+
+namespace Network {
+
+ResponseClass classifyResponse(http::status status) {
+    switch (status) {
+        case http::status::request_timeout:
+        case http::status::too_many_requests:
+        case http::status::internal_server_error:
+        case http::status::bad_gateway:
+        case http::status::service_unavailable:
+        case http::status::gateway_timeout:
+            return ResponseClass::Retryable;
+        default:
+            break;
+    }
+
+    auto code = static_cast<unsigned>(status);
+    return code < 400 ? ResponseClass::Success : ResponseClass::Fatal;
+}
+
+bool isIdempotent(http::verb method) {
+    switch (method) {
+        case http::verb::get:
+        case http::verb::head:
+        case http::verb::options:
+        case http::verb::put:
+        case http::verb::delete_:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool isRetryableNetworkError(const boost::system::error_code& ec) {
+    return ec == boost::asio::error::connection_reset || ec == boost::asio::error::connection_aborted ||
+           ec == boost::asio::error::connection_refused || ec == boost::asio::error::broken_pipe ||
+           ec == boost::asio::error::eof || ec == boost::asio::error::timed_out ||
+           ec == boost::beast::error::timeout || ec == http::error::end_of_stream ||
+           ec == http::error::partial_message;
+}
+
+std::optional<std::chrono::milliseconds> parseRetryAfter(std::string_view value,
+                                                         std::chrono::system_clock::time_point now) {
+    if (value.empty()) {
+        return std::nullopt;
+    }
+
+    long long seconds = 0;
+    if (auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), seconds);
+        ec == std::errc() && ptr == value.data() + value.size()) {
+        return std::chrono::seconds(std::max(seconds, 0ll));
+    }
+
+    std::chrono::sys_seconds date;
+    std::ispanstream stream { std::span { value } };
+    if (stream >> std::chrono::parse("%a, %d %b %Y %H:%M:%S GMT", date)) {
+        return std::max(std::chrono::duration_cast<std::chrono::milliseconds>(date - now),
+                        std::chrono::milliseconds::zero());
+    }
+
+    return std::nullopt;
+}
+
+DecorrelatedJitter::DecorrelatedJitter(std::chrono::milliseconds base, std::chrono::milliseconds cap)
+  : base_(base), cap_(cap), previous_(base), random_(std::random_device {}()) {}
+
+std::chrono::milliseconds DecorrelatedJitter::next() {
+    auto upper = std::max(base_.count(), previous_.count() * 3);
+    std::uniform_int_distribution<std::chrono::milliseconds::rep> distribution(base_.count(), upper);
+    previous_ = std::min(cap_, std::chrono::milliseconds(distribution(random_)));
+    return previous_;
+}
+
+TokenBucket::TokenBucket(double ratePerSecond, double burst)
+  : rate_(ratePerSecond), burst_(burst), tokens_(burst), updated_(std::chrono::steady_clock::now()) {}
+
+std::chrono::milliseconds TokenBucket::reserve(std::chrono::steady_clock::time_point now) {
+    if (now > updated_) {
+        std::chrono::duration<double> elapsed = now - updated_;
+        tokens_ = std::min(burst_, tokens_ + elapsed.count() * rate_);
+        updated_ = now;
+    }
+
+    tokens_ -= 1.0;
+    if (tokens_ >= 0 || rate_ <= 0) {
+        return std::chrono::milliseconds::zero();
+    }
+
+    return std::chrono::milliseconds(static_cast<std::int64_t>(-tokens_ / rate_ * 1000.0));
+}
+
+const RetryPolicy& RetryPolicy::defaults() {
+    static const RetryPolicy policy = [] {
+        Util::ConfigParser config;
+        RetryPolicy result;
+        result.maxAttempts = static_cast<int>(config.number("RETRY_MAX_ATTEMPTS", result.maxAttempts));
+        result.baseDelay = std::chrono::milliseconds(
+            static_cast<std::int64_t>(config.number("RETRY_BASE_DELAY_MS", result.baseDelay.count())));
+        result.maxDelay = std::chrono::milliseconds(
+            static_cast<std::int64_t>(config.number("RETRY_MAX_DELAY_MS", result.maxDelay.count())));
+        return result;
+    }();
+    return policy;
+}
+
+RetryGovernor& RetryGovernor::instance() {
+    static RetryGovernor governor = [] {
+        Util::ConfigParser config;
+        return RetryGovernor(
+            config.number("RETRY_BUDGET_PERCENT", 20.0) / 100.0,
+            config.number("RETRY_BUDGET_BURST", 10.0),
+            config.number("GOOGLE_QUOTA_RPS", 10.0),
+            config.number("GOOGLE_QUOTA_BURST", 20.0));
+    }();
+    return governor;
+}
+
+RetryGovernor::RetryGovernor(double retryRatio, double retryBurst, double quotaRate, double quotaBurst)
+  : retryRatio_(retryRatio), retryBurst_(retryBurst), quotaRate_(quotaRate), quotaBurst_(quotaBurst) {}
+
+void RetryGovernor::onRequest(std::string_view host) {
+    std::lock_guard lock(mutex_);
+    auto& budget = budgets_[std::string(host)];
+    budget.tokens = std::min(retryBurst_, budget.tokens + retryRatio_);
+}
+
+bool RetryGovernor::tryRetry(std::string_view host) {
+    std::lock_guard lock(mutex_);
+    auto& budget = budgets_[std::string(host)];
+    if (budget.tokens < 1.0) {
+        return false;
+    }
+    budget.tokens -= 1.0;
+    return true;
+}
+
+std::chrono::milliseconds RetryGovernor::reserveQuota(std::string_view host, std::string_view authorization) {
+    if (!isGoogleApiHost(host) || authorization.empty()) {
+        return std::chrono::milliseconds::zero();
+    }
+
+    auto key = std::to_string(std::hash<std::string_view> {}(authorization));
+    auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard lock(mutex_);
+    if (quotas_.size() > MAX_QUOTA_BUCKETS) {
+        std::erase_if(quotas_, [now](const auto& entry) {
+            return now - entry.second.lastUsed() > QUOTA_BUCKET_IDLE;
+        });
+    }
+
+    auto it = quotas_.try_emplace(std::move(key), quotaRate_, quotaBurst_).first;
+    return it->second.reserve(now);
+}
+
+}   // namespace Network
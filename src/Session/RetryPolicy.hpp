@@ -0,0 +1,184 @@
+#pragma once
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/beast/http.hpp>
+
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Network {
+
+enum class ResponseClass {
+    Success,
+    Retryable,
+    Fatal
+};
+
+ResponseClass classifyResponse(boost::beast::http::status status);
+
+bool isIdempotent(boost::beast::http::verb method);
+
+bool isRetryableNetworkError(const boost::system::error_code& ec);
+
+// Retry-After is either delta-seconds or an HTTP-date.
+std::optional<std::chrono::milliseconds> parseRetryAfter(
+    std::string_view value, std::chrono::system_clock::time_point now = std::chrono::system_clock::now());
+
+// "Decorrelated jitter" backoff: next = min(cap, uniform(base, previous * 3)).
+class DecorrelatedJitter {
+public:
+    DecorrelatedJitter(std::chrono::milliseconds base, std::chrono::milliseconds cap);
+
+    std::chrono::milliseconds next();
+
+private:
+    std::chrono::milliseconds base_;
+    std::chrono::milliseconds cap_;
+    std::chrono::milliseconds previous_;
+    std::minstd_rand random_;
+};
+
+// Token bucket that lets callers go into debt: reserve() returns how long to wait
+// before the reserved token is actually available, so bursts are spread out instead of rejected.
+class TokenBucket {
+public:
+    TokenBucket(double ratePerSecond, double burst);
+
+    std::chrono::milliseconds reserve(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+    std::chrono::steady_clock::time_point lastUsed() const { return updated_; }
+
+private:
+    double rate_;
+    double burst_;
+    double tokens_;
+    std::chrono::steady_clock::time_point updated_;
+};
+
+struct RetryPolicy {
+    int maxAttempts = 4;
+    std::chrono::milliseconds baseDelay { 200 };
+    std::chrono::milliseconds maxDelay { 20'000 };
+
+    static const RetryPolicy& defaults();
+};
+
+// Shared retry state: a per-host retry budget (retries may not exceed a share of requests)
+// and per-user token buckets approximating Google's per-user request quota.
+class RetryGovernor {
+public:
+    static RetryGovernor& instance();
+
+    RetryGovernor(double retryRatio, double retryBurst, double quotaRate, double quotaBurst);
+
+    void onRequest(std::string_view host);
+    bool tryRetry(std::string_view host);
+
+    std::chrono::milliseconds reserveQuota(std::string_view host, std::string_view authorization);
+
+private:
+    struct Budget {
+        double tokens = 0;
+    };
+
+    double retryRatio_;
+    double retryBurst_;
+    double quotaRate_;
+    double quotaBurst_;
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, Budget> budgets_;
+    std::unordered_map<std::string, TokenBucket> quotas_;
+};
+
+// True when waiting `delay` would run past the session's request deadline.
+template <typename Session>
+bool exceedsDeadline(const Session& session, std::chrono::milliseconds delay) {
+    const auto& deadline = session.deadline();
+    return deadline && std::chrono::steady_clock::now() + delay >= *deadline;
+}
+
+// Sends `req` through `session`, retrying 429s always and 5xx/network failures for idempotent
+// methods, honoring Retry-After and backing off with decorrelated jitter. Before retrying over a
+// connection that failed or was closed, stopConnectToSender() gives the session fresh stream state.
+// The session's deadline bounds every attempt; a wait that would end past it ends the retries instead,
+// with the last response or error.
+template <typename Body, typename Session>
+boost::asio::awaitable<boost::beast::http::response<Body>> sendWithRetry(
+    Session& session, boost::beast::http::request<boost::beast::http::string_body> req,
+    const RetryPolicy& policy = RetryPolicy::defaults()) {
+    namespace asio = boost::asio;
+    namespace http = boost::beast::http;
+
+    auto& governor = RetryGovernor::instance();
+    const auto host = std::string(req[http::field::host]);
+    const auto authorization = std::string(req[http::field::authorization]);
+    const bool idempotent = isIdempotent(req.method());
+
+    governor.onRequest(host);
+    DecorrelatedJitter backoff { policy.baseDelay, policy.maxDelay };
+    asio::steady_timer timer { co_await asio::this_coro::executor };
+
+    for (int attempt = 1;; ++attempt) {
+        if (auto wait = governor.reserveQuota(host, authorization); wait.count() > 0) {
+            if (exceedsDeadline(session, wait)) {
+                throw boost::system::system_error(asio::error::timed_out, "Request deadline exceeded");
+            }
+            timer.expires_after(wait);
+            co_await timer.async_wait(asio::use_awaitable);
+        }
+
+        bool reconnect = false;
+        std::chrono::milliseconds delay = backoff.next();
+
+        try {
+            auto res = co_await session.template sendRequest<Body>(req);
+            auto kind = classifyResponse(res.result());
+            bool retryable = kind == ResponseClass::Retryable &&
+                             (idempotent || res.result() == http::status::too_many_requests);
+
+            if (!retryable || attempt >= policy.maxAttempts) {
+                co_return res;
+            }
+
+            if (auto retryAfter = parseRetryAfter(std::string(res[http::field::retry_after])); retryAfter) {
+                if (*retryAfter > policy.maxDelay) {
+                    co_return res;
+                }
+                delay = std::max(delay, *retryAfter);
+            }
+
+            if (exceedsDeadline(session, delay) || !governor.tryRetry(host)) {
+                co_return res;
+            }
+
+            if (!res.keep_alive()) {
+                co_await session.stopConnectToSender();
+            }
+        } catch (const boost::system::system_error& e) {
+            if (!idempotent || !isRetryableNetworkError(e.code()) || attempt >= policy.maxAttempts ||
+                exceedsDeadline(session, delay) || !governor.tryRetry(host)) {
+                throw;
+            }
+            reconnect = true;
+        }
+
+        if (reconnect) {
+            co_await session.stopConnectToSender();
+        }
+
+        timer.expires_after(delay);
+        co_await timer.async_wait(asio::use_awaitable);
+    }
+}
+
+}   // namespace Network
@@ -1,10 +1,17 @@
 #include "SimpleSession.hpp"
+#include "AdaptiveTimeout.hpp"
+#include "CircuitBreaker.hpp"
+#include "ContentEncoding.hpp"
+#include "RetryPolicy.hpp"
+#include "UpstreamLatency.hpp"
 
 #include <boost/asio.hpp>
 #include <boost/beast.hpp>
 #include <boost/stacktrace.hpp>
+#include <cerrno>
 #include <iostream>
 #include <print>
+#include <sys/socket.h>
 #include <boost/url/parse.hpp>
 #include <boost/url/url.hpp>
 
@@ -25,6 +32,8 @@ bool SimpleSession::is_connected() const {
 }
 
 asio::awaitable<void> SimpleSession::connectToSender(const std::string host, const std::string port) {
+    const auto upstream = host + ":" + port;
+    std::optional<std::chrono::milliseconds> limit;
     try {
         if (is_connected() && host == host_ && port == port_) {
             co_return;
@@ -40,16 +49,41 @@ asio::awaitable<void> SimpleSession::connectToSender(const std::string host, con
 
         auto result = co_await resolver_.async_resolve(host, port, asio::use_awaitable);
 
-        stream_.expires_after(std::chrono::seconds(30));
+        const auto started = std::chrono::steady_clock::now();
+
+        limit = connectTimeout(upstream);
+        const auto expiry = expiryFor(*limit, deadline_, started);
+        if (expiry < started + *limit) {
+            // Cut short by the request deadline, so running into it says nothing about the upstream.
+            limit.reset();
+        }
+        stream_.expires_at(expiry);
         co_await stream_.async_connect(result, asio::use_awaitable);
         stream_.expires_never();
 
+        UpstreamLatency::instance().connect(upstream).record(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started));
+
     } catch (std::exception& e) {
+        if (const auto* error = dynamic_cast<const boost::system::system_error*>(&e);
+            error != nullptr && error->code() == beast::error::timeout && limit) {
+            recordTimeout(UpstreamLatency::instance().connect(upstream), *limit);
+        }
         std::println(std::cerr, "Exception in connectToSender: {}", e.what());
         throw;
     }
 }
 
+bool SimpleSession::reusableFor(std::string_view upstream) {
+    if (!is_connected() || upstream != host_ + ":" + port_) {
+        return false;
+    }
+    // An idle keep-alive connection has nothing to read; EOF or stray bytes mean it is done.
+    char next;
+    return ::recv(stream_.socket().native_handle(), &next, 1, MSG_PEEK | MSG_DONTWAIT) < 0 &&
+           (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
 asio::awaitable<void> SimpleSession::stopConnectToSender() {
     try {
         if (is_connected()) {
@@ -73,6 +107,9 @@ asio::awaitable<void> SimpleSession::stopConnectToSender() {
 
 template <typename T>
 asio::awaitable<http::response<T>> SimpleSession::sendRequest(http::request<http::string_body> req) {
+    std::optional<CircuitBreaker::Call> call;
+    std::string upstream;
+    std::optional<std::chrono::milliseconds> headerLimit;
     try {
         auto hostHeader = std::string(req[http::field::host]);
 
@@ -89,32 +126,68 @@ asio::awaitable<http::response<T>> SimpleSession::sendRequest(http::request<http
             targetPort = hostHeader.substr(colonPos + 1);
         }
 
+        upstream = targetHost + ":" + targetPort;
+        if (auto& breaker = CircuitBreakers::instance().get(upstream); breaker.allow()) {
+            call.emplace(breaker);
+        } else {
+            throw CircuitOpenError(upstream);
+        }
+
         co_await connectToSender(targetHost, targetPort);
 
-        stream_.expires_after(std::chrono::seconds(30));
-        co_await http::async_write(stream_, req, asio::use_awaitable);
+        requestGzip(req);
 
-        http::response<T> res;
+        const auto kind = requestClass(std::string(req.method_string()), std::string(req.target()));
+        const auto started = std::chrono::steady_clock::now();
 
-        stream_.expires_after(std::chrono::minutes(5));
+        headerLimit = responseTimeout_.value_or(responseTimeout(upstream));
+        const auto headerExpiry = expiryFor(*headerLimit, deadline_, started);
+        if (headerExpiry < started + *headerLimit) {
+            headerLimit.reset();
+        }
+        stream_.expires_at(headerExpiry);
+        co_await http::async_write(stream_, req, asio::use_awaitable);
+
+        http::response_parser<T> parser;
+        parser.body_limit(PooledBody::maxBodySize);
 
         buffer_.consume(buffer_.size());
-        co_await http::async_read(stream_, buffer_, res, asio::use_awaitable);
+        co_await http::async_read_header(stream_, buffer_, parser, asio::use_awaitable);
+        headerLimit.reset();
+
+        // Sampled at the headers, as in SslSession, so large bodies do not inflate the latency.
+        const auto latency =
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
+        UpstreamLatency::instance().response(upstream).record(latency);
+        UpstreamLatency::instance().request(upstream, kind).record(latency);
+        call->onResult(parser.get().result(), latency);
+
+        stream_.expires_at(expiryFor(TimeoutPolicy::defaults().responseCeiling, deadline_));
+        co_await http::async_read(stream_, buffer_, parser, asio::use_awaitable);
 
         stream_.expires_never();
+
+        auto res = parser.release();
+        decodeContentEncoding(res);
         co_return res;
     } catch (const boost::system::system_error& se) {
+        if (se.code() == beast::error::timeout && headerLimit) {
+            recordTimeout(UpstreamLatency::instance().response(upstream), *headerLimit);
+        }
+        if (call) {
+            call->onError(se.code());
+        }
         std::println(std::cerr, "Network error in sendRequest: {}", se.what());
         throw;
     }
 }
 
-asio::awaitable<http::response<http::vector_body<unsigned char>>>
+asio::awaitable<http::response<PooledBody>>
 SimpleSession::downloadWithRedirect(http::request<http::string_body> req, int maxRedirect) {
     int redirectCount = 0;
 
     while (redirectCount < maxRedirect) {
-        auto res = co_await sendRequest<http::vector_body<unsigned char>>(req);
+        auto res = co_await sendWithRetry<PooledBody>(*this, req);
 
         if (res.result() == http::status::found || res.result() == http::status::moved_permanently ||
             res.result() == http::status::temporary_redirect) {
@@ -182,7 +255,7 @@ SimpleSession::downloadWithRedirect(http::request<http::string_body> req, int ma
 template asio::awaitable<http::response<http::string_body>> SimpleSession::sendRequest<http::string_body>(
     http::request<http::string_body>);
 
-template asio::awaitable<http::response<http::vector_body<unsigned char>>>
-    SimpleSession::sendRequest<http::vector_body<unsigned char>>(http::request<http::string_body>);
+template asio::awaitable<http::response<PooledBody>>
+    SimpleSession::sendRequest<PooledBody>(http::request<http::string_body>);
 
 }   // namespace Network
@@ -1,11 +1,16 @@
 #pragma once
 
+#include "Session/AdaptiveTimeout.hpp"
+#include "Session/PooledBody.hpp"
+
 #include <boost/asio.hpp>
 #include <boost/beast/http.hpp>
+#include <chrono>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <boost/beast/core/flat_buffer.hpp>
 #include <boost/beast/core/tcp_stream.hpp>
-#include <boost/beast/http/vector_body.hpp>
 
 namespace Network {
 
@@ -18,19 +23,33 @@ public:
     boost::asio::awaitable<void> connectToSender(const std::string host, const std::string port);
     boost::asio::awaitable<void> stopConnectToSender();
 
+    // True while the connection to `upstream` is open and the peer has neither closed it nor sent
+    // anything unasked while idle. Only such sessions may go back to a ConnectionPool.
+    bool reusableFor(std::string_view upstream);
+
     template<typename T>
     boost::asio::awaitable<boost::beast::http::response<T>>
     sendRequest(boost::beast::http::request<boost::beast::http::string_body> req);
 
-    boost::asio::awaitable<boost::beast::http::response<boost::beast::http::vector_body<unsigned char>>>
+    boost::asio::awaitable<boost::beast::http::response<PooledBody>>
     downloadWithRedirect(boost::beast::http::request<boost::beast::http::string_body> req, int maxRedirect = 5);
 
+    // Fixed wait for the response headers instead of the adaptive one, for upstreams whose latency
+    // depends on the request (the ML server's time grows with the documents it is given).
+    void setResponseTimeout(std::chrono::milliseconds timeout) { responseTimeout_ = timeout; }
+
+    // Upper bound for everything sent through this session, on top of the per-upstream timeouts.
+    void setDeadline(Deadline deadline) { deadline_ = deadline; }
+    const Deadline& deadline() const { return deadline_; }
+
 private:
     boost::asio::ip::tcp::resolver resolver_;
     boost::beast::tcp_stream stream_;
     boost::beast::flat_buffer buffer_;
     std::string port_;
     std::string host_;
+    std::optional<std::chrono::milliseconds> responseTimeout_;
+    Deadline deadline_;
     bool is_connected() const;
 };
 
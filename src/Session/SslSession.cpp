@@ -3,14 +3,21 @@
 //
 
 #include "SslSession.hpp"
+#include "AdaptiveTimeout.hpp"
+#include "CircuitBreaker.hpp"
+#include "ContentEncoding.hpp"
+#include "RetryPolicy.hpp"
+#include "UpstreamLatency.hpp"
 
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
 #include <boost/beast.hpp>
 #include <openssl/err.h>
 #include <boost/stacktrace.hpp>
+#include <cerrno>
 #include <iostream>
 #include <print>
+#include <sys/socket.h>
 #include <boost/url/parse.hpp>
 #include <boost/url/url.hpp>
 
@@ -21,14 +28,29 @@ namespace http = beast::http;
 using tcp = asio::ip::tcp;
 
 namespace Network {
-SslSession::SslSession(asio::any_io_executor ioc) : resolver_(ioc), stream_(ioc, ctx_) {
-    ctx_.set_default_verify_paths();
-    ctx_.set_verify_mode(asio::ssl::context::verify_none);
+asio::ssl::context& SslSession::clientContext() {
+    static asio::ssl::context ctx = [] {
+        asio::ssl::context context { asio::ssl::context::tlsv12_client };
+        context.set_default_verify_paths();
+        context.set_verify_mode(asio::ssl::context::verify_none);
+        return context;
+    }();
+    return ctx;
 }
 
-bool SslSession::is_connected() const { return beast::get_lowest_layer(stream_).socket().is_open(); }
+SslSession::SslSession(asio::any_io_executor ioc) : resolver_(ioc), stream_(std::in_place, ioc, clientContext()) {}
+
+bool SslSession::is_connected() const { return beast::get_lowest_layer(*stream_).socket().is_open(); }
+
+void SslSession::resetStream() {
+    boost::system::error_code ec;
+    beast::get_lowest_layer(*stream_).socket().close(ec);
+    stream_.emplace(resolver_.get_executor(), clientContext());
+}
 
 asio::awaitable<void> SslSession::connectToSender(const std::string host, const std::string port) {
+    const auto upstream = host + ":" + port;
+    std::optional<std::chrono::milliseconds> limit;
     try {
         if (is_connected() && host == host_ && port == port_) {
             co_return;
@@ -44,46 +66,76 @@ asio::awaitable<void> SslSession::connectToSender(const std::string host, const
 
         auto result = co_await resolver_.async_resolve(host, port, asio::use_awaitable);
 
-        co_await beast::get_lowest_layer(stream_).async_connect(result, asio::use_awaitable);
+        const auto started = std::chrono::steady_clock::now();
+
+        limit = connectTimeout(upstream);
+        const auto expiry = expiryFor(*limit, deadline_, started);
+        if (expiry < started + *limit) {
+            // Cut short by the request deadline, so running into it says nothing about the upstream.
+            limit.reset();
+        }
+        beast::get_lowest_layer(*stream_).expires_at(expiry);
+        co_await beast::get_lowest_layer(*stream_).async_connect(result, asio::use_awaitable);
 
-        if (!SSL_set_tlsext_host_name(stream_.native_handle(), host_.c_str())) {
+        if (!SSL_set_tlsext_host_name(stream_->native_handle(), host_.c_str())) {
             throw boost::system::system_error(
                 boost::system::error_code(ERR_get_error(), asio::error::get_ssl_category()));
         }
 
-        beast::get_lowest_layer(stream_).expires_after(std::chrono::seconds(30));
-        co_await stream_.async_handshake(asio::ssl::stream_base::client, asio::use_awaitable);
+        co_await stream_->async_handshake(asio::ssl::stream_base::client, asio::use_awaitable);
 
-        beast::get_lowest_layer(stream_).expires_never();
+        beast::get_lowest_layer(*stream_).expires_never();
+        UpstreamLatency::instance().connect(upstream).record(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started));
     } catch (std::exception& e) {
+        if (const auto* error = dynamic_cast<const boost::system::system_error*>(&e);
+            error != nullptr && error->code() == beast::error::timeout && limit) {
+            recordTimeout(UpstreamLatency::instance().connect(upstream), *limit);
+        }
+        // A half-finished connect or handshake must not be mistaken for an open connection later.
+        resetStream();
         std::println(std::cerr, "Exception in connectToSender: {}", e.what());
         throw;
     }
 }
 
+bool SslSession::reusableFor(std::string_view upstream) {
+    if (!is_connected() || upstream != host_ + ":" + port_) {
+        return false;
+    }
+    // An idle keep-alive connection has nothing to read; EOF or stray bytes mean it is done.
+    char next;
+    return ::recv(beast::get_lowest_layer(*stream_).socket().native_handle(), &next, 1, MSG_PEEK | MSG_DONTWAIT) < 0 &&
+           (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
 asio::awaitable<void> SslSession::stopConnectToSender() {
     try {
         if (is_connected()) {
-            beast::get_lowest_layer(stream_).expires_after(std::chrono::seconds(5));
+            beast::get_lowest_layer(*stream_).expires_after(std::chrono::seconds(5));
 
             boost::system::error_code ec;
-            co_await stream_.async_shutdown(asio::redirect_error(asio::use_awaitable, ec));
+            co_await stream_->async_shutdown(asio::redirect_error(asio::use_awaitable, ec));
 
             if (ec && ec != asio::error::eof && ec != asio::ssl::error::stream_truncated) {
                 std::println(std::cerr, "Shutdown error: {}", ec.message());
             }
 
-            beast::get_lowest_layer(stream_).socket().close(ec);
-            beast::get_lowest_layer(stream_).expires_never();
+            beast::get_lowest_layer(*stream_).expires_never();
         }
 
     } catch (std::exception& e) {
         std::println(std::cerr, "Exception in stopConnectToSender: {}", e.what());
     }
+    // Also after a timeout or reset that already closed the socket: the SSL state is used up either way.
+    resetStream();
 }
 
 template <typename T>
 asio::awaitable<http::response<T>> SslSession::sendRequest(http::request<http::string_body> req) {
+    std::optional<CircuitBreaker::Call> call;
+    std::string upstream;
+    std::optional<std::chrono::milliseconds> headerLimit;
     try {
         auto hostHeader = std::string(req[http::field::host]);
 
@@ -100,32 +152,71 @@ asio::awaitable<http::response<T>> SslSession::sendRequest(http::request<http::s
             targetPort = hostHeader.substr(colonPos + 1);
         }
 
+        upstream = targetHost + ":" + targetPort;
+        if (auto& breaker = CircuitBreakers::instance().get(upstream); breaker.allow()) {
+            call.emplace(breaker);
+        } else {
+            throw CircuitOpenError(upstream);
+        }
+
         co_await connectToSender(targetHost, targetPort);
 
-        beast::get_lowest_layer(stream_).expires_after(std::chrono::seconds(30));
-        co_await http::async_write(stream_, req, asio::use_awaitable);
+        requestGzip(req);
 
-        http::response<T> res;
+        const auto kind = requestClass(std::string(req.method_string()), std::string(req.target()));
+        const auto started = std::chrono::steady_clock::now();
 
-        beast::get_lowest_layer(stream_).expires_after(std::chrono::minutes(5));
+        // The adaptive timeout covers the request and the response headers; a large body then
+        // gets the configured ceiling so slow downloads are not cut off by a short p99.9.
+        headerLimit = responseTimeout_.value_or(responseTimeout(upstream));
+        const auto headerExpiry = expiryFor(*headerLimit, deadline_, started);
+        if (headerExpiry < started + *headerLimit) {
+            headerLimit.reset();
+        }
+        beast::get_lowest_layer(*stream_).expires_at(headerExpiry);
+        co_await http::async_write(*stream_, req, asio::use_awaitable);
+
+        http::response_parser<T> parser;
+        parser.body_limit(PooledBody::maxBodySize);
 
         buffer_.consume(buffer_.size());
-        co_await http::async_read(stream_, buffer_, res, asio::use_awaitable);
+        co_await http::async_read_header(*stream_, buffer_, parser, asio::use_awaitable);
+        headerLimit.reset();
+
+        // Time to the response headers only: the body's transfer time grows with its size and
+        // would skew the timeouts, hedge delays and slow-call detection built on these samples.
+        const auto latency =
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
+        UpstreamLatency::instance().response(upstream).record(latency);
+        UpstreamLatency::instance().request(upstream, kind).record(latency);
+        call->onResult(parser.get().result(), latency);
 
-        beast::get_lowest_layer(stream_).expires_never();
+        beast::get_lowest_layer(*stream_).expires_at(expiryFor(TimeoutPolicy::defaults().responseCeiling, deadline_));
+        co_await http::async_read(*stream_, buffer_, parser, asio::use_awaitable);
+
+        beast::get_lowest_layer(*stream_).expires_never();
+
+        auto res = parser.release();
+        decodeContentEncoding(res);
         co_return res;
     } catch (const boost::system::system_error& se) {
+        if (se.code() == beast::error::timeout && headerLimit) {
+            recordTimeout(UpstreamLatency::instance().response(upstream), *headerLimit);
+        }
+        if (call) {
+            call->onError(se.code());
+        }
         std::println(std::cerr, "Network error in sendRequest: {}", se.what());
         throw;
     }
 }
 
-asio::awaitable<http::response<http::vector_body<unsigned char>>>
+asio::awaitable<http::response<PooledBody>>
 SslSession::downloadWithRedirect(http::request<http::string_body> req, int maxRedirect) {
     int redirectCount = 0;
 
     while (redirectCount < maxRedirect) {
-        auto res = co_await sendRequest<http::vector_body<unsigned char>>(req);
+        auto res = co_await sendWithRetry<PooledBody>(*this, req);
 
         if (res.result() == http::status::found || res.result() == http::status::moved_permanently ||
             res.result() == http::status::temporary_redirect) {
@@ -193,7 +284,7 @@ SslSession::downloadWithRedirect(http::request<http::string_body> req, int maxRe
 template asio::awaitable<http::response<http::string_body>> SslSession::sendRequest<http::string_body>(
     http::request<http::string_body>);
 
-template asio::awaitable<http::response<http::vector_body<unsigned char>>>
-    SslSession::sendRequest<http::vector_body<unsigned char>>(http::request<http::string_body>);
+template asio::awaitable<http::response<PooledBody>>
+    SslSession::sendRequest<PooledBody>(http::request<http::string_body>);
 
 }   // namespace Network
@@ -0,0 +1,140 @@
+#include "UpstreamLatency.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double BUCKET_BASE_US = 100.0;
+constexpr double BUCKET_GROWTH = 1.25;
+
+}   // namespace
+
+namespace Network {
+
+LatencyHistogram::LatencyHistogram(std::chrono::seconds period)
+  : period_(period), periodStart_(std::chrono::steady_clock::now()) {}
+
+std::chrono::microseconds LatencyHistogram::bucketUpperBound(std::size_t bucket) {
+    return std::chrono::microseconds(
+        static_cast<std::int64_t>(std::ceil(BUCKET_BASE_US * std::pow(BUCKET_GROWTH, static_cast<double>(bucket)))));
+}
+
+std::size_t LatencyHistogram::bucketFor(std::chrono::microseconds latency) {
+    const auto us = static_cast<double>(std::max<std::int64_t>(latency.count(), 1));
+    if (us <= BUCKET_BASE_US) {
+        return 0;
+    }
+    auto bucket = static_cast<std::size_t>(std::ceil(std::log(us / BUCKET_BASE_US) / std::log(BUCKET_GROWTH)));
+    return std::min(bucket, bucketCount - 1);
+}
+
+void LatencyHistogram::rotate(std::chrono::steady_clock::time_point now) const {
+    if (now - periodStart_ < period_) {
+        return;
+    }
+
+    if (now - periodStart_ < 2 * period_) {
+        previous_ = current_;
+    } else {
+        previous_.fill(0);
+    }
+    current_.fill(0);
+    periodStart_ = now;
+}
+
+void LatencyHistogram::record(std::chrono::microseconds latency) {
+    std::lock_guard lock(mutex_);
+    rotate(std::chrono::steady_clock::now());
+    ++current_[bucketFor(latency)];
+}
+
+std::uint64_t LatencyHistogram::count() const {
+    std::lock_guard lock(mutex_);
+    rotate(std::chrono::steady_clock::now());
+
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < bucketCount; ++i) {
+        total += current_[i] + previous_[i];
+    }
+    return total;
+}
+
+std::optional<std::chrono::microseconds> LatencyHistogram::quantile(double q) const {
+    std::lock_guard lock(mutex_);
+    rotate(std::chrono::steady_clock::now());
+
+    Buckets merged {};
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < bucketCount; ++i) {
+        merged[i] = current_[i] + previous_[i];
+        total += merged[i];
+    }
+
+    if (total < minSamples) {
+        return std::nullopt;
+    }
+
+    const auto rank = static_cast<std::uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(total)));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < bucketCount; ++i) {
+        seen += merged[i];
+        if (seen >= rank) {
+            return bucketUpperBound(i);
+        }
+    }
+    return bucketUpperBound(bucketCount - 1);
+}
+
+UpstreamLatency& UpstreamLatency::instance() {
+    static UpstreamLatency latency;
+    return latency;
+}
+
+LatencyHistogram& UpstreamLatency::response(std::string_view upstream) { return get(response_, upstream); }
+
+LatencyHistogram& UpstreamLatency::connect(std::string_view upstream) { return get(connect_, upstream); }
+
+LatencyHistogram& UpstreamLatency::request(std::string_view upstream, std::string_view requestClass) {
+    std::string key(upstream);
+    key += ' ';
+    key += requestClass;
+    return get(request_, key);
+}
+
+LatencyHistogram& UpstreamLatency::get(Histograms& histograms, std::string_view upstream) {
+    std::lock_guard lock(mutex_);
+    auto it = histograms.find(upstream);
+    if (it == histograms.end()) {
+        it = histograms.emplace(std::string(upstream), std::make_unique<LatencyHistogram>()).first;
+    }
+    return *it->second;
+}
+
+std::string upstreamKey(std::string_view hostHeader, std::string_view defaultPort) {
+    std::string key(hostHeader);
+    if (key.find(':') == std::string::npos) {
+        key += ":";
+        key += defaultPort;
+    }
+    return key;
+}
+
+std::string requestClass(std::string_view method, std::string_view target) {
+    target = target.substr(0, target.find_first_of("?#"));
+
+    std::size_t end = 0;
+    for (int segments = 0; segments < 3 && end < target.size(); ++segments) {
+        end = target.find('/', end + 1);
+        if (end == std::string_view::npos) {
+            end = target.size();
+        }
+    }
+
+    std::string result(method);
+    result += ' ';
+    result += target.substr(0, end);
+    return result;
+}
+
+}   // namespace Network
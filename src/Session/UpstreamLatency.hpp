@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace Network {
+
+// Log-bucketed latency histogram over a sliding window of two rotating periods,
+// so quantiles follow the live behaviour of an upstream.
+class LatencyHistogram {
+public:
+    static constexpr std::size_t bucketCount = 72;
+    static constexpr std::uint64_t minSamples = 20;
+
+    explicit LatencyHistogram(std::chrono::seconds period = std::chrono::seconds(60));
+
+    void record(std::chrono::microseconds latency);
+
+    std::uint64_t count() const;
+
+    // Upper bound of the bucket holding quantile q, or nullopt while there are too few samples.
+    std::optional<std::chrono::microseconds> quantile(double q) const;
+
+    static std::chrono::microseconds bucketUpperBound(std::size_t bucket);
+
+private:
+    using Buckets = std::array<std::uint64_t, bucketCount>;
+
+    static std::size_t bucketFor(std::chrono::microseconds latency);
+    void rotate(std::chrono::steady_clock::time_point now) const;
+
+    std::chrono::seconds period_;
+    mutable std::mutex mutex_;
+    mutable Buckets current_ {};
+    mutable Buckets previous_ {};
+    mutable std::chrono::steady_clock::time_point periodStart_;
+};
+
+// Process-wide latency statistics keyed by upstream "host:port". `request` additionally splits
+// response latency by request class, so a slow endpoint does not skew the others on that host.
+class UpstreamLatency {
+public:
+    static UpstreamLatency& instance();
+
+    LatencyHistogram& response(std::string_view upstream);
+    LatencyHistogram& connect(std::string_view upstream);
+    LatencyHistogram& request(std::string_view upstream, std::string_view requestClass);
+
+private:
+    using Histograms = std::map<std::string, std::unique_ptr<LatencyHistogram>, std::less<>>;
+
+    LatencyHistogram& get(Histograms& histograms, std::string_view upstream);
+
+    std::mutex mutex_;
+    Histograms response_;
+    Histograms connect_;
+    Histograms request_;
+};
+
+std::string upstreamKey(std::string_view hostHeader, std::string_view defaultPort);
+
+// Method plus the first three path segments of `target`, e.g. "GET /drive/v3/files", so object ids
+// and query strings do not split one endpoint into many histograms.
+std::string requestClass(std::string_view method, std::string_view target);
+
+}   // namespace Network
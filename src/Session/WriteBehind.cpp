@@ -0,0 +1,270 @@
+#include "WriteBehind.hpp"
+
+#include "Util/ConfigParser.hpp"
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <print>
+
+namespace {
+
+// One write per line: kind, key and value separated by tabs, with \, tab and newline escaped.
+std::string escape(std::string_view field) {
+    std::string out;
+    out.reserve(field.size());
+    for (char c : field) {
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '\t': out += "\\t"; break;
+            case '\n': out += "\\n"; break;
+            default: out += c;
+        }
+    }
+    return out;
+}
+
+std::vector<std::string> splitLine(std::string_view line) {
+    std::vector<std::string> fields(1);
+    for (std::size_t i = 0; i < line.size(); ++i) {
+        if (line[i] == '\t') {
+            fields.emplace_back();
+        } else if (line[i] == '\\' && i + 1 < line.size()) {
+            auto next = line[++i];
+            fields.back() += next == 't' ? '\t' : next == 'n' ? '\n' : next;
+        } else {
+            fields.back() += line[i];
+        }
+    }
+    return fields;
+}
+
+std::string journalLine(std::string_view kind, std::string_view key, std::string_view value) {
+    return escape(kind) + '\t' + escape(key) + '\t' + escape(value) + '\n';
+}
+
+bool writeAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+        auto written = ::write(fd, data.data(), data.size());
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data.remove_prefix(static_cast<std::size_t>(written));
+    }
+    return true;
+}
+
+}   // namespace
+
+namespace Network {
+
+const WriteBehind::Options& WriteBehind::Options::defaults() {
+    static const Options options = [] {
+        Util::ConfigParser config;
+        Options result;
+        if (auto path = config["WRITE_BEHIND_JOURNAL"]; !path.empty()) {
+            result.journalPath = std::string(path);
+        }
+        result.flushInterval = std::chrono::milliseconds(
+            static_cast<std::int64_t>(config.number("WRITE_BEHIND_FLUSH_MS", result.flushInterval.count())));
+        result.maxPending = static_cast<std::size_t>(config.number("WRITE_BEHIND_MAX_PENDING", result.maxPending));
+        return result;
+    }();
+    return options;
+}
+
+WriteBehind::WriteBehind(boost::asio::any_io_executor executor, Options options)
+  : options_(std::move(options)), wake_(executor, boost::asio::steady_timer::time_point::max()) {
+    replay();
+    journal_ = ::open(options_.journalPath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (journal_ < 0) {
+        std::println(std::cerr, "Write-behind journal {} unavailable: {}", options_.journalPath, std::strerror(errno));
+    }
+}
+
+WriteBehind::~WriteBehind() {
+    journalThread_.join();
+    if (journal_ >= 0) {
+        ::close(journal_);
+    }
+}
+
+void WriteBehind::replay() {
+    std::ifstream journal { options_.journalPath };
+    std::string line;
+    std::size_t replayed = 0;
+    while (std::getline(journal, line)) {
+        auto fields = splitLine(line);
+        if (fields.size() != 3) {
+            continue;   // torn last line from a crash mid-write
+        }
+        auto& values = pending_[fields[0]];
+        if (values.insert_or_assign(std::move(fields[1]), std::move(fields[2])).second) {
+            ++pendingCount_;
+        }
+        ++replayed;
+    }
+    if (replayed > 0) {
+        std::println(std::cerr, "Write-behind replayed {} journal entries ({} pending)", replayed, pendingCount_);
+    }
+}
+
+void WriteBehind::registerKind(std::string kind, Flusher flusher) {
+    flushers_.insert_or_assign(std::move(kind), std::move(flusher));
+}
+
+void WriteBehind::enqueue(std::string_view kind, std::string_view key, std::string_view value) {
+    auto line = journalLine(kind, key, value);
+    bool full = false;
+    {
+        std::lock_guard lock(mutex_);
+        // Posted under the lock so the journal sees writes in the same order as pending_.
+        boost::asio::post(journalThread_, [this, line = std::move(line)] { appendToJournal(line); });
+
+        auto it = pending_.find(kind);
+        if (it == pending_.end()) {
+            it = pending_.emplace(std::string(kind), std::map<std::string, std::string, std::less<>> {}).first;
+        }
+        if (it->second.insert_or_assign(std::string(key), std::string(value)).second) {
+            ++pendingCount_;
+        }
+        full = pendingCount_ >= options_.maxPending && !backingOff_;
+    }
+
+    if (full) {
+        boost::asio::post(wake_.get_executor(), [this] { wake_.cancel(); });
+    }
+}
+
+void WriteBehind::appendToJournal(const std::string& line) {
+    // A single write() on an O_APPEND descriptor: it survives a process crash without an fsync.
+    if (journal_ >= 0 && !writeAll(journal_, line)) {
+        std::println(std::cerr, "Write-behind journal write failed: {}", std::strerror(errno));
+    }
+}
+
+void WriteBehind::rewriteJournal(const std::string& contents) {
+    // Runs on the journal thread. The new journal holds what was pending when `contents` was taken
+    // and replaces the old one atomically, so a crash at any point leaves one complete journal.
+    const auto tmpPath = options_.journalPath + ".tmp";
+    int tmp = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (tmp < 0) {
+        std::println(std::cerr, "Write-behind journal compaction failed: {}", std::strerror(errno));
+        return;
+    }
+
+    if (!writeAll(tmp, contents) || ::fsync(tmp) != 0 || std::rename(tmpPath.c_str(), options_.journalPath.c_str()) != 0) {
+        std::println(std::cerr, "Write-behind journal compaction failed: {}", std::strerror(errno));
+        ::close(tmp);
+        ::unlink(tmpPath.c_str());
+        return;
+    }
+    ::close(tmp);
+
+    if (journal_ >= 0) {
+        ::close(journal_);
+    }
+    journal_ = ::open(options_.journalPath.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+}
+
+boost::asio::awaitable<void> WriteBehind::run() {
+    while (true) {
+        wake_.expires_after(options_.flushInterval);
+        boost::system::error_code ec;
+        co_await wake_.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        co_await flush();
+    }
+}
+
+boost::asio::awaitable<void> WriteBehind::flush() {
+    std::map<std::string, std::map<std::string, std::string, std::less<>>, std::less<>> snapshot;
+    {
+        std::lock_guard lock(mutex_);
+        snapshot = pending_;
+    }
+
+    bool attempted = false;
+    bool failed = false;
+    for (auto& [kind, values] : snapshot) {
+        auto flusher = flushers_.find(kind);
+        if (flusher == flushers_.end() || values.empty()) {
+            continue;
+        }
+
+        std::vector<Entry> batch;
+        batch.reserve(values.size());
+        for (const auto& [key, value] : values) {
+            batch.push_back({ key, value });
+        }
+
+        attempted = true;
+        bool ok = false;
+        try {
+            ok = co_await flusher->second(std::move(batch));
+        } catch (const std::exception& e) {
+            std::println(std::cerr, "Write-behind flush of {} failed: {}", kind, e.what());
+        }
+        if (!ok) {
+            failed = true;
+            continue;
+        }
+
+        // Drop what was written, unless a newer value for the key arrived meanwhile.
+        std::lock_guard lock(mutex_);
+        auto& current = pending_[kind];
+        for (const auto& [key, value] : values) {
+            if (auto it = current.find(key); it != current.end() && it->second == value) {
+                current.erase(it);
+                --pendingCount_;
+            }
+        }
+    }
+
+    {
+        std::lock_guard lock(mutex_);
+        backingOff_ = failed;
+    }
+    if (!attempted) {
+        co_return;
+    }
+
+    // Also after a failed flush, so repeated updates of a key do not pile up in the journal while the
+    // database is down. Appends posted before this point have run once the journal thread gets here;
+    // ones enqueued while `contents` is taken land after the rewrite, so the journal never loses a write.
+    co_await boost::asio::co_spawn(
+        journalThread_,
+        [this]() -> boost::asio::awaitable<void> {
+            std::string contents;
+            {
+                std::lock_guard lock(mutex_);
+                for (const auto& [kind, values] : pending_) {
+                    for (const auto& [key, value] : values) {
+                        contents += journalLine(kind, key, value);
+                    }
+                }
+            }
+            rewriteJournal(contents);
+            co_return;
+        },
+        boost::asio::use_awaitable);
+}
+
+std::size_t WriteBehind::pending() const {
+    std::lock_guard lock(mutex_);
+    return pendingCount_;
+}
+
+}   // namespace Network
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/thread_pool.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Network {
+
+// Write-behind queue for database writes nobody waits on. enqueue() appends the write to a
+// local journal and keeps only the latest value per (kind, key); run() hands each kind's
+// pending writes to its flusher in batches, every `flushInterval` or as soon as `maxPending`
+// writes are waiting, unless the last flush failed. Writes still in the journal after a crash are
+// replayed on start-up.
+// Journal appends and compaction run on a thread of their own, in the order the writes were
+// enqueued, so callers on the io thread never wait for the disk.
+class WriteBehind {
+public:
+    struct Entry {
+        std::string key;
+        std::string value;
+    };
+
+    // Returns false to keep the batch and retry it on the next flush.
+    using Flusher = std::function<boost::asio::awaitable<bool>(std::vector<Entry>)>;
+
+    struct Options {
+        std::string journalPath = "write-behind.journal";
+        std::chrono::milliseconds flushInterval { 5000 };
+        std::size_t maxPending = 512;
+
+        static const Options& defaults();
+    };
+
+    explicit WriteBehind(boost::asio::any_io_executor executor, Options options = Options::defaults());
+    ~WriteBehind();
+
+    WriteBehind(const WriteBehind&) = delete;
+    WriteBehind& operator=(const WriteBehind&) = delete;
+
+    // Register every kind before run(); journal entries of unknown kinds wait until one is.
+    void registerKind(std::string kind, Flusher flusher);
+
+    void enqueue(std::string_view kind, std::string_view key, std::string_view value);
+
+    boost::asio::awaitable<void> run();
+    boost::asio::awaitable<void> flush();
+
+    std::size_t pending() const;
+
+private:
+    void replay();
+    void appendToJournal(const std::string& line);
+    void rewriteJournal(const std::string& contents);
+
+    Options options_;
+    boost::asio::steady_timer wake_;
+
+    std::map<std::string, Flusher, std::less<>> flushers_;
+
+    mutable std::mutex mutex_;
+    std::map<std::string, std::map<std::string, std::string, std::less<>>, std::less<>> pending_;
+    std::size_t pendingCount_ = 0;
+    // Set while the last flush failed: reaching maxPending then waits for the next interval instead
+    // of retrying the database at once.
+    bool backingOff_ = false;
+
+    // Owns journal_ after construction; one thread, so journal writes keep their posting order.
+    boost::asio::thread_pool journalThread_ { 1 };
+    int journal_ = -1;
+};
+
+}   // namespace Network
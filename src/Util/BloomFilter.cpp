@@ -0,0 +1,64 @@
+#include "BloomFilter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numbers>
+
+namespace {
+
+std::uint64_t mix(std::uint64_t value) {
+    // splitmix64 finalizer: derives a second, independent-looking hash from the first.
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+}
+
+// Kirsch-Mitzenmacher: probe i lands on h1 + i * h2, which behaves like k independent hashes.
+struct Probes {
+    std::uint64_t h1;
+    std::uint64_t h2;
+
+    explicit Probes(std::string_view key) : h1(std::hash<std::string_view> {}(key)), h2(mix(h1) | 1) {}
+
+    std::size_t at(unsigned i, std::size_t bits) const { return static_cast<std::size_t>((h1 + i * h2) % bits); }
+};
+
+}   // namespace
+
+namespace util {
+
+BloomFilter::BloomFilter(std::size_t expectedItems, double falsePositiveRate) {
+    const auto n = static_cast<double>(std::max<std::size_t>(1, expectedItems));
+    const auto p = std::clamp(falsePositiveRate, 1e-9, 0.5);
+    const auto ln2 = std::numbers::ln2;
+
+    bits_ = std::max<std::size_t>(64, static_cast<std::size_t>(std::ceil(-n * std::log(p) / (ln2 * ln2))));
+    hashes_ = std::clamp(static_cast<unsigned>(std::lround(static_cast<double>(bits_) / n * ln2)), 1u, 16u);
+    words_.assign((bits_ + 63) / 64, 0);
+}
+
+void BloomFilter::add(std::string_view key) {
+    Probes probes { key };
+    for (unsigned i = 0; i < hashes_; ++i) {
+        auto bit = probes.at(i, bits_);
+        words_[bit / 64] |= std::uint64_t { 1 } << (bit % 64);
+    }
+    ++items_;
+}
+
+bool BloomFilter::mightContain(std::string_view key) const {
+    Probes probes { key };
+    for (unsigned i = 0; i < hashes_; ++i) {
+        auto bit = probes.at(i, bits_);
+        if ((words_[bit / 64] & (std::uint64_t { 1 } << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}   // namespace util
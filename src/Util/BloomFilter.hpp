@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace util {
+
+// Set membership with no false negatives: mightContain is false only for keys never added.
+// Sized for `expectedItems` at `falsePositiveRate`; past that the rate grows. Keys cannot be
+// removed, so a filter that must forget keys is rebuilt instead. Not synchronized.
+class BloomFilter {
+public:
+    BloomFilter(std::size_t expectedItems, double falsePositiveRate);
+
+    void add(std::string_view key);
+    bool mightContain(std::string_view key) const;
+
+    std::size_t bits() const { return bits_; }
+    unsigned hashes() const { return hashes_; }
+    std::size_t items() const { return items_; }
+
+private:
+    std::size_t bits_;
+    unsigned hashes_;
+    std::size_t items_ = 0;
+    std::vector<std::uint64_t> words_;
+};
+
+}   // namespace util
@@ -0,0 +1,149 @@
+#include "BufferPool.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <utility>
+
+namespace util {
+
+BufferPool& BufferPool::instance() {
+    static BufferPool pool;
+    return pool;
+}
+
+BufferPool::BufferPool(std::size_t maxRetainedBytes) : maxRetainedBytes_(maxRetainedBytes) {}
+
+BufferPool::~BufferPool() {
+    for (auto& sizeClass : classes_) {
+        for (auto* block : sizeClass.blocks) {
+            delete[] block;
+        }
+    }
+}
+
+std::size_t BufferPool::classSizeFor(std::size_t size) {
+    if (size > maxClassSize) {
+        return size;
+    }
+    return std::max(minClassSize, std::bit_ceil(size));
+}
+
+std::size_t BufferPool::classIndexFor(std::size_t size) {
+    return std::countr_zero(classSizeFor(size)) - std::countr_zero(minClassSize);
+}
+
+unsigned char* BufferPool::acquire(std::size_t size, std::size_t& capacity) {
+    capacity = classSizeFor(size);
+
+    if (capacity <= maxClassSize) {
+        auto& sizeClass = classes_[classIndexFor(capacity)];
+        std::lock_guard lock(sizeClass.mutex);
+        if (!sizeClass.blocks.empty()) {
+            auto* block = sizeClass.blocks.back();
+            sizeClass.blocks.pop_back();
+            retainedBytes_.fetch_sub(capacity, std::memory_order_relaxed);
+            return block;
+        }
+    }
+
+    return new unsigned char[capacity];
+}
+
+void BufferPool::release(unsigned char* block, std::size_t capacity) noexcept {
+    if (block == nullptr) {
+        return;
+    }
+
+    if (capacity <= maxClassSize && capacity == classSizeFor(capacity)) {
+        // Claim room in the global budget first, so concurrent releases cannot overshoot it together.
+        auto retained = retainedBytes_.load(std::memory_order_relaxed);
+        while (retained + capacity <= maxRetainedBytes_) {
+            if (retainedBytes_.compare_exchange_weak(retained, retained + capacity, std::memory_order_relaxed)) {
+                auto& sizeClass = classes_[classIndexFor(capacity)];
+                std::lock_guard lock(sizeClass.mutex);
+                try {
+                    sizeClass.blocks.push_back(block);
+                    return;
+                } catch (...) {
+                    retainedBytes_.fetch_sub(capacity, std::memory_order_relaxed);
+                }
+                break;
+            }
+        }
+    }
+
+    delete[] block;
+}
+
+std::size_t BufferPool::retainedBytes() const { return retainedBytes_.load(std::memory_order_relaxed); }
+
+PooledBuffer::PooledBuffer(std::size_t capacity) { reserve(capacity); }
+
+PooledBuffer::PooledBuffer(const PooledBuffer& other) { append(other.data_, other.size_); }
+
+PooledBuffer& PooledBuffer::operator=(const PooledBuffer& other) {
+    if (this != &other) {
+        clear();
+        append(other.data_, other.size_);
+    }
+    return *this;
+}
+
+PooledBuffer::PooledBuffer(PooledBuffer&& other) noexcept
+  : data_(std::exchange(other.data_, nullptr))
+  , size_(std::exchange(other.size_, 0))
+  , capacity_(std::exchange(other.capacity_, 0)) {}
+
+PooledBuffer& PooledBuffer::operator=(PooledBuffer&& other) noexcept {
+    if (this != &other) {
+        reset();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        capacity_ = std::exchange(other.capacity_, 0);
+    }
+    return *this;
+}
+
+PooledBuffer::~PooledBuffer() { reset(); }
+
+void PooledBuffer::reset() noexcept {
+    BufferPool::instance().release(data_, capacity_);
+    data_ = nullptr;
+    size_ = 0;
+    capacity_ = 0;
+}
+
+void PooledBuffer::reserve(std::size_t capacity) {
+    if (capacity <= capacity_) {
+        return;
+    }
+
+    std::size_t newCapacity = 0;
+    auto* block = BufferPool::instance().acquire(capacity, newCapacity);
+    if (size_ != 0) {
+        std::memcpy(block, data_, size_);
+    }
+
+    BufferPool::instance().release(data_, capacity_);
+    data_ = block;
+    capacity_ = newCapacity;
+}
+
+void PooledBuffer::resize(std::size_t size) {
+    if (size > capacity_) {
+        reserve(std::max(size, capacity_ * 2));
+    }
+    size_ = size;
+}
+
+void PooledBuffer::append(const void* data, std::size_t size) {
+    if (size == 0) {
+        return;
+    }
+    auto offset = size_;
+    resize(size_ + size);
+    std::memcpy(data_ + offset, data, size);
+}
+
+}   // namespace util
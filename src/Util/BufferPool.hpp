@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace util {
+
+// Size-classed pool of raw byte blocks. Classes are powers of two from 4 KiB to 64 MiB,
+// larger requests bypass the pool. Blocks are never zero-filled. All classes together keep at
+// most `maxRetainedBytes` of idle blocks; a released block past that is freed.
+class BufferPool {
+public:
+    static constexpr std::size_t minClassSize = 4 * 1024;
+    static constexpr std::size_t maxClassSize = 64 * 1024 * 1024;
+    static constexpr std::size_t classCount = 15;
+
+    static BufferPool& instance();
+
+    explicit BufferPool(std::size_t maxRetainedBytes = 128 * 1024 * 1024);
+
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // Returns a block of at least `size` bytes; `capacity` receives its real size.
+    unsigned char* acquire(std::size_t size, std::size_t& capacity);
+    void release(unsigned char* block, std::size_t capacity) noexcept;
+
+    std::size_t retainedBytes() const;
+
+    static std::size_t classSizeFor(std::size_t size);
+
+private:
+    struct SizeClass {
+        mutable std::mutex mutex;
+        std::vector<unsigned char*> blocks;
+    };
+
+    static std::size_t classIndexFor(std::size_t size);
+
+    std::size_t maxRetainedBytes_;
+    std::atomic<std::size_t> retainedBytes_ { 0 };
+    std::array<SizeClass, classCount> classes_;
+};
+
+// Growable byte buffer backed by BufferPool. The block goes back to the pool on destruction.
+class PooledBuffer {
+public:
+    PooledBuffer() = default;
+    explicit PooledBuffer(std::size_t capacity);
+
+    PooledBuffer(const PooledBuffer& other);
+    PooledBuffer& operator=(const PooledBuffer& other);
+    PooledBuffer(PooledBuffer&& other) noexcept;
+    PooledBuffer& operator=(PooledBuffer&& other) noexcept;
+
+    ~PooledBuffer();
+
+    unsigned char* data() { return data_; }
+    const unsigned char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    std::size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+
+    unsigned char* begin() { return data_; }
+    unsigned char* end() { return data_ + size_; }
+    const unsigned char* begin() const { return data_; }
+    const unsigned char* end() const { return data_ + size_; }
+
+    void reserve(std::size_t capacity);
+    // Grows without initializing the new bytes.
+    void resize(std::size_t size);
+    void append(const void* data, std::size_t size);
+    void clear() { size_ = 0; }
+
+    std::span<unsigned char> span() { return { data_, size_ }; }
+    std::string_view view() const { return { reinterpret_cast<const char*>(data_), size_ }; }
+
+    operator std::span<unsigned char>() { return span(); }
+
+private:
+    void reset() noexcept;
+
+    unsigned char* data_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t capacity_ = 0;
+};
+
+}   // namespace util
@@ -0,0 +1,268 @@
+#include "Compression.hpp"
+
+#include "Util/ConfigParser.hpp"
+
+#include <zlib.h>
+#include <zstd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <print>
+#include <ranges>
+#include <stdexcept>
+
+namespace {
+
+constexpr std::size_t INFLATE_STEP = 64 * 1024;
+
+// windowBits + 32 lets zlib detect a gzip or zlib header; + 16 makes deflate write a gzip one.
+constexpr int AUTO_DETECT_HEADER = 32;
+constexpr int GZIP_HEADER = 16;
+
+std::string readDictionary(const std::string& path) {
+    std::ifstream file { path, std::ios::binary };
+    return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+}
+
+unsigned char* grow(util::PooledBuffer& out, std::size_t extra) {
+    const auto size = out.size();
+    out.resize(size + extra);
+    return out.data() + size;
+}
+
+unsigned char* grow(std::string& out, std::size_t extra) {
+    const auto size = out.size();
+    out.resize(size + extra);
+    return reinterpret_cast<unsigned char*>(out.data() + size);
+}
+
+// zstd contexts are reusable but not thread-safe, so each thread keeps its own pair.
+ZSTD_CCtx* compressContext() {
+    thread_local std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> context { ZSTD_createCCtx(), ZSTD_freeCCtx };
+    return context.get();
+}
+
+ZSTD_DCtx* decompressContext() {
+    thread_local std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> context { ZSTD_createDCtx(), ZSTD_freeDCtx };
+    return context.get();
+}
+
+}   // namespace
+
+namespace util {
+
+GzipInflater::GzipInflater() : stream_(std::make_unique<z_stream>()) {
+    if (inflateInit2(stream_.get(), MAX_WBITS + AUTO_DETECT_HEADER) != Z_OK) {
+        throw std::runtime_error("inflateInit2 failed");
+    }
+}
+
+GzipInflater::~GzipInflater() { inflateEnd(stream_.get()); }
+
+bool GzipInflater::write(const void* input, std::size_t size, PooledBuffer& out, std::size_t limit) {
+    return inflateInto(input, size, out, limit);
+}
+
+bool GzipInflater::write(const void* input, std::size_t size, std::string& out, std::size_t limit) {
+    return inflateInto(input, size, out, limit);
+}
+
+template <typename Output>
+bool GzipInflater::inflateInto(const void* input, std::size_t size, Output& out, std::size_t limit) {
+    stream_->next_in = static_cast<Bytef*>(const_cast<void*>(input));
+    stream_->avail_in = static_cast<uInt>(size);
+
+    while (stream_->avail_in > 0 && !finished_) {
+        const auto before = out.size();
+        stream_->next_out = grow(out, INFLATE_STEP);
+        stream_->avail_out = static_cast<uInt>(INFLATE_STEP);
+
+        const int status = inflate(stream_.get(), Z_NO_FLUSH);
+        out.resize(before + INFLATE_STEP - stream_->avail_out);
+
+        if (out.size() > limit) {
+            return false;
+        }
+        if (status == Z_STREAM_END) {
+            finished_ = true;
+        } else if (status != Z_OK && status != Z_BUF_ERROR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string gzipCompress(std::string_view input, int level) {
+    z_stream stream {};
+    if (deflateInit2(&stream, level, Z_DEFLATED, MAX_WBITS + GZIP_HEADER, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("deflateInit2 failed");
+    }
+
+    std::string out;
+    out.resize(deflateBound(&stream, static_cast<uLong>(input.size())));
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = static_cast<uInt>(out.size());
+
+    const int status = deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    if (status != Z_STREAM_END) {
+        throw std::runtime_error("gzip compression failed");
+    }
+    return out;
+}
+
+std::optional<std::string> gzipDecompress(std::string_view input, std::size_t limit) {
+    GzipInflater inflater;
+    std::string out;
+    out.reserve(std::min(limit, input.size() * 4));
+
+    if (!inflater.write(input.data(), input.size(), out, limit) || !inflater.finished()) {
+        return std::nullopt;
+    }
+    return out;
+}
+
+const ZstdCodec::Options& ZstdCodec::Options::defaults() {
+    static const Options options = [] {
+        Util::ConfigParser config;
+        Options result;
+        result.dictionaryPath = std::string(config["SECTION_ZSTD_DICTIONARY"]);
+        for (auto part : config["SECTION_ZSTD_RETIRED_DICTIONARIES"] | std::views::split(',')) {
+            std::string path(std::ranges::begin(part), std::ranges::end(part));
+            std::erase(path, ' ');
+            if (!path.empty()) {
+                result.retiredDictionaryPaths.push_back(std::move(path));
+            }
+        }
+        result.level = static_cast<int>(config.number("SECTION_ZSTD_LEVEL", result.level));
+        result.minBytes = static_cast<std::size_t>(config.number("SECTION_ZSTD_MIN_BYTES", result.minBytes));
+        return result;
+    }();
+    return options;
+}
+
+const ZstdCodec& ZstdCodec::sections() {
+    static const ZstdCodec codec;
+    return codec;
+}
+
+ZstdCodec::ZstdCodec(Options options) : options_(std::move(options)) {
+    // A configured dictionary that cannot be read is a deployment error: going on without it
+    // would leave every frame written with it unreadable, so the codec refuses to start.
+    auto load = [](const std::string& path) {
+        auto dictionary = readDictionary(path);
+        if (dictionary.empty()) {
+            throw std::runtime_error("zstd dictionary unavailable: " + path);
+        }
+        return dictionary;
+    };
+    std::vector<std::string> retired;
+    for (const auto& path : options_.retiredDictionaryPaths) {
+        retired.push_back(load(path));
+    }
+    const auto current = options_.dictionaryPath.empty() ? std::string {} : load(options_.dictionaryPath);
+
+    try {
+        for (std::size_t i = 0; i < retired.size(); ++i) {
+            auto* dictionary = ZSTD_createDDict(retired[i].data(), retired[i].size());
+            if (dictionary == nullptr) {
+                throw std::runtime_error("zstd dictionary could not be loaded: " + options_.retiredDictionaryPaths[i]);
+            }
+            retiredDictionaries_.push_back(dictionary);
+        }
+        if (!current.empty()) {
+            compressDictionary_ = ZSTD_createCDict(current.data(), current.size(), options_.level);
+            decompressDictionary_ = ZSTD_createDDict(current.data(), current.size());
+            if (compressDictionary_ == nullptr || decompressDictionary_ == nullptr) {
+                throw std::runtime_error("zstd dictionary could not be loaded: " + options_.dictionaryPath);
+            }
+        }
+    } catch (...) {
+        ZSTD_freeCDict(compressDictionary_);
+        ZSTD_freeDDict(decompressDictionary_);
+        for (auto* dictionary : retiredDictionaries_) {
+            ZSTD_freeDDict(dictionary);
+        }
+        throw;
+    }
+}
+
+ZstdCodec::~ZstdCodec() {
+    ZSTD_freeCDict(compressDictionary_);
+    ZSTD_freeDDict(decompressDictionary_);
+    for (auto* retired : retiredDictionaries_) {
+        ZSTD_freeDDict(retired);
+    }
+}
+
+std::optional<std::string> ZstdCodec::compress(std::string_view input) const {
+    if (input.size() < options_.minBytes) {
+        return std::nullopt;
+    }
+
+    // A raw-content dictionary has no id in the frame header; the checksum is what catches a
+    // frame read back with the wrong dictionary.
+    auto* context = compressContext();
+    ZSTD_CCtx_reset(context, ZSTD_reset_session_and_parameters);
+    ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, options_.level);
+    ZSTD_CCtx_setParameter(context, ZSTD_c_checksumFlag, 1);
+    ZSTD_CCtx_refCDict(context, compressDictionary_);
+
+    std::string out;
+    out.resize(ZSTD_compressBound(input.size()));
+
+    const auto size = ZSTD_compress2(context, out.data(), out.size(), input.data(), input.size());
+    if (ZSTD_isError(size) || size >= input.size()) {
+        return std::nullopt;
+    }
+    out.resize(size);
+    return out;
+}
+
+std::optional<std::string> ZstdCodec::decompress(std::string_view frame, std::size_t limit) const {
+    // Frames always record their size, so the output is allocated once.
+    const auto size = ZSTD_getFrameContentSize(frame.data(), frame.size());
+    if (size == ZSTD_CONTENTSIZE_ERROR || size == ZSTD_CONTENTSIZE_UNKNOWN || size > limit) {
+        return std::nullopt;
+    }
+
+    std::string out;
+    out.resize(static_cast<std::size_t>(size));
+
+    // A trained dictionary's id is in the frame header. Raw-content dictionaries and frames
+    // without one both say 0; for those every dictionary is tried and the checksum decides.
+    const auto frameDictionary = ZSTD_getDictID_fromFrame(frame.data(), frame.size());
+    auto readsWith = [&](const ZSTD_DDict_s* dictionary) {
+        const auto id = dictionary == nullptr ? 0 : ZSTD_getDictID_fromDDict(dictionary);
+        if (frameDictionary != 0 && id != frameDictionary) {
+            return false;
+        }
+        auto* context = decompressContext();
+        ZSTD_DCtx_reset(context, ZSTD_reset_session_and_parameters);
+        ZSTD_DCtx_refDDict(context, dictionary);
+        const auto written = ZSTD_decompressDCtx(context, out.data(), out.size(), frame.data(), frame.size());
+        return !ZSTD_isError(written) && written == out.size();
+    };
+
+    if (readsWith(decompressDictionary_)) {
+        return out;
+    }
+    for (const auto* retired : retiredDictionaries_) {
+        if (readsWith(retired)) {
+            return out;
+        }
+    }
+    if (decompressDictionary_ != nullptr && readsWith(nullptr)) {
+        return out;
+    }
+    return std::nullopt;
+}
+
+}   // namespace util
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Util/BufferPool.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct z_stream_s;
+struct ZSTD_CDict_s;
+struct ZSTD_DDict_s;
+
+namespace util {
+
+// Incremental gzip (or zlib) decoder for bodies that arrive in pieces.
+class GzipInflater {
+public:
+    GzipInflater();
+    ~GzipInflater();
+
+    GzipInflater(const GzipInflater&) = delete;
+    GzipInflater& operator=(const GzipInflater&) = delete;
+
+    // Appends the inflated form of `input` to `out`. Returns false on corrupt input or when
+    // the output would grow past `limit`.
+    bool write(const void* input, std::size_t size, PooledBuffer& out, std::size_t limit);
+    bool write(const void* input, std::size_t size, std::string& out, std::size_t limit);
+
+    bool finished() const { return finished_; }
+
+private:
+    template <typename Output>
+    bool inflateInto(const void* input, std::size_t size, Output& out, std::size_t limit);
+
+    std::unique_ptr<z_stream_s> stream_;
+    bool finished_ = false;
+};
+
+std::string gzipCompress(std::string_view input, int level = 6);
+
+std::optional<std::string> gzipDecompress(std::string_view input, std::size_t limit);
+
+// zstd with an optional shared dictionary, for many short texts of one kind that compress
+// poorly on their own. The dictionary is a file made with `zstd --train` (or any raw sample
+// text); a frame written with one can only be read back by a codec holding the same file.
+// To rotate the dictionary, move the old path to `retiredDictionaryPaths`: new frames use the
+// new one and frames already stored stay readable.
+// Construction throws if a configured dictionary cannot be loaded.
+class ZstdCodec {
+public:
+    struct Options {
+        std::string dictionaryPath;
+        // Read-only dictionaries for frames written before the last rotations.
+        std::vector<std::string> retiredDictionaryPaths;
+        int level = 3;
+        // Shorter texts are not worth a frame header.
+        std::size_t minBytes = 128;
+
+        static const Options& defaults();
+    };
+
+    // Codec for document_sections.content_zstd.
+    static const ZstdCodec& sections();
+
+    explicit ZstdCodec(Options options = Options::defaults());
+    ~ZstdCodec();
+
+    ZstdCodec(const ZstdCodec&) = delete;
+    ZstdCodec& operator=(const ZstdCodec&) = delete;
+
+    // Empty when `input` is too short or does not get smaller; store it as it is then.
+    std::optional<std::string> compress(std::string_view input) const;
+
+    // Empty on a corrupt frame, a frame from another dictionary, or output past `limit`.
+    std::optional<std::string> decompress(std::string_view frame, std::size_t limit) const;
+
+    bool hasDictionary() const { return compressDictionary_ != nullptr; }
+
+private:
+    Options options_;
+    ZSTD_CDict_s* compressDictionary_ = nullptr;
+    ZSTD_DDict_s* decompressDictionary_ = nullptr;
+    std::vector<ZSTD_DDict_s*> retiredDictionaries_;
+};
+
+}   // namespace util
@@ -1,6 +1,7 @@
 #include "ConfigParser.hpp"
 #include "config.hpp"
 
+#include <charconv>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
@@ -35,4 +36,25 @@ std::string_view ConfigParser::operator[](const std::string& key) const {
     }
     return {};
 }
+
+double ConfigParser::number(const std::string& key, double fallback) const {
+    auto text = (*this)[key];
+    double value = 0;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (text.empty() || ec != std::errc() || ptr != text.data() + text.size()) {
+        return fallback;
+    }
+    return value;
+}
+
+bool ConfigParser::flag(const std::string& key, bool fallback) const {
+    auto text = (*this)[key];
+    if (text == "true" || text == "1" || text == "on") {
+        return true;
+    }
+    if (text == "false" || text == "0" || text == "off") {
+        return false;
+    }
+    return fallback;
+}
 }   // namespace Util
@@ -11,6 +11,9 @@ public:
 
     std::string_view operator[](const std::string& key) const;
 
+    double number(const std::string& key, double fallback) const;
+    bool flag(const std::string& key, bool fallback = false) const;
+
 private:
     std::unordered_map<std::string, std::string> variables;
 };
@@ -12,7 +12,9 @@
 #include <cstddef>
 #include <boost/url/authority_view.hpp>
 #include <boost/url/url.hpp>
+#include <openssl/crypto.h>
 #include <openssl/evp.h>
+#include <openssl/hmac.h>
 #include <openssl/sha.h>
 #include <openssl/rand.h>
 
@@ -93,6 +95,22 @@ std::string sha256Hex(std::string_view data) {
 
     return byteToHex(std::span(hash, SHA256_DIGEST_LENGTH));
 }
+std::string hmacSha256UrlSafe(std::string_view key, std::string_view data) {
+    unsigned char mac[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+
+    if (HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()),
+             reinterpret_cast<const unsigned char*>(data.data()), data.size(), mac, &length) == nullptr) {
+        throw std::runtime_error("HMAC Error");
+    }
+
+    return base64UrlEncode(std::span(mac, length));
+}
+
+bool constantTimeEquals(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && CRYPTO_memcmp(a.data(), b.data(), a.size()) == 0;
+}
+
 std::string urlEncodeHelper(std::initializer_list<std::pair<std::string_view, std::string_view>> params) {
 
     boost::urls::url u;
@@ -209,4 +227,26 @@ std::string textDecrypt(std::string_view text, std::string_view key) {
     }
 }
 
+std::string base64Encode(std::string_view data) {
+    std::string encoded;
+    CryptoPP::StringSource source(
+        reinterpret_cast<const CryptoPP::byte*>(data.data()),
+        data.size(),
+        true,
+        new CryptoPP::Base64Encoder(new CryptoPP::StringSink(encoded), false)
+    );
+    return encoded;
+}
+
+std::string base64Decode(std::string_view text) {
+    std::string decoded;
+    CryptoPP::StringSource source(
+        reinterpret_cast<const CryptoPP::byte*>(text.data()),
+        text.size(),
+        true,
+        new CryptoPP::Base64Decoder(new CryptoPP::StringSink(decoded))
+    );
+    return decoded;
+}
+
 } // util
@@ -9,10 +9,21 @@ std::string randomUrlSafeToken(std::size_t byteCount = 32);
 
 std::string sha256Hex(std::string_view data);
 
+// HMAC-SHA256 of `data` under `key`, base64url without padding.
+std::string hmacSha256UrlSafe(std::string_view key, std::string_view data);
+
+// Equality that takes the same time wherever the inputs differ; for comparing MACs.
+bool constantTimeEquals(std::string_view a, std::string_view b);
+
 std::string urlEncodeHelper(std::initializer_list<std::pair<std::string_view, std::string_view>> params);
 
 std::string textEncrypt(std::string_view text, std::string_view key);
 
 std::string textDecrypt(std::string_view text, std::string_view key);
 
+// Standard base64 without line breaks; decoding skips whitespace, as PostgreSQL's encode() wraps lines.
+std::string base64Encode(std::string_view data);
+
+std::string base64Decode(std::string_view text);
+
 }
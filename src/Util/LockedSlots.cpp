@@ -0,0 +1,65 @@
+#include "LockedSlots.hpp"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <print>
+
+namespace util {
+
+LockedSlots::LockedSlots(std::size_t slotSize, std::size_t slots) : slotSize_(slotSize), slots_(slots) {
+    const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    bytes_ = std::max<std::size_t>(page, (slotSize_ * slots_ + page - 1) / page * page);
+
+    void* region = ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    region_ = static_cast<char*>(region);
+
+#ifdef MADV_DONTDUMP
+    ::madvise(region_, bytes_, MADV_DONTDUMP);
+#endif
+    locked_ = ::mlock(region_, bytes_) == 0;
+    if (!locked_) {
+        std::println(std::cerr, "Could not lock {} bytes for secrets: {}", bytes_, std::strerror(errno));
+    }
+
+    free_.reserve(slots_);
+    for (std::size_t i = slots_; i > 0; --i) {
+        free_.push_back(i - 1);
+    }
+}
+
+LockedSlots::~LockedSlots() {
+    explicit_bzero(region_, bytes_);
+    if (locked_) {
+        ::munlock(region_, bytes_);
+    }
+    ::munmap(region_, bytes_);
+}
+
+std::optional<std::size_t> LockedSlots::acquire() {
+    std::lock_guard lock(mutex_);
+    if (free_.empty()) {
+        return std::nullopt;
+    }
+    auto slot = free_.back();
+    free_.pop_back();
+    return slot;
+}
+
+void LockedSlots::release(std::size_t slot) {
+    explicit_bzero(region_ + slot * slotSize_, slotSize_);
+    std::lock_guard lock(mutex_);
+    free_.push_back(slot);
+}
+
+std::span<char> LockedSlots::slot(std::size_t index) const { return { region_ + index * slotSize_, slotSize_ }; }
+
+}   // namespace util
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace util {
+
+// Fixed-size slots for secrets in one mmap'd region that is mlock'ed, so it never reaches
+// swap, and excluded from core dumps. A released slot is zeroed before it can be reused.
+// If the memlock limit is too low the region is still usable, just not locked.
+class LockedSlots {
+public:
+    LockedSlots(std::size_t slotSize, std::size_t slots);
+    ~LockedSlots();
+
+    LockedSlots(const LockedSlots&) = delete;
+    LockedSlots& operator=(const LockedSlots&) = delete;
+
+    std::optional<std::size_t> acquire();
+    void release(std::size_t slot);
+
+    std::span<char> slot(std::size_t index) const;
+
+    std::size_t slotSize() const { return slotSize_; }
+    bool locked() const { return locked_; }
+
+private:
+    std::size_t slotSize_;
+    std::size_t slots_;
+    std::size_t bytes_ = 0;
+    char* region_ = nullptr;
+    bool locked_ = false;
+
+    std::mutex mutex_;
+    std::vector<std::size_t> free_;
+};
+
+}   // namespace util
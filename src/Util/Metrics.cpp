@@ -0,0 +1,54 @@
+#include "Metrics.hpp"
+
+#include <format>
+#include <iterator>
+
+namespace util::metrics {
+
+Registry& Registry::instance() {
+    static Registry registry;
+    return registry;
+}
+
+Counter& Registry::counter(const std::string& name, const std::string& help) {
+    std::lock_guard lock(mutex_);
+    auto& entry = counters_[name];
+    if (!entry.counter) {
+        entry.help = help;
+        entry.counter = std::make_unique<Counter>();
+    }
+    return *entry.counter;
+}
+
+void Registry::addCollector(Collector collector) {
+    std::lock_guard lock(mutex_);
+    collectors_.push_back(std::move(collector));
+}
+
+std::string Registry::render() const {
+    std::string out;
+
+    std::lock_guard lock(mutex_);
+    for (const auto& [name, entry] : counters_) {
+        appendHeader(out, name, "counter", entry.help);
+        appendSample(out, name, {}, static_cast<double>(entry.counter->value()));
+    }
+    for (const auto& collector : collectors_) {
+        collector(out);
+    }
+    return out;
+}
+
+void appendHeader(std::string& out, std::string_view name, std::string_view type, std::string_view help) {
+    std::format_to(std::back_inserter(out), "# HELP {} {}\n# TYPE {} {}\n", name, help, name, type);
+}
+
+void appendSample(std::string& out, std::string_view name, std::string_view labels, double value) {
+    if (labels.empty()) {
+        std::format_to(std::back_inserter(out), "{} {}\n", name, value);
+    } else {
+        std::format_to(std::back_inserter(out), "{}{{{}}} {}\n", name, labels, value);
+    }
+}
+
+}   // namespace util::metrics
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace util::metrics {
+
+class Counter {
+public:
+    void inc(std::uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    std::uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::uint64_t> value_ { 0 };
+};
+
+// Process-wide registry rendered in the Prometheus text format by the /metrics endpoint.
+// Plain counters are owned by the registry; components with labeled series add a collector.
+class Registry {
+public:
+    using Collector = std::function<void(std::string&)>;
+
+    static Registry& instance();
+
+    Counter& counter(const std::string& name, const std::string& help);
+    void addCollector(Collector collector);
+
+    std::string render() const;
+
+private:
+    struct CounterEntry {
+        std::string help;
+        std::unique_ptr<Counter> counter;
+    };
+
+    mutable std::mutex mutex_;
+    std::map<std::string, CounterEntry> counters_;
+    std::vector<Collector> collectors_;
+};
+
+void appendHeader(std::string& out, std::string_view name, std::string_view type, std::string_view help);
+void appendSample(std::string& out, std::string_view name, std::string_view labels, double value);
+
+}   // namespace util::metrics
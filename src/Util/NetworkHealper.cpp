@@ -1,5 +1,7 @@
 #include "NetworkHealper.hpp"
 #include <boost/algorithm/string.hpp>
+#include <cctype>
+#include <format>
 #include <ranges>
 #include <vector>
 
@@ -25,6 +27,48 @@ std::map<std::string, std::string> parse_cookie(std::string_view cookie_header)
     return cookie;
 }
 
+std::string percentEncode(std::string_view value) {
+    std::string encoded;
+    for (unsigned char c : value) {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            encoded += static_cast<char>(c);
+        } else {
+            encoded += std::format("%{:02X}", c);
+        }
+    }
+    return encoded;
+}
+
+std::vector<std::string> postgrestInLists(std::span<const std::string> values, std::size_t maxLength) {
+    auto encode = [](std::string_view value) {
+        std::string quoted = "\"";
+        for (char c : value) {
+            if (c == '"' || c == '\\') {
+                quoted += '\\';
+            }
+            quoted += c;
+        }
+        quoted += '"';
+        return percentEncode(quoted);
+    };
+
+    std::vector<std::string> lists;
+    std::string current;
+    for (const auto& value : values) {
+        auto item = encode(value);
+        if (!current.empty() && current.size() + 1 + item.size() + 1 > maxLength) {
+            lists.push_back(current + ")");
+            current.clear();
+        }
+        current += current.empty() ? "(" : ",";
+        current += item;
+    }
+    if (!current.empty()) {
+        lists.push_back(current + ")");
+    }
+    return lists;
+}
+
 bool verifPath(boost::url_view target) {
     auto segments = target.encoded_segments();
 
@@ -1,11 +1,22 @@
 #pragma once
 
+#include <cstddef>
 #include <map>
+#include <span>
 #include <string>
+#include <vector>
 #include <boost/url/urls.hpp>
 
 namespace util::network {
 std::map<std::string, std::string> parse_cookie(std::string_view cookie_header);
 
 bool verifPath(boost::url_view target);
+
+// `value` percent-encoded for a query string, e.g. as the operand of a PostgREST `gt.` filter.
+std::string percentEncode(std::string_view value);
+
+// Percent-encoded PostgREST `in.(...)` lists over `values`, each list at most `maxLength`
+// characters long (a single longer value still gets a list of its own). Values are quoted,
+// so commas and parentheses inside them are safe.
+std::vector<std::string> postgrestInLists(std::span<const std::string> values, std::size_t maxLength);
 }
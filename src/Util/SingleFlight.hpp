@@ -0,0 +1,126 @@
+#pragma once
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/system/system_error.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+// Collapses concurrent calls for the same key into one execution whose result (or exception)
+// is handed to every caller. The work runs detached from the caller that started it, so a
+// waiter that is cancelled or disconnects only stops waiting; the others still get the result.
+template <typename Key, typename Value>
+class SingleFlight {
+public:
+    template <typename Work>
+    boost::asio::awaitable<Value> run(Key key, Work work) {
+        namespace asio = boost::asio;
+
+        auto executor = co_await asio::this_coro::executor;
+        // The leader may finish on another thread. The waiter's timer lives on a strand where both the
+        // wait and the wake-up run, so a wake-up that comes before the wait has started is not lost.
+        auto strand = asio::make_strand(executor);
+        auto waiter = std::make_shared<asio::steady_timer>(strand, asio::steady_timer::time_point::max());
+
+        std::shared_ptr<Call> call;
+        bool leader = false;
+        {
+            std::lock_guard lock(mutex_);
+            auto& slot = calls_[key];
+            if (!slot) {
+                slot = std::make_shared<Call>();
+                leader = true;
+            }
+            call = slot;
+            call->waiters.push_back(waiter);
+        }
+
+        if (leader) {
+            asio::co_spawn(executor, lead(key, call, std::move(work)), asio::detached);
+        }
+
+        co_await asio::co_spawn(strand, wait(waiter), asio::use_awaitable);
+
+        std::unique_lock lock(mutex_);
+        if (!call->done) {
+            std::erase(call->waiters, waiter);
+            throw boost::system::system_error(asio::error::operation_aborted);
+        }
+        lock.unlock();
+
+        if (call->error) {
+            std::rethrow_exception(call->error);
+        }
+        co_return *call->value;
+    }
+
+    std::size_t inFlight() const {
+        std::lock_guard lock(mutex_);
+        return calls_.size();
+    }
+
+private:
+    struct Call {
+        bool done = false;
+        std::optional<Value> value;
+        std::exception_ptr error;
+        std::vector<std::shared_ptr<boost::asio::steady_timer>> waiters;
+    };
+
+    static boost::asio::awaitable<void> wait(std::shared_ptr<boost::asio::steady_timer> waiter) {
+        boost::system::error_code ec;
+        co_await waiter->async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+    }
+
+    template <typename Work>
+    boost::asio::awaitable<void> lead(Key key, std::shared_ptr<Call> call, Work work) {
+        std::optional<Value> value;
+        std::exception_ptr error;
+        try {
+            value.emplace(co_await work());
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        std::vector<std::shared_ptr<boost::asio::steady_timer>> waiters;
+        {
+            std::lock_guard lock(mutex_);
+            call->value = std::move(value);
+            call->error = error;
+            call->done = true;
+            waiters = std::move(call->waiters);
+
+            if (auto it = calls_.find(key); it != calls_.end() && it->second == call) {
+                calls_.erase(it);
+            }
+        }
+
+        // Expiring the timer, unlike cancel(), also ends a wait that starts after the wake-up.
+        for (auto& waiter : waiters) {
+            boost::asio::post(waiter->get_executor(),
+                              [waiter] { waiter->expires_at(boost::asio::steady_timer::time_point::min()); });
+        }
+    }
+
+    mutable std::mutex mutex_;
+    std::unordered_map<Key, std::shared_ptr<Call>> calls_;
+};
+
+}   // namespace util
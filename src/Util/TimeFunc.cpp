@@ -52,4 +52,6 @@ bool isTimestampAfterNowPlus(std::string_view timestamp, int seconds) {
         .value_or(false);
 }
 
+std::optional<std::chrono::sys_seconds> parseTimestamp(std::string_view timestamp) { return parse_utc_time(timestamp); }
+
 }   // namespace util::time
@@ -1,4 +1,6 @@
 #pragma once
+#include <chrono>
+#include <optional>
 #include <string>
 #include <string_view>
 
@@ -10,4 +12,6 @@ std::string getCurrentTimeAfterMinutes(int minutes);
 std::string getCurrentTimeAfterSeconds(int seconds);
 
 bool isTimestampAfterNowPlus(std::string_view timestamp, int seconds);
+
+std::optional<std::chrono::sys_seconds> parseTimestamp(std::string_view timestamp);
 }
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include "WarmUp.hpp"
+
+#include "DocumentReader/DocReader.hpp"
+#include "Session/ConnectionPool.hpp"
+#include "Session/SslSession.hpp"
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/deferred.hpp>
+#include <boost/asio/experimental/parallel_group.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include <chrono>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <print>
+#include <vector>
+
+namespace asio = boost::asio;
+namespace X = boost::asio::experimental;
+
+namespace {
+
+constexpr std::string_view WARMUP_DOCX_XML =
+    R"(<w:document xmlns:w="http://schemas.openxmlformats.org/wordprocessingml/2006/main"><w:body>)"
+    R"(<w:p><w:pPr><w:pStyle w:val="Heading1"/></w:pPr><w:r><w:t>1 ВВЕДЕНИЕ</w:t></w:r></w:p>)"
+    R"(<w:p><w:r><w:t>Проверочный абзац для прогрева.</w:t></w:r></w:p>)"
+    R"(</w:body></w:document>)";
+
+// Single-page PDF with a valid xref table, built at run time so the offsets are right.
+std::string warmUpPdf() {
+    constexpr std::string_view content = "BT /F1 12 Tf 10 20 Td (Warm-up) Tj ET";
+    const std::string objects[] = {
+        "<< /Type /Catalog /Pages 2 0 R >>",
+        "<< /Type /Pages /Kids [3 0 R] /Count 1 >>",
+        "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 200 50] /Contents 4 0 R "
+        "/Resources << /Font << /F1 5 0 R >> >> >>",
+        std::format("<< /Length {} >>\nstream\n{}\nendstream", content.size(), content),
+        "<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>",
+    };
+
+    std::string pdf = "%PDF-1.4\n";
+    std::vector<std::size_t> offsets;
+    for (std::size_t i = 0; i < std::size(objects); ++i) {
+        offsets.push_back(pdf.size());
+        pdf += std::format("{} 0 obj\n{}\nendobj\n", i + 1, objects[i]);
+    }
+
+    const auto xref = pdf.size();
+    pdf += std::format("xref\n0 {}\n0000000000 65535 f \n", offsets.size() + 1);
+    for (auto offset : offsets) {
+        pdf += std::format("{:010} 00000 n \n", offset);
+    }
+    pdf += std::format("trailer\n<< /Size {} /Root 1 0 R >>\nstartxref\n{}\n%%EOF\n", offsets.size() + 1, xref);
+    return pdf;
+}
+
+}   // namespace
+
+namespace Network {
+
+void WarmUp::add(std::string name, Task task) { tasks_.push_back({ std::move(name), std::move(task) }); }
+
+asio::awaitable<void> WarmUp::run() {
+    if (tasks_.empty()) {
+        co_return;
+    }
+
+    auto executor = co_await asio::this_coro::executor;
+
+    auto make_op = [&](Named& named) -> decltype(auto) {
+        return asio::co_spawn(executor, [&named]() -> asio::awaitable<void> {
+            const auto started = std::chrono::steady_clock::now();
+            co_await named.task();
+            std::println("Warm-up {} done in {} ms", named.name,
+                         std::chrono::duration_cast<std::chrono::milliseconds>(
+                             std::chrono::steady_clock::now() - started).count());
+        }, asio::deferred);
+    };
+
+    auto first = make_op(tasks_.front());
+
+    using Op = decltype(first);
+
+    std::vector<Op> ops;
+    ops.reserve(tasks_.size());
+    ops.emplace_back(std::move(first));
+    for (std::size_t i = 1; i < tasks_.size(); ++i) {
+        ops.emplace_back(make_op(tasks_[i]));
+    }
+
+    auto [order, errors] = co_await X::make_parallel_group(std::move(ops)).async_wait(X::wait_for_all(), asio::use_awaitable);
+
+    for (std::size_t i = 0; i < errors.size(); ++i) {
+        if (!errors[i]) {
+            continue;
+        }
+        try {
+            std::rethrow_exception(errors[i]);
+        } catch (const std::exception& e) {
+            std::println(std::cerr, "Warm-up {} failed: {}", tasks_[i].name, e.what());
+        }
+    }
+}
+
+asio::awaitable<void> preconnect(std::string host, std::string port, std::size_t count) {
+    auto executor = co_await asio::this_coro::executor;
+    auto& pool = ConnectionPool<SslSession>::instance();
+    const auto upstream = host + ":" + port;
+
+    std::vector<std::shared_ptr<SslSession>> sessions;
+    for (std::size_t i = 0; i < count; ++i) {
+        sessions.push_back(std::make_shared<SslSession>(executor));
+        co_await sessions.back()->connectToSender(host, port);
+    }
+    for (auto& session : sessions) {
+        pool.release(upstream, std::move(session));
+    }
+}
+
+void primeDocumentReaders() {
+    DocReader::DocxReader(WARMUP_DOCX_XML);
+
+    auto pdf = warmUpPdf();
+    DocReader::PdfReader({ reinterpret_cast<unsigned char*>(pdf.data()), pdf.size() });
+}
+
+}   // namespace Network
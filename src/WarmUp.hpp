@@ -0,0 +1,38 @@
+#pragma once
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Network {
+
+// Named start-up tasks that run concurrently before the server reports ready. A failing task
+// is logged and does not block readiness: warm-up only moves cost off the first requests.
+class WarmUp {
+public:
+    using Task = std::function<boost::asio::awaitable<void>()>;
+
+    void add(std::string name, Task task);
+
+    boost::asio::awaitable<void> run();
+
+private:
+    struct Named {
+        std::string name;
+        Task task;
+    };
+
+    std::vector<Named> tasks_;
+};
+
+// Opens `count` TLS connections to host:port and parks them in the SslSession connection pool.
+boost::asio::awaitable<void> preconnect(std::string host, std::string port, std::size_t count);
+
+// Parses a tiny DOCX body and PDF so pugixml, ICU data and poppler are loaded before real work.
+void primeDocumentReaders();
+
+}   // namespace Network
@@ -19,7 +19,11 @@ int main() {
     auto address = envOrDefault("SERVER_ADDRESS", "0.0.0.0");
     auto port = envOrDefault("SERVER_PORT", "8080");
 
+#if defined(BOOST_ASIO_HAS_IO_URING) && defined(BOOST_ASIO_DISABLE_EPOLL)
+    std::println("Starting server on {}:{} (io_uring)", address, port);
+#else
     std::println("Starting server on {}:{}", address, port);
+#endif
     boost::asio::io_context ioc { 4 };
     Network::Server server(ioc, address, port);
 
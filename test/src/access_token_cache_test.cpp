@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include "Auth/AccessTokenCache.hpp"
+
+using Network::Auth::AccessTokenCache;
+
+namespace {
+
+AccessTokenCache::Options options(std::size_t maxUsers = 4) {
+    AccessTokenCache::Options result;
+    result.maxUsers = maxUsers;
+    result.maxTokenBytes = 64;
+    result.margin = std::chrono::seconds(300);
+    return result;
+}
+
+}   // namespace
+
+TEST(AccessTokenCacheTest, ServesUntilExpiryMinusMargin) {
+    AccessTokenCache cache { options() };
+    auto now = AccessTokenCache::Clock::now();
+
+    cache.store("user", "token-1", now + std::chrono::seconds(3600), now);
+    EXPECT_EQ(cache.find("user", now), "token-1");
+    EXPECT_EQ(cache.find("user", now + std::chrono::seconds(3299)), "token-1");
+    EXPECT_FALSE(cache.find("user", now + std::chrono::seconds(3300)));
+    EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST(AccessTokenCacheTest, NearlyExpiredOrOversizedTokensAreNotCached) {
+    AccessTokenCache cache { options() };
+    auto now = AccessTokenCache::Clock::now();
+
+    cache.store("user", "token", now + std::chrono::seconds(200), now);
+    EXPECT_FALSE(cache.find("user", now));
+
+    cache.store("user", std::string(65, 'x'), now + std::chrono::seconds(3600), now);
+    EXPECT_FALSE(cache.find("user", now));
+}
+
+TEST(AccessTokenCacheTest, ReplacesAndShrinksTokens) {
+    AccessTokenCache cache { options() };
+    auto now = AccessTokenCache::Clock::now();
+
+    cache.store("user", "a-rather-long-token", now + std::chrono::seconds(3600), now);
+    cache.store("user", "short", now + std::chrono::seconds(3600), now);
+    EXPECT_EQ(cache.find("user", now), "short");
+    EXPECT_EQ(cache.size(), 1u);
+}
+
+TEST(AccessTokenCacheTest, FullCacheDropsTheEntryClosestToExpiry) {
+    AccessTokenCache cache { options(2) };
+    auto now = AccessTokenCache::Clock::now();
+
+    cache.store("soon", "a", now + std::chrono::seconds(600), now);
+    cache.store("later", "b", now + std::chrono::seconds(3600), now);
+    cache.store("new", "c", now + std::chrono::seconds(3600), now);
+
+    EXPECT_FALSE(cache.find("soon", now));
+    EXPECT_EQ(cache.find("later", now), "b");
+    EXPECT_EQ(cache.find("new", now), "c");
+
+    cache.evict("later");
+    EXPECT_FALSE(cache.find("later", now));
+}
@@ -0,0 +1,58 @@
+#include "Session/AdaptiveTimeout.hpp"
+
+#include <boost/system/system_error.hpp>
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+using namespace std::chrono_literals;
+
+TEST(AdaptiveTimeoutTest, UsesCeilingWhileCold) {
+    Network::LatencyHistogram histogram;
+    histogram.record(5ms);
+
+    EXPECT_EQ(Network::adaptiveTimeout(histogram, 0.999, 3.0, 1s, 300s), 300s);
+}
+
+TEST(AdaptiveTimeoutTest, FastUpstreamIsClampedToFloor) {
+    Network::LatencyHistogram histogram;
+    for (int i = 0; i < 100; ++i) {
+        histogram.record(20ms);
+    }
+
+    EXPECT_EQ(Network::adaptiveTimeout(histogram, 0.999, 3.0, 1s, 300s), 1s);
+}
+
+TEST(AdaptiveTimeoutTest, ScalesTailLatency) {
+    Network::LatencyHistogram histogram;
+    for (int i = 0; i < 100; ++i) {
+        histogram.record(2s);
+    }
+
+    auto timeout = Network::adaptiveTimeout(histogram, 0.999, 3.0, 1s, 300s);
+    EXPECT_GE(timeout, 6s);
+    EXPECT_LT(timeout, 8s);
+    EXPECT_EQ(Network::adaptiveTimeout(histogram, 0.999, 3.0, 1s, 4s), 4s);
+}
+
+TEST(AdaptiveTimeoutTest, DeadlineShortensExpiry) {
+    auto now = std::chrono::steady_clock::now();
+
+    EXPECT_EQ(Network::expiryFor(5s, std::nullopt, now), now + 5s);
+    EXPECT_EQ(Network::expiryFor(5s, now + 2s, now), now + 2s);
+    EXPECT_EQ(Network::expiryFor(1s, now + 2s, now), now + 1s);
+    EXPECT_THROW(Network::expiryFor(1s, now, now), boost::system::system_error);
+}
+
+TEST(AdaptiveTimeoutTest, TimeoutsWidenTheTimeout) {
+    Network::LatencyHistogram histogram;
+    for (int i = 0; i < 100; ++i) {
+        histogram.record(20ms);
+    }
+    auto timeout = Network::adaptiveTimeout(histogram, 0.999, 3.0, 1s, 300s);
+    ASSERT_EQ(timeout, 1s);
+
+    // Calls cut off at the timeout count as taking at least that long.
+    Network::recordTimeout(histogram, timeout);
+    EXPECT_GE(Network::adaptiveTimeout(histogram, 0.999, 3.0, 1s, 300s), 3s);
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include "Cache/DocumentFilter.hpp"
+#include "Util/BloomFilter.hpp"
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/use_future.hpp>
+
+#include <format>
+
+namespace {
+
+std::string fileId(int i) { return std::format("1Bx{:08}fileId", i); }
+
+Cache::DocumentFilter::Options filterOptions() {
+    Cache::DocumentFilter::Options result;
+    result.capacity = 1000;
+    result.falsePositiveRate = 0.01;
+    return result;
+}
+
+bool rebuild(Cache::DocumentFilter& filter, Cache::DocumentFilter::Loader load) {
+    boost::asio::io_context ioc;
+    auto done = boost::asio::co_spawn(ioc, filter.rebuild(load), boost::asio::use_future);
+    ioc.run();
+    return done.get();
+}
+
+}   // namespace
+
+TEST(BloomFilterTest, NoFalseNegativesAndBoundedFalsePositives) {
+    util::BloomFilter filter { 10000, 0.01 };
+    for (int i = 0; i < 10000; ++i) {
+        filter.add(fileId(i));
+    }
+    for (int i = 0; i < 10000; ++i) {
+        ASSERT_TRUE(filter.mightContain(fileId(i)));
+    }
+
+    int falsePositives = 0;
+    for (int i = 10000; i < 110000; ++i) {
+        falsePositives += filter.mightContain(fileId(i));
+    }
+    EXPECT_LT(falsePositives, 2000);
+    EXPECT_EQ(filter.items(), 10000u);
+}
+
+TEST(DocumentFilterTest, EverythingMightBeStoredUntilLoaded) {
+    Cache::DocumentFilter filter { filterOptions() };
+    EXPECT_FALSE(filter.ready());
+    EXPECT_TRUE(filter.mightContain("never-stored"));
+
+    auto failing = []() -> boost::asio::awaitable<std::optional<std::vector<std::string>>> { co_return std::nullopt; };
+    EXPECT_FALSE(rebuild(filter, failing));
+    EXPECT_TRUE(filter.mightContain("never-stored"));
+
+    auto stored = []() -> boost::asio::awaitable<std::optional<std::vector<std::string>>> {
+        co_return std::vector<std::string> { "a", "b" };
+    };
+    EXPECT_TRUE(rebuild(filter, stored));
+    EXPECT_TRUE(filter.ready());
+    EXPECT_TRUE(filter.mightContain("a"));
+    EXPECT_FALSE(filter.mightContain("never-stored"));
+
+    filter.add("c");
+    EXPECT_TRUE(filter.mightContain("c"));
+}
+
+TEST(DocumentFilterTest, KeepsIdsStoredWhileRebuilding) {
+    Cache::DocumentFilter filter { filterOptions() };
+
+    // The bulk query started before "late" was stored, so its result does not include it.
+    auto load = [&]() -> boost::asio::awaitable<std::optional<std::vector<std::string>>> {
+        co_await boost::asio::post(co_await boost::asio::this_coro::executor, boost::asio::use_awaitable);
+        filter.add("late");
+        co_return std::vector<std::string> { "early" };
+    };
+    EXPECT_TRUE(rebuild(filter, load));
+
+    EXPECT_TRUE(filter.mightContain("early"));
+    EXPECT_TRUE(filter.mightContain("late"));
+}
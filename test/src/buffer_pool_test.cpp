@@ -0,0 +1,129 @@
+#include "Util/BufferPool.hpp"
+#include "Session/PooledBody.hpp"
+
+#include <gtest/gtest.h>
+
+#include <boost/asio/buffer.hpp>
+#include <boost/beast/http/parser.hpp>
+
+#include <span>
+#include <string>
+#include <string_view>
+
+TEST(BufferPoolTest, RoundsUpToSizeClass) {
+    EXPECT_EQ(util::BufferPool::classSizeFor(1), util::BufferPool::minClassSize);
+    EXPECT_EQ(util::BufferPool::classSizeFor(5000), 8 * 1024);
+    EXPECT_EQ(util::BufferPool::classSizeFor(64 * 1024), 64 * 1024);
+}
+
+TEST(BufferPoolTest, ReusesReleasedBlock) {
+    util::BufferPool pool;
+
+    std::size_t capacity = 0;
+    auto* first = pool.acquire(10000, capacity);
+    EXPECT_EQ(capacity, 16 * 1024);
+    pool.release(first, capacity);
+    EXPECT_EQ(pool.retainedBytes(), 16 * 1024);
+
+    auto* second = pool.acquire(12000, capacity);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(pool.retainedBytes(), 0);
+    pool.release(second, capacity);
+}
+
+TEST(BufferPoolTest, RespectsRetainedLimit) {
+    util::BufferPool pool(8 * 1024);
+
+    std::size_t capacity = 0;
+    auto* first = pool.acquire(8 * 1024, capacity);
+    auto* second = pool.acquire(8 * 1024, capacity);
+    pool.release(first, capacity);
+    pool.release(second, capacity);
+
+    EXPECT_EQ(pool.retainedBytes(), 8 * 1024);
+}
+
+TEST(BufferPoolTest, RetainedLimitSpansAllClasses) {
+    util::BufferPool pool(64 * 1024);
+
+    std::size_t small = 0;
+    std::size_t large = 0;
+    auto* first = pool.acquire(32 * 1024, small);
+    auto* second = pool.acquire(64 * 1024, large);
+    pool.release(first, small);
+    pool.release(second, large);
+
+    EXPECT_EQ(pool.retainedBytes(), 32 * 1024);
+}
+
+TEST(PooledBufferTest, GrowKeepsContent) {
+    util::PooledBuffer buffer;
+    std::string chunk(3000, 'a');
+
+    for (int i = 0; i < 10; ++i) {
+        buffer.append(chunk.data(), chunk.size());
+    }
+
+    ASSERT_EQ(buffer.size(), 30000);
+    EXPECT_GE(buffer.capacity(), 30000);
+    EXPECT_EQ(buffer.view(), std::string(30000, 'a'));
+
+    std::span<unsigned char> bytes = buffer;
+    EXPECT_EQ(bytes.size(), buffer.size());
+}
+
+TEST(PooledBufferTest, CopyAndMove) {
+    util::PooledBuffer buffer;
+    buffer.append("payload", 7);
+
+    util::PooledBuffer copy = buffer;
+    EXPECT_EQ(copy.view(), "payload");
+    EXPECT_NE(copy.data(), buffer.data());
+
+    util::PooledBuffer moved = std::move(buffer);
+    EXPECT_EQ(moved.view(), "payload");
+    EXPECT_TRUE(buffer.empty());
+}
+
+TEST(PooledBodyTest, ParsesResponseWithContentLength) {
+    namespace http = boost::beast::http;
+
+    std::string_view raw =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Length: 11\r\n"
+        "\r\n"
+        "hello world";
+
+    http::response_parser<Network::PooledBody> parser;
+    boost::system::error_code ec;
+    parser.eager(true);
+    parser.put(boost::asio::buffer(raw.data(), raw.size()), ec);
+
+    ASSERT_FALSE(ec);
+    ASSERT_TRUE(parser.is_done());
+
+    auto res = parser.release();
+    EXPECT_EQ(res.body().view(), "hello world");
+    EXPECT_EQ(res.body().capacity(), util::BufferPool::minClassSize);
+}
+
+TEST(PooledBodyTest, ParsesChunkedResponse) {
+    namespace http = boost::beast::http;
+
+    std::string_view raw =
+        "HTTP/1.1 200 OK\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "\r\n"
+        "5\r\nhello\r\n"
+        "6\r\n world\r\n"
+        "0\r\n\r\n";
+
+    http::response_parser<Network::PooledBody> parser;
+    boost::system::error_code ec;
+    parser.eager(true);
+    parser.put(boost::asio::buffer(raw.data(), raw.size()), ec);
+
+    ASSERT_FALSE(ec);
+    ASSERT_TRUE(parser.is_done());
+    EXPECT_EQ(parser.get().body().view(), "hello world");
+}
@@ -0,0 +1,117 @@
+#include "Session/CircuitBreaker.hpp"
+#include "Util/Metrics.hpp"
+
+#include <boost/asio/error.hpp>
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+using namespace std::chrono_literals;
+namespace http = boost::beast::http;
+
+namespace {
+
+Network::CircuitBreaker::Options testOptions() {
+    Network::CircuitBreaker::Options options;
+    options.minRequests = 4;
+    options.failureRatio = 0.5;
+    options.openDuration = 1s;
+    options.halfOpenProbes = 2;
+    return options;
+}
+
+}   // namespace
+
+TEST(CircuitBreakerTest, TripsAfterFailureRatio) {
+    auto now = std::chrono::steady_clock::now();
+    Network::CircuitBreaker breaker { testOptions() };
+
+    breaker.onResult(http::status::ok, 1ms, now);
+    breaker.onResult(http::status::bad_gateway, 1ms, now);
+    breaker.onResult(http::status::ok, 1ms, now);
+    EXPECT_EQ(breaker.state(), Network::CircuitBreaker::State::Closed);
+
+    breaker.onError(boost::asio::error::connection_refused, now);
+    EXPECT_EQ(breaker.state(), Network::CircuitBreaker::State::Open);
+    EXPECT_FALSE(breaker.allow(now + 500ms));
+    EXPECT_EQ(breaker.rejected(), 1u);
+}
+
+TEST(CircuitBreakerTest, HalfOpenProbesCloseTheBreaker) {
+    auto now = std::chrono::steady_clock::now();
+    Network::CircuitBreaker breaker { testOptions() };
+    for (int i = 0; i < 4; ++i) {
+        breaker.onResult(http::status::service_unavailable, 1ms, now);
+    }
+    ASSERT_EQ(breaker.state(), Network::CircuitBreaker::State::Open);
+
+    auto later = now + 2s;
+    EXPECT_TRUE(breaker.allow(later));
+    EXPECT_TRUE(breaker.allow(later));
+    EXPECT_FALSE(breaker.allow(later));
+    EXPECT_EQ(breaker.state(), Network::CircuitBreaker::State::HalfOpen);
+
+    breaker.onResult(http::status::ok, 1ms, later);
+    breaker.onResult(http::status::ok, 1ms, later);
+    EXPECT_EQ(breaker.state(), Network::CircuitBreaker::State::Closed);
+}
+
+TEST(CircuitBreakerTest, FailedProbeReopens) {
+    auto now = std::chrono::steady_clock::now();
+    Network::CircuitBreaker breaker { testOptions() };
+    for (int i = 0; i < 4; ++i) {
+        breaker.onError(boost::asio::error::timed_out, now);
+    }
+
+    auto later = now + 2s;
+    ASSERT_TRUE(breaker.allow(later));
+    breaker.onResult(http::status::internal_server_error, 1ms, later);
+    EXPECT_EQ(breaker.state(), Network::CircuitBreaker::State::Open);
+    EXPECT_FALSE(breaker.allow(later + 500ms));
+}
+
+TEST(CircuitBreakerTest, CancellationIsNeutral) {
+    auto now = std::chrono::steady_clock::now();
+    Network::CircuitBreaker breaker { testOptions() };
+
+    for (int i = 0; i < 10; ++i) {
+        breaker.onError(boost::asio::error::operation_aborted, now);
+    }
+    EXPECT_EQ(breaker.state(), Network::CircuitBreaker::State::Closed);
+}
+
+TEST(CircuitBreakerTest, DroppedCallGivesBackItsProbeSlot) {
+    auto now = std::chrono::steady_clock::now();
+    Network::CircuitBreaker breaker { testOptions() };
+    for (int i = 0; i < 4; ++i) {
+        breaker.onError(boost::asio::error::timed_out, now);
+    }
+
+    auto later = now + 2s;
+    ASSERT_TRUE(breaker.allow(later));
+    {
+        Network::CircuitBreaker::Call cancelled { breaker };
+        cancelled.onError(boost::asio::error::operation_aborted);
+    }
+    ASSERT_TRUE(breaker.allow(later));
+    ASSERT_TRUE(breaker.allow(later));
+    EXPECT_FALSE(breaker.allow(later));
+
+    // A probe that ended in an unexpected exception failed; it must not hold the slot forever.
+    { Network::CircuitBreaker::Call dropped { breaker }; }
+    EXPECT_EQ(breaker.state(), Network::CircuitBreaker::State::Open);
+}
+
+TEST(CircuitBreakerTest, OpenErrorMapsToErrorCode) {
+    Network::CircuitOpenError error { "www.googleapis.com:443" };
+    EXPECT_EQ(error.code(), Network::CircuitError::open);
+}
+
+TEST(CircuitBreakerTest, ExportsStateMetrics) {
+    Network::CircuitBreakers::instance().get("metrics.example:443");
+
+    auto text = util::metrics::Registry::instance().render();
+    EXPECT_NE(text.find("# TYPE anty_circuit_breaker_state gauge"), std::string::npos);
+    EXPECT_NE(text.find("anty_circuit_breaker_state{upstream=\"metrics.example:443\"} 0"), std::string::npos);
+    EXPECT_NE(text.find("anty_circuit_breaker_rejected_total{upstream=\"metrics.example:443\"} 0"), std::string::npos);
+}
@@ -0,0 +1,211 @@
+#include "Session/ContentEncoding.hpp"
+#include "Session/PooledBody.hpp"
+#include "Util/Compression.hpp"
+
+#include <gtest/gtest.h>
+
+#include <boost/asio/buffer.hpp>
+#include <boost/beast/http/parser.hpp>
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string>
+
+#include <unistd.h>
+
+namespace {
+
+std::string sampleText() {
+    std::string text;
+    for (int i = 0; i < 5000; ++i) {
+        text += std::format("Paragraph {} of a submitted essay. ", i);
+    }
+    return text;
+}
+
+std::string sampleSection(int i) {
+    return std::format("Глава {}. В работе рассматриваются методы обнаружения заимствований в текстах "
+                       "выпускных квалификационных работ, а также приводится сравнение их точности. ", i);
+}
+
+}   // namespace
+
+TEST(CompressionTest, GzipRoundTrip) {
+    auto text = sampleText();
+    auto compressed = util::gzipCompress(text);
+
+    EXPECT_LT(compressed.size(), text.size() / 4);
+    EXPECT_EQ(util::gzipDecompress(compressed, text.size()), text);
+}
+
+TEST(CompressionTest, InflatesAcrossArbitrarySplits) {
+    auto text = sampleText();
+    auto compressed = util::gzipCompress(text);
+
+    util::GzipInflater inflater;
+    util::PooledBuffer out;
+    for (std::size_t offset = 0; offset < compressed.size(); offset += 7) {
+        auto size = std::min<std::size_t>(7, compressed.size() - offset);
+        ASSERT_TRUE(inflater.write(compressed.data() + offset, size, out, text.size()));
+    }
+
+    EXPECT_TRUE(inflater.finished());
+    EXPECT_EQ(out.view(), text);
+}
+
+TEST(CompressionTest, RejectsCorruptAndOversizedInput) {
+    EXPECT_FALSE(util::gzipDecompress("definitely not gzip", 1024).has_value());
+
+    auto compressed = util::gzipCompress(sampleText());
+    EXPECT_FALSE(util::gzipDecompress(compressed, 1024).has_value());
+    EXPECT_FALSE(util::gzipDecompress(compressed.substr(0, compressed.size() / 2), 1 << 20).has_value());
+}
+
+TEST(CompressionTest, PooledBodyInflatesGzipResponse) {
+    namespace http = boost::beast::http;
+
+    auto text = sampleText();
+    auto compressed = util::gzipCompress(text);
+    auto raw = std::format("HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\nContent-Length: {}\r\n\r\n", compressed.size()) +
+               compressed;
+
+    http::response_parser<Network::PooledBody> parser;
+    boost::system::error_code ec;
+    parser.eager(true);
+    parser.put(boost::asio::buffer(raw.data(), raw.size()), ec);
+
+    ASSERT_FALSE(ec);
+    ASSERT_TRUE(parser.is_done());
+
+    auto res = parser.release();
+    Network::decodeContentEncoding(res);
+    EXPECT_EQ(res.body().view(), text);
+    EXPECT_EQ(res.find(http::field::content_encoding), res.end());
+    EXPECT_EQ(res[http::field::content_length], std::to_string(text.size()));
+}
+
+TEST(CompressionTest, DecodesStringBodyResponse) {
+    namespace http = boost::beast::http;
+
+    http::response<http::string_body> res { http::status::ok, 11 };
+    res.set(http::field::content_encoding, "gzip");
+    res.body() = util::gzipCompress(R"({"courses":[]})");
+
+    Network::decodeContentEncoding(res);
+    EXPECT_EQ(res.body(), R"({"courses":[]})");
+}
+
+TEST(CompressionTest, AcceptEncodingSkipsRangeRequests) {
+    namespace http = boost::beast::http;
+
+    http::request<http::string_body> plain { http::verb::get, "/v1/courses", 11 };
+    Network::requestGzip(plain);
+    EXPECT_EQ(plain[http::field::accept_encoding], "gzip");
+
+    http::request<http::string_body> ranged { http::verb::get, "/drive/v3/files/x?alt=media", 11 };
+    ranged.set(http::field::range, "bytes=0-99");
+    Network::requestGzip(ranged);
+    EXPECT_EQ(ranged.find(http::field::accept_encoding), ranged.end());
+}
+
+TEST(CompressionTest, CompressesOnlyLargeRequestBodies) {
+    namespace http = boost::beast::http;
+
+    http::request<http::string_body> small { http::verb::post, "/analysis", 11 };
+    small.body() = "[]";
+    Network::gzipRequestBody(small, 1024);
+    EXPECT_EQ(small.find(http::field::content_encoding), small.end());
+
+    http::request<http::string_body> large { http::verb::post, "/analysis", 11 };
+    large.body() = sampleText();
+    Network::gzipRequestBody(large, 1024);
+    EXPECT_EQ(large[http::field::content_encoding], "gzip");
+    EXPECT_EQ(util::gzipDecompress(large.body(), 1 << 24), sampleText());
+}
+
+TEST(CompressionTest, ZstdRoundTripKeepsShortTextAsIs) {
+    util::ZstdCodec codec { util::ZstdCodec::Options {} };
+
+    auto text = sampleText();
+    auto frame = codec.compress(text);
+    ASSERT_TRUE(frame.has_value());
+    EXPECT_LT(frame->size(), text.size() / 4);
+    EXPECT_EQ(codec.decompress(*frame, text.size()), text);
+    EXPECT_FALSE(codec.decompress(*frame, text.size() - 1).has_value());
+
+    EXPECT_FALSE(codec.compress("Введение").has_value());
+    EXPECT_FALSE(codec.decompress("definitely not zstd", 1024).has_value());
+}
+
+TEST(CompressionTest, ZstdDictionaryFramesNeedTheSameDictionary) {
+    const auto path = std::filesystem::temp_directory_path() / std::format("zstd_dictionary_{}", ::getpid());
+    {
+        std::ofstream dictionary { path, std::ios::binary };
+        for (int i = 0; i < 50; ++i) {
+            dictionary << sampleSection(i);
+        }
+    }
+
+    util::ZstdCodec::Options options;
+    options.dictionaryPath = path.string();
+    util::ZstdCodec withDictionary { options };
+    util::ZstdCodec withoutDictionary { util::ZstdCodec::Options {} };
+    std::filesystem::remove(path);
+    ASSERT_TRUE(withDictionary.hasDictionary());
+
+    auto section = sampleSection(1000);
+    auto frame = withDictionary.compress(section);
+    ASSERT_TRUE(frame.has_value());
+    EXPECT_LT(frame->size(), section.size() / 4);
+    EXPECT_EQ(withDictionary.decompress(*frame, section.size()), section);
+    EXPECT_FALSE(withoutDictionary.decompress(*frame, section.size()).has_value());
+}
+
+TEST(CompressionTest, ZstdKeepsReadingFramesFromRetiredDictionaries) {
+    const auto directory = std::filesystem::temp_directory_path();
+    const auto oldPath = directory / std::format("zstd_old_dictionary_{}", ::getpid());
+    const auto newPath = directory / std::format("zstd_new_dictionary_{}", ::getpid());
+    {
+        std::ofstream oldDictionary { oldPath, std::ios::binary };
+        std::ofstream newDictionary { newPath, std::ios::binary };
+        for (int i = 0; i < 50; ++i) {
+            oldDictionary << sampleSection(i);
+            newDictionary << sampleSection(i + 500);
+        }
+    }
+
+    util::ZstdCodec::Options before;
+    before.dictionaryPath = oldPath.string();
+    util::ZstdCodec::Options rotated;
+    rotated.dictionaryPath = newPath.string();
+    rotated.retiredDictionaryPaths = { oldPath.string() };
+    util::ZstdCodec plain { util::ZstdCodec::Options {} };
+    util::ZstdCodec old { before };
+    util::ZstdCodec current { rotated };
+    std::filesystem::remove(oldPath);
+    std::filesystem::remove(newPath);
+
+    auto section = sampleSection(1000);
+    auto oldFrame = old.compress(section);
+    auto plainFrame = plain.compress(section + section);
+    auto newFrame = current.compress(section);
+    ASSERT_TRUE(oldFrame && plainFrame && newFrame);
+
+    EXPECT_EQ(current.decompress(*oldFrame, section.size()), section);
+    EXPECT_EQ(current.decompress(*plainFrame, 2 * section.size()), section + section);
+    EXPECT_EQ(current.decompress(*newFrame, section.size()), section);
+    EXPECT_FALSE(old.decompress(*newFrame, section.size()).has_value());
+}
+
+TEST(CompressionTest, ZstdRefusesMissingDictionaries) {
+    const auto missing = (std::filesystem::temp_directory_path() / std::format("zstd_missing_{}", ::getpid())).string();
+
+    util::ZstdCodec::Options current;
+    current.dictionaryPath = missing;
+    EXPECT_THROW(util::ZstdCodec { current }, std::runtime_error);
+
+    util::ZstdCodec::Options retired;
+    retired.retiredDictionaryPaths = { missing };
+    EXPECT_THROW(util::ZstdCodec { retired }, std::runtime_error);
+}
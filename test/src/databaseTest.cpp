@@ -11,7 +11,7 @@
 class FixtureDatabase : public testing::Test {
 protected:
     void SetUp() override {
-        database = std::make_shared<Network::DataBaseSession>();
+        database = std::make_shared<Network::RestDataBaseSession>();
     }
 
 public:
@@ -80,6 +80,26 @@ TEST_F(FixtureDatabase, SelectDocument) {
     EXPECT_EQ("Текст второго раздела тестового документа.", documentText[1].text);
 }
 
+TEST_F(FixtureDatabase, SelectDocumentsByIds) {
+    ASSERT_TRUE(database);
+    boost::asio::io_context io;
+
+    std::vector<std::string> ids { "test-external-document-id", "test-missing-document-id" };
+    auto selectResultFuture = boost::asio::co_spawn(
+      io,
+      database->selectDocumentsByIds(ids),
+      boost::asio::use_future
+    );
+
+    io.run();
+
+    auto documents = selectResultFuture.get();
+
+    ASSERT_EQ(documents.size(), 1u);
+    EXPECT_EQ("test-external-document-id", documents.front().docId);
+    EXPECT_EQ(documents.front().text.size(), 2u);
+}
+
 TEST_F(FixtureDatabase, DeleteDocument) {
     ASSERT_TRUE(database);
 
@@ -93,3 +113,25 @@ TEST_F(FixtureDatabase, DeleteDocument) {
     io.run();
     ASSERT_TRUE(deleteResult.get());
 }
+
+TEST_F(FixtureDatabase, InsertDocuments) {
+    ASSERT_TRUE(database);
+
+    std::vector<Document> documents;
+    documents.emplace_back(std::vector<Documents::Paragraph> { { .title = "Введение", .text = "Первый документ." } },
+                           "test-bulk-document-1");
+    documents.emplace_back(std::vector<Documents::Paragraph> {}, "test-bulk-document-2");
+
+    boost::asio::io_context io;
+    auto insertResult = boost::asio::co_spawn(io, database->insertDocuments(documents), boost::asio::use_future);
+    io.run();
+    ASSERT_TRUE(insertResult.get());
+
+    io.restart();
+    auto cleanup = boost::asio::co_spawn(io, [&]() -> boost::asio::awaitable<bool> {
+        co_return co_await database->deleteDocument("test-bulk-document-1")
+            && co_await database->deleteDocument("test-bulk-document-2");
+    }, boost::asio::use_future);
+    io.run();
+    EXPECT_TRUE(cleanup.get());
+}
@@ -58,3 +58,24 @@ TEST(EncryptTest, TextEncryptRejectsEmptyKey) {
         std::runtime_error
     );
 }
+
+TEST(EncryptTest, Base64RoundTripIgnoresLineBreaks) {
+    const std::string data { '\x28', '\xb5', '\x2f', '\xfd', '\0', 'z', 's', 't', 'd', '\xff' };
+
+    auto encoded = util::base64Encode(data);
+    EXPECT_EQ(encoded.find('\n'), std::string::npos);
+    EXPECT_EQ(util::base64Decode(encoded), data);
+
+    encoded.insert(8, "\n");
+    EXPECT_EQ(util::base64Decode(encoded), data);
+}
+
+TEST(EncryptTest, HmacSha256MatchesRfc4231) {
+    // RFC 4231 test case 2, base64url-encoded.
+    EXPECT_EQ(util::hmacSha256UrlSafe("Jefe", "what do ya want for nothing?"),
+              "W9zBRr9gdU5qBCQmCJV1x1oAPwidJzmDnexYuWTsOEM");
+
+    EXPECT_TRUE(util::constantTimeEquals("same", "same"));
+    EXPECT_FALSE(util::constantTimeEquals("same", "sane"));
+    EXPECT_FALSE(util::constantTimeEquals("same", "same!"));
+}
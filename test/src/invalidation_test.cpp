@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include "Cache/Invalidation.hpp"
+
+#include <boost/asio/io_context.hpp>
+
+#include <vector>
+
+using Cache::Invalidation;
+
+TEST(InvalidationTest, PayloadRoundTrip) {
+    auto payload = Cache::encodeInvalidation({ .kind = Invalidation::Kind::Session, .key = "5f2c9a" }, "node-a");
+    EXPECT_EQ(payload, "node-a session 5f2c9a");
+
+    auto received = Cache::decodeInvalidation(payload);
+    ASSERT_TRUE(received.has_value());
+    EXPECT_EQ(received->node, "node-a");
+    EXPECT_EQ(received->invalidation.kind, Invalidation::Kind::Session);
+    EXPECT_EQ(received->invalidation.key, "5f2c9a");
+
+    // Keys may contain spaces; only the first two separate fields.
+    received = Cache::decodeInvalidation("node-b document Курсовая работа.docx");
+    ASSERT_TRUE(received.has_value());
+    EXPECT_EQ(received->invalidation.kind, Invalidation::Kind::Document);
+    EXPECT_EQ(received->invalidation.key, "Курсовая работа.docx");
+}
+
+TEST(InvalidationTest, RejectsMalformedPayloads) {
+    EXPECT_FALSE(Cache::decodeInvalidation("").has_value());
+    EXPECT_FALSE(Cache::decodeInvalidation("node-a").has_value());
+    EXPECT_FALSE(Cache::decodeInvalidation("node-a session").has_value());
+    EXPECT_FALSE(Cache::decodeInvalidation("node-a session ").has_value());
+    EXPECT_FALSE(Cache::decodeInvalidation("node-a widget 42").has_value());
+    EXPECT_FALSE(Cache::decodeInvalidation(" session 42").has_value());
+}
+
+TEST(InvalidationTest, ListenerSkipsEventsFromItsOwnNode) {
+    boost::asio::io_context ioc;
+    std::vector<std::string> evicted;
+    Cache::InvalidationListener listener { "", ioc.get_executor(), [&](const Invalidation& invalidation) {
+        evicted.push_back(invalidation.key);
+    } };
+
+    listener.deliver(Cache::encodeInvalidation({ .kind = Invalidation::Kind::Tokens, .key = "own" }));
+    listener.deliver(Cache::encodeInvalidation({ .kind = Invalidation::Kind::Tokens, .key = "other" }, "another-node"));
+    listener.deliver("garbage");
+    EXPECT_TRUE(evicted.empty());
+
+    ioc.run();
+    EXPECT_EQ(evicted, std::vector<std::string> { "other" });
+}
@@ -65,3 +65,33 @@ TEST(NetworkUtil, CookieParse) {
         ASSERT_EQ(parsed.at("signed"), "value=with=equals");
     }
 }
+
+TEST(NetworkUtil, PostgrestInLists) {
+    {
+        std::vector<std::string> ids { "a1", "b-2" };
+        auto lists = util::network::postgrestInLists(ids, 1024);
+        ASSERT_EQ(lists.size(), 1u);
+        EXPECT_EQ(lists.front(), "(%22a1%22,%22b-2%22)");
+    }
+    {
+        std::vector<std::string> ids { "a,b", "c\"d" };
+        auto lists = util::network::postgrestInLists(ids, 1024);
+        ASSERT_EQ(lists.size(), 1u);
+        EXPECT_EQ(lists.front(), "(%22a%2Cb%22,%22c%5C%22d%22)");
+    }
+    {
+        std::vector<std::string> ids(10, std::string(20, 'x'));
+        auto lists = util::network::postgrestInLists(ids, 100);
+        ASSERT_GT(lists.size(), 1u);
+        for (const auto& list : lists) {
+            EXPECT_LE(list.size(), 100u);
+            EXPECT_TRUE(list.starts_with("(") && list.ends_with(")"));
+        }
+    }
+    EXPECT_TRUE(util::network::postgrestInLists({}, 100).empty());
+}
+
+TEST(NetworkUtil, PercentEncode) {
+    EXPECT_EQ(util::network::percentEncode("1AbC-x_y.z~"), "1AbC-x_y.z~");
+    EXPECT_EQ(util::network::percentEncode("a&b=c d"), "a%26b%3Dc%20d");
+}
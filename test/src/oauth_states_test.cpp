@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include "Auth/OAuthStates.hpp"
+#include "Auth/SessionTokens.hpp"
+
+using Network::Auth::OAuthStates;
+using Network::Auth::SessionTokens;
+using namespace std::chrono_literals;
+
+namespace {
+
+OAuthStates::Options stateOptions(std::vector<SessionTokens::Key> keys, std::size_t maxPending = 16) {
+    OAuthStates::Options result;
+    result.keys = std::move(keys);
+    result.lifetime = 300s;
+    result.maxPending = maxPending;
+    return result;
+}
+
+const auto NOW = OAuthStates::Clock::time_point { std::chrono::seconds { 1'800'000'000 } };
+
+}   // namespace
+
+TEST(OAuthStatesTest, StateIsAcceptedOnceBeforeExpiry) {
+    OAuthStates states { stateOptions({ { "k1", "first secret" } }) };
+
+    auto state = states.issue(NOW);
+    EXPECT_TRUE(OAuthStates::isSigned(state));
+    EXPECT_NE(states.issue(NOW), state);
+
+    EXPECT_TRUE(states.consume(state, NOW + 10s));
+    EXPECT_FALSE(states.consume(state, NOW + 11s));
+
+    auto late = states.issue(NOW);
+    EXPECT_FALSE(states.consume(late, NOW + 301s));
+}
+
+TEST(OAuthStatesTest, RejectsForeignAndTamperedStates) {
+    OAuthStates states { stateOptions({ { "k2", "second secret" }, { "k1", "first secret" } }) };
+    OAuthStates older { stateOptions({ { "k1", "first secret" } }) };
+    OAuthStates stranger { stateOptions({ { "k1", "guessed secret" } }) };
+
+    EXPECT_TRUE(states.consume(older.issue(NOW), NOW));
+    EXPECT_FALSE(states.consume(stranger.issue(NOW), NOW));
+
+    auto state = states.issue(NOW);
+    auto extended = state;
+    auto expiry = std::to_string(std::chrono::floor<std::chrono::seconds>(NOW + 300s).time_since_epoch().count());
+    extended.replace(extended.find(expiry), expiry.size(), std::to_string(std::stoll(expiry) + 3600));
+    EXPECT_FALSE(states.consume(extended, NOW));
+
+    // A session cookie signed with the same key is not a state.
+    SessionTokens sessions { SessionTokens::Options { .keys = { { "k2", "second secret" } } } };
+    auto cookie = sessions.issue(
+        { .sessionId = "abc", .userId = "user", .expiresAt = std::chrono::floor<std::chrono::seconds>(NOW + 1h) });
+    EXPECT_FALSE(OAuthStates::isSigned(cookie));
+    EXPECT_FALSE(states.consume(cookie, NOW));
+    EXPECT_TRUE(states.consume(state, NOW));
+}
+
+TEST(OAuthStatesTest, KeepsAcceptingStatesWhenTooManyArePending) {
+    OAuthStates states { stateOptions({ { "k1", "first secret" } }, 2) };
+
+    auto first = states.issue(NOW);
+    auto second = states.issue(NOW);
+    auto third = states.issue(NOW);
+    EXPECT_TRUE(states.consume(first, NOW));
+    EXPECT_TRUE(states.consume(second, NOW));
+    EXPECT_FALSE(states.consume(first, NOW));
+
+    // A full window lets logins through and stops remembering their states.
+    EXPECT_TRUE(states.consume(third, NOW));
+    EXPECT_TRUE(states.consume(third, NOW));
+
+    // Once the window's states expire it is dropped and remembers again.
+    auto later = states.issue(NOW + 700s);
+    EXPECT_TRUE(states.consume(later, NOW + 700s));
+    EXPECT_FALSE(states.consume(later, NOW + 700s));
+}
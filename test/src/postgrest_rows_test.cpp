@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+
+#include "Session/PostgrestRows.hpp"
+#include "Util/Compression.hpp"
+#include "Util/Encrypt.hpp"
+
+#include <format>
+#include <string>
+
+using namespace Network::postgrest;
+
+TEST(PostgrestRowsTest, DecodesRowsWithNullableColumns) {
+    auto rows = decodeRows<AuthUserRow>(
+        R"([{"id":"6f1c","google_sub":"1234","email":"a@b.c","name":null,"picture_url":"https://x/p.png"}])");
+
+    ASSERT_TRUE(rows.has_value());
+    ASSERT_EQ(rows->size(), 1u);
+
+    auto user = toModel(std::move(rows->front()));
+    EXPECT_EQ(user.id, "6f1c");
+    EXPECT_EQ(user.googleSub, "1234");
+    EXPECT_EQ(user.name, "");
+    EXPECT_EQ(user.pictureUrl, "https://x/p.png");
+
+    auto sessions = decodeRows<AppSessionRow>("[]");
+    ASSERT_TRUE(sessions.has_value());
+    EXPECT_TRUE(sessions->empty());
+}
+
+TEST(PostgrestRowsTest, DecodesDocumentsWithPlainAndCompressedSections) {
+    std::string longText;
+    for (int i = 0; i < 20; ++i) {
+        longText += std::format("Раздел {} пояснительной записки. ", i);
+    }
+    auto frame = util::ZstdCodec::sections().compress(longText);
+    ASSERT_TRUE(frame.has_value());
+
+    auto body = std::format(
+        R"([{{"external_id":"doc-1","document_sections":[)"
+        R"({{"title":"Введение","content":"Текст \"в кавычках\"","content_zstd":null}},)"
+        R"({{"title":"Глава 1","content":null,"content_zstd":"{}"}}]}},)"
+        R"({{"external_id":"doc-2","document_sections":[]}}])",
+        util::base64Encode(*frame));
+
+    auto rows = decodeRows<DocumentRow>(body);
+    ASSERT_TRUE(rows.has_value());
+    ASSERT_EQ(rows->size(), 2u);
+
+    auto document = toModel(std::move(rows->front()));
+    EXPECT_EQ(document.docId, "doc-1");
+    ASSERT_EQ(document.text.size(), 2u);
+    EXPECT_EQ(document.text[0].text, "Текст \"в кавычках\"");
+    EXPECT_EQ(document.text[1].title, "Глава 1");
+    EXPECT_EQ(document.text[1].text, longText);
+
+    EXPECT_TRUE(toModel(std::move(rows->back())).text.empty());
+}
+
+TEST(PostgrestRowsTest, RejectsUnexpectedBodies) {
+    EXPECT_FALSE(decodeRows<OAuthStateRow>(R"({"message":"permission denied"})").has_value());
+    EXPECT_FALSE(decodeRows<OAuthStateRow>(R"([{"state_hash":"x","consumed_at":null}])").has_value());
+    EXPECT_FALSE(decodeRows<OAuthStateRow>(R"([{"state_hash":)").has_value());
+}
@@ -0,0 +1,98 @@
+#include "Session/ConnectionPool.hpp"
+#include "Session/RangeDownload.hpp"
+
+#include <gtest/gtest.h>
+
+#include <boost/asio/io_context.hpp>
+
+namespace {
+
+struct FakeSession {
+    explicit FakeSession(boost::asio::any_io_executor) {}
+
+    bool reusableFor(std::string_view upstream) const { return open && (host.empty() || host == upstream); }
+
+    bool open = true;
+    std::string host;
+};
+
+}   // namespace
+
+TEST(RangeDownloadTest, ParsesContentRange) {
+    auto range = Network::parseContentRange("bytes 0-4194303/31457280");
+
+    ASSERT_TRUE(range.has_value());
+    EXPECT_EQ(range->first, 0u);
+    EXPECT_EQ(range->last, 4194303u);
+    EXPECT_EQ(range->total, 31457280u);
+}
+
+TEST(RangeDownloadTest, RejectsMalformedContentRange) {
+    EXPECT_FALSE(Network::parseContentRange("").has_value());
+    EXPECT_FALSE(Network::parseContentRange("bytes 0-10/*").has_value());
+    EXPECT_FALSE(Network::parseContentRange("bytes 10-5/100").has_value());
+    EXPECT_FALSE(Network::parseContentRange("bytes 0-100/100").has_value());
+    EXPECT_FALSE(Network::parseContentRange("items 0-1/2").has_value());
+}
+
+TEST(RangeDownloadTest, FormatsRangeHeader) { EXPECT_EQ(Network::rangeHeader(100, 199), "bytes=100-199"); }
+
+TEST(ConnectionPoolTest, ReusesReleasedSessions) {
+    boost::asio::io_context ioc;
+    Network::ConnectionPool<FakeSession> pool { 1 };
+
+    auto first = pool.acquire(ioc.get_executor(), "drive:443");
+    auto* raw = first.get();
+    pool.release("drive:443", std::move(first));
+    EXPECT_EQ(pool.idle("drive:443"), 1u);
+
+    auto reused = pool.acquire(ioc.get_executor(), "drive:443");
+    EXPECT_EQ(reused.get(), raw);
+    EXPECT_EQ(pool.idle("drive:443"), 0u);
+    EXPECT_NE(pool.acquire(ioc.get_executor(), "other:443").get(), raw);
+}
+
+TEST(ConnectionPoolTest, CapsIdleSessionsPerUpstream) {
+    boost::asio::io_context ioc;
+    Network::ConnectionPool<FakeSession> pool { 1 };
+
+    pool.release("drive:443", pool.acquire(ioc.get_executor(), "drive:443"));
+    pool.release("drive:443", pool.acquire(ioc.get_executor(), "other:443"));
+    EXPECT_EQ(pool.idle("drive:443"), 1u);
+}
+
+TEST(ConnectionPoolTest, DropsSessionsIdleTooLong) {
+    boost::asio::io_context ioc;
+    Network::ConnectionPool<FakeSession> pool { 4, std::chrono::seconds(30) };
+    auto now = std::chrono::steady_clock::now();
+
+    auto session = pool.acquire(ioc.get_executor(), "drive:443", now);
+    auto* raw = session.get();
+    pool.release("drive:443", session, now);
+
+    auto fresh = pool.acquire(ioc.get_executor(), "drive:443", now + std::chrono::seconds(31));
+    EXPECT_NE(fresh.get(), raw);
+    EXPECT_EQ(pool.idle("drive:443"), 0u);
+}
+
+TEST(ConnectionPoolTest, DropsClosedAndRedirectedSessions) {
+    boost::asio::io_context ioc;
+    Network::ConnectionPool<FakeSession> pool { 4 };
+
+    auto closed = pool.acquire(ioc.get_executor(), "drive:443");
+    closed->open = false;
+    pool.release("drive:443", std::move(closed));
+
+    auto redirected = pool.acquire(ioc.get_executor(), "drive:443");
+    redirected->host = "googleusercontent:443";
+    pool.release("drive:443", std::move(redirected));
+    EXPECT_EQ(pool.idle("drive:443"), 0u);
+
+    // A pooled connection the upstream closed while idle is skipped on the way out.
+    auto idle = pool.acquire(ioc.get_executor(), "drive:443");
+    auto* raw = idle.get();
+    pool.release("drive:443", idle);
+    idle->open = false;
+    EXPECT_NE(pool.acquire(ioc.get_executor(), "drive:443").get(), raw);
+    EXPECT_EQ(pool.idle("drive:443"), 0u);
+}
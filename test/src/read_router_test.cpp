@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include "Session/ReadRouter.hpp"
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/use_future.hpp>
+
+#include <map>
+
+using Network::ReadRouter;
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr auto READ = ReadRouter::Access::Read;
+constexpr auto WRITE = ReadRouter::Access::Write;
+
+ReadRouter::Options twoReplicas() {
+    ReadRouter::Options result;
+    result.readEndpoints = { "localhost:15432", "localhost:15433" };
+    result.stickiness = 2000ms;
+    result.failuresToEject = 2;
+    return result;
+}
+
+// Stand-ins for the two read endpoints: a missing latency means the endpoint is down.
+struct StandIns {
+    std::map<std::string, std::optional<std::chrono::microseconds>> latency;
+
+    ReadRouter::Probe probe() {
+        return [this](std::string endpoint) -> boost::asio::awaitable<std::optional<std::chrono::microseconds>> {
+            co_return latency.at(endpoint);
+        };
+    }
+};
+
+void probeOnce(ReadRouter& router, const ReadRouter::Probe& probe) {
+    boost::asio::io_context ioc;
+    auto done = boost::asio::co_spawn(ioc, router.probeAll(probe), boost::asio::use_future);
+    ioc.run();
+    done.get();
+}
+
+}   // namespace
+
+TEST(ReadRouterTest, ReadsGoToTheFastestHealthyEndpoint) {
+    ReadRouter router { "db.example.co", twoReplicas() };
+    StandIns standIns { { { "localhost:15432", 9000us }, { "localhost:15433", 1500us } } };
+
+    probeOnce(router, standIns.probe());
+    EXPECT_EQ(router.route(READ, "auth_user:1"), "localhost:15433");
+    EXPECT_EQ(router.route(WRITE, "auth_user:1"), "db.example.co");
+
+    // The smoothed latency follows a slowdown after a few samples.
+    standIns.latency["localhost:15433"] = 40000us;
+    for (int i = 0; i < 5; ++i) {
+        probeOnce(router, standIns.probe());
+    }
+    EXPECT_EQ(router.route(READ, "auth_user:1"), "localhost:15432");
+}
+
+TEST(ReadRouterTest, EjectsFailingEndpointsAndFallsBackToPrimary) {
+    ReadRouter router { "db.example.co", twoReplicas() };
+    StandIns standIns { { { "localhost:15432", 1000us }, { "localhost:15433", 2000us } } };
+    probeOnce(router, standIns.probe());
+
+    standIns.latency["localhost:15432"] = std::nullopt;
+    probeOnce(router, standIns.probe());
+    EXPECT_TRUE(router.healthy("localhost:15432"));
+    probeOnce(router, standIns.probe());
+    EXPECT_FALSE(router.healthy("localhost:15432"));
+    EXPECT_EQ(router.route(READ, "document:a"), "localhost:15433");
+
+    // Failed calls count the same as failed probes.
+    router.report("localhost:15433", std::nullopt);
+    router.report("localhost:15433", std::nullopt);
+    EXPECT_EQ(router.route(READ, "document:a"), "db.example.co");
+
+    // One good probe brings an endpoint back.
+    standIns.latency["localhost:15432"] = 1000us;
+    probeOnce(router, standIns.probe());
+    EXPECT_TRUE(router.healthy("localhost:15432"));
+    EXPECT_EQ(router.route(READ, "document:a"), "localhost:15432");
+}
+
+TEST(ReadRouterTest, ReadsOfRecentlyWrittenKeysStayOnPrimary) {
+    ReadRouter router { "db.example.co", twoReplicas() };
+    StandIns standIns { { { "localhost:15432", 1000us }, { "localhost:15433", 2000us } } };
+    probeOnce(router, standIns.probe());
+
+    const auto now = ReadRouter::Clock::now();
+    router.wrote("app_session:abc", now);
+
+    EXPECT_EQ(router.route(READ, "app_session:abc", now + 500ms), "db.example.co");
+    EXPECT_EQ(router.route(READ, "app_session:other", now + 500ms), "localhost:15432");
+
+    const std::vector<std::string> batch { "document:x", "app_session:abc" };
+    EXPECT_EQ(router.route(READ, batch, now + 500ms), "db.example.co");
+
+    EXPECT_EQ(router.route(READ, "app_session:abc", now + 2500ms), "localhost:15432");
+}
+
+TEST(ReadRouterTest, WithoutReadEndpointsEverythingGoesToPrimary) {
+    ReadRouter router { "db.example.co", ReadRouter::Options {} };
+
+    EXPECT_FALSE(router.hasReadEndpoints());
+    EXPECT_EQ(router.route(READ, "tokens:1"), "db.example.co");
+    router.report("db.example.co", std::nullopt);
+    EXPECT_EQ(router.route(READ, "tokens:1"), "db.example.co");
+}
@@ -0,0 +1,146 @@
+#include "Cache/ResponseCache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+Cache::ResponseCache::Options testOptions() {
+    Cache::ResponseCache::Options options;
+    options.ttl = 30s;
+    options.staleWindow = 60s;
+    options.maxBytesPerUser = 100;
+    options.maxUsers = 2;
+    return options;
+}
+
+Cache::CachedResponse response(std::string body, std::chrono::steady_clock::time_point storedAt) {
+    return Cache::CachedResponse { .body = std::move(body), .etag = "\"v1\"", .storedAt = storedAt };
+}
+
+}   // namespace
+
+TEST(ResponseCacheTest, FreshnessFollowsAge) {
+    auto now = std::chrono::steady_clock::now();
+    Cache::ResponseCache cache { testOptions() };
+    cache.store("user", "/v1/courses", response("[]", now));
+
+    EXPECT_EQ(cache.find("user", "/v1/courses", now + 10s)->freshness, Cache::ResponseCache::Freshness::Fresh);
+    EXPECT_EQ(cache.find("user", "/v1/courses", now + 40s)->freshness, Cache::ResponseCache::Freshness::Stale);
+    EXPECT_EQ(cache.find("user", "/v1/courses", now + 100s)->freshness, Cache::ResponseCache::Freshness::Expired);
+    EXPECT_FALSE(cache.find("other", "/v1/courses", now).has_value());
+}
+
+TEST(ResponseCacheTest, RefreshRestartsTtl) {
+    auto now = std::chrono::steady_clock::now();
+    Cache::ResponseCache cache { testOptions() };
+    cache.store("user", "/v1/courses", response("[]", now));
+
+    cache.refresh("user", "/v1/courses", now + 100s);
+    auto hit = cache.find("user", "/v1/courses", now + 110s);
+
+    ASSERT_TRUE(hit.has_value());
+    EXPECT_EQ(hit->freshness, Cache::ResponseCache::Freshness::Fresh);
+    EXPECT_EQ(hit->response->etag, "\"v1\"");
+}
+
+TEST(ResponseCacheTest, SingleRevalidationPerEntry) {
+    Cache::ResponseCache cache { testOptions() };
+    cache.store("user", "/v1/courses", response("[]", std::chrono::steady_clock::now()));
+
+    EXPECT_TRUE(cache.beginRevalidation("user", "/v1/courses"));
+    EXPECT_FALSE(cache.beginRevalidation("user", "/v1/courses"));
+    cache.endRevalidation("user", "/v1/courses");
+    EXPECT_TRUE(cache.beginRevalidation("user", "/v1/courses"));
+    EXPECT_FALSE(cache.beginRevalidation("user", "/v1/missing"));
+}
+
+TEST(ResponseCacheTest, BoundsBytesPerUser) {
+    auto now = std::chrono::steady_clock::now();
+    Cache::ResponseCache cache { testOptions() };
+
+    cache.store("user", "/a", response(std::string(40, 'a'), now));
+    cache.store("user", "/b", response(std::string(40, 'b'), now));
+    cache.find("user", "/a", now);
+    cache.store("user", "/c", response(std::string(40, 'c'), now));
+
+    EXPECT_TRUE(cache.find("user", "/a", now).has_value());
+    EXPECT_FALSE(cache.find("user", "/b", now).has_value());
+    EXPECT_TRUE(cache.find("user", "/c", now).has_value());
+    EXPECT_LE(cache.userBytes("user"), 100u);
+
+    cache.store("user", "/huge", response(std::string(200, 'h'), now));
+    EXPECT_FALSE(cache.find("user", "/huge", now).has_value());
+}
+
+TEST(ResponseCacheTest, EvictsUsers) {
+    auto now = std::chrono::steady_clock::now();
+    Cache::ResponseCache cache { testOptions() };
+
+    cache.store("alice", "/v1/courses", response("[]", now));
+    cache.store("bob", "/v1/courses", response("[]", now));
+    cache.evictUser("alice");
+    EXPECT_FALSE(cache.find("alice", "/v1/courses", now).has_value());
+    EXPECT_TRUE(cache.find("bob", "/v1/courses", now).has_value());
+
+    cache.store("carol", "/v1/courses", response("[]", now));
+    cache.store("dave", "/v1/courses", response("[]", now));
+    EXPECT_FALSE(cache.find("bob", "/v1/courses", now).has_value());
+}
+
+TEST(ResponseCacheTest, BoundsBytesAcrossUsers) {
+    auto now = std::chrono::steady_clock::now();
+    auto options = testOptions();
+    options.maxUsers = 4;
+    options.maxBytes = 150;
+    Cache::ResponseCache cache { options };
+
+    cache.store("alice", "/a", response(std::string(60, 'a'), now));
+    cache.store("bob", "/a", response(std::string(60, 'b'), now));
+    cache.find("alice", "/a", now);
+    cache.store("carol", "/a", response(std::string(60, 'c'), now));
+
+    EXPECT_TRUE(cache.find("alice", "/a", now).has_value());
+    EXPECT_FALSE(cache.find("bob", "/a", now).has_value());
+    EXPECT_TRUE(cache.find("carol", "/a", now).has_value());
+    EXPECT_LE(cache.totalBytes(), 150u);
+}
+
+TEST(ResponseCacheTest, RefreshTakesNewValidators) {
+    auto now = std::chrono::steady_clock::now();
+    Cache::ResponseCache cache { testOptions() };
+    cache.store("user", "/v1/courses", response("[]", now));
+
+    cache.refresh("user", "/v1/courses", "\"v2\"", "", now + 40s);
+    auto hit = cache.find("user", "/v1/courses", now + 50s);
+
+    ASSERT_TRUE(hit.has_value());
+    EXPECT_EQ(hit->freshness, Cache::ResponseCache::Freshness::Fresh);
+    EXPECT_EQ(hit->response->etag, "\"v2\"");
+    EXPECT_EQ(cache.userBytes("user"), hit->response->bytes());
+}
+
+TEST(ResponseCacheTest, FetchesStartedBeforeEvictionAreNotStored) {
+    auto now = std::chrono::steady_clock::now();
+    Cache::ResponseCache cache { testOptions() };
+
+    auto before = cache.generation();
+    cache.evictUser("alice");
+    cache.store("alice", "/v1/courses", response("[]", now), before);
+    cache.store("bob", "/v1/courses", response("[]", now), before);
+    EXPECT_FALSE(cache.find("alice", "/v1/courses", now).has_value());
+    EXPECT_TRUE(cache.find("bob", "/v1/courses", now).has_value());
+
+    cache.store("alice", "/v1/courses", response("[]", now), cache.generation());
+    EXPECT_TRUE(cache.find("alice", "/v1/courses", now).has_value());
+
+    // Once old evictions are forgotten, anything fetched before that is refused.
+    auto stale = cache.generation();
+    cache.evictUser("carol");
+    cache.evictUser("dave");
+    cache.store("bob", "/v1/grades", response("[]", now), stale);
+    EXPECT_FALSE(cache.find("bob", "/v1/grades", now).has_value());
+}
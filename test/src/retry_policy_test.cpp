@@ -0,0 +1,81 @@
+#include "Session/RetryPolicy.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+using namespace std::chrono_literals;
+namespace http = boost::beast::http;
+
+TEST(RetryPolicyTest, ClassifiesResponses) {
+    EXPECT_EQ(Network::classifyResponse(http::status::ok), Network::ResponseClass::Success);
+    EXPECT_EQ(Network::classifyResponse(http::status::found), Network::ResponseClass::Success);
+    EXPECT_EQ(Network::classifyResponse(http::status::too_many_requests), Network::ResponseClass::Retryable);
+    EXPECT_EQ(Network::classifyResponse(http::status::service_unavailable), Network::ResponseClass::Retryable);
+    EXPECT_EQ(Network::classifyResponse(http::status::not_found), Network::ResponseClass::Fatal);
+    EXPECT_EQ(Network::classifyResponse(http::status::forbidden), Network::ResponseClass::Fatal);
+}
+
+TEST(RetryPolicyTest, IdempotentMethods) {
+    EXPECT_TRUE(Network::isIdempotent(http::verb::get));
+    EXPECT_TRUE(Network::isIdempotent(http::verb::delete_));
+    EXPECT_FALSE(Network::isIdempotent(http::verb::post));
+    EXPECT_FALSE(Network::isIdempotent(http::verb::patch));
+}
+
+TEST(RetryPolicyTest, ParsesRetryAfterSeconds) {
+    EXPECT_EQ(Network::parseRetryAfter("120"), std::chrono::milliseconds(120s));
+    EXPECT_FALSE(Network::parseRetryAfter("").has_value());
+    EXPECT_FALSE(Network::parseRetryAfter("soon").has_value());
+}
+
+TEST(RetryPolicyTest, ParsesRetryAfterHttpDate) {
+    auto now = std::chrono::sys_days { std::chrono::year { 2026 } / 5 / 6 } + 8h;
+    auto delay = Network::parseRetryAfter("Wed, 06 May 2026 08:00:30 GMT", now);
+
+    ASSERT_TRUE(delay.has_value());
+    EXPECT_EQ(*delay, std::chrono::milliseconds(30s));
+}
+
+TEST(RetryPolicyTest, JitterStaysWithinBounds) {
+    Network::DecorrelatedJitter jitter { 100ms, 2s };
+
+    for (int i = 0; i < 100; ++i) {
+        auto delay = jitter.next();
+        EXPECT_GE(delay, 100ms);
+        EXPECT_LE(delay, 2s);
+    }
+}
+
+TEST(RetryPolicyTest, TokenBucketSpreadsBurst) {
+    auto now = std::chrono::steady_clock::now();
+    Network::TokenBucket bucket { 10.0, 2.0 };
+
+    EXPECT_EQ(bucket.reserve(now), 0ms);
+    EXPECT_EQ(bucket.reserve(now), 0ms);
+    EXPECT_EQ(bucket.reserve(now), 100ms);
+    EXPECT_EQ(bucket.reserve(now), 200ms);
+    EXPECT_EQ(bucket.reserve(now + 1s), 0ms);
+}
+
+TEST(RetryPolicyTest, RetryBudgetIsPerHost) {
+    Network::RetryGovernor governor { 0.5, 1.0, 10.0, 1.0 };
+
+    governor.onRequest("www.googleapis.com");
+    governor.onRequest("www.googleapis.com");
+
+    EXPECT_TRUE(governor.tryRetry("www.googleapis.com"));
+    EXPECT_FALSE(governor.tryRetry("www.googleapis.com"));
+    EXPECT_FALSE(governor.tryRetry("example.supabase.co"));
+}
+
+TEST(RetryPolicyTest, QuotaOnlyAppliesToGoogleApis) {
+    Network::RetryGovernor governor { 0.2, 10.0, 1.0, 1.0 };
+
+    EXPECT_EQ(governor.reserveQuota("example.supabase.co", "Bearer a"), 0ms);
+    EXPECT_EQ(governor.reserveQuota("example.supabase.co", "Bearer a"), 0ms);
+
+    EXPECT_EQ(governor.reserveQuota("www.googleapis.com", "Bearer a"), 0ms);
+    EXPECT_GT(governor.reserveQuota("classroom.googleapis.com", "Bearer a"), 0ms);
+    EXPECT_EQ(governor.reserveQuota("www.googleapis.com", "Bearer b"), 0ms);
+}
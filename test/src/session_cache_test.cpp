@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include "Cache/SessionCache.hpp"
+
+namespace {
+
+Network::AppSession session(std::string expiresAt = "2999-01-01T00:00:00Z") {
+    return { .id = "id", .userId = "user", .sessionHash = "hash", .expiresAt = std::move(expiresAt), .revokedAt = {} };
+}
+
+Cache::SessionCache::Options options() {
+    Cache::SessionCache::Options result;
+    result.shards = 4;
+    result.maxEntries = 64;
+    return result;
+}
+
+}   // namespace
+
+TEST(SessionCacheTest, HitUntilTtl) {
+    Cache::SessionCache cache { options() };
+    auto now = Cache::SessionCache::Clock::now();
+
+    EXPECT_FALSE(cache.find("hash", now));
+
+    cache.store("hash", session(), now);
+    auto hit = cache.find("hash", now + std::chrono::seconds(29));
+    ASSERT_TRUE(hit);
+    ASSERT_TRUE(hit->session);
+    EXPECT_EQ(hit->session->userId, "user");
+
+    EXPECT_FALSE(cache.find("hash", now + std::chrono::seconds(30)));
+}
+
+TEST(SessionCacheTest, BoundedBySessionExpiry) {
+    Cache::SessionCache cache { options() };
+    auto now = std::chrono::sys_days { std::chrono::year { 2030 } / 1 / 1 } + std::chrono::hours(12);
+
+    cache.store("hash", session("2030-01-01T12:00:10Z"), now);
+    EXPECT_TRUE(cache.find("hash", now + std::chrono::seconds(9)));
+    EXPECT_FALSE(cache.find("hash", now + std::chrono::seconds(10)));
+
+    cache.store("expired", session("2030-01-01T11:00:00Z"), now);
+    EXPECT_FALSE(cache.find("expired", now));
+}
+
+TEST(SessionCacheTest, NegativeEntries) {
+    Cache::SessionCache cache { options() };
+    auto now = Cache::SessionCache::Clock::now();
+
+    cache.storeMissing("bogus", now);
+    auto hit = cache.find("bogus", now + std::chrono::seconds(4));
+    ASSERT_TRUE(hit);
+    EXPECT_FALSE(hit->session);
+
+    EXPECT_FALSE(cache.find("bogus", now + std::chrono::seconds(5)));
+}
+
+TEST(SessionCacheTest, RevokeWinsOverRacingLookup) {
+    Cache::SessionCache cache { options() };
+    auto now = Cache::SessionCache::Clock::now();
+
+    cache.store("hash", session(), now);
+    cache.revoke("hash", now);
+    cache.store("hash", session(), now);
+
+    auto hit = cache.find("hash", now);
+    ASSERT_TRUE(hit);
+    EXPECT_FALSE(hit->session);
+
+    cache.forget("hash");
+    EXPECT_FALSE(cache.find("hash", now));
+}
+
+TEST(SessionCacheTest, StaysWithinCapacity) {
+    Cache::SessionCache cache { options() };
+    auto now = Cache::SessionCache::Clock::now();
+
+    for (int i = 0; i < 1000; ++i) {
+        cache.storeMissing("hash-" + std::to_string(i), now);
+    }
+    EXPECT_LE(cache.size(), 64u);
+}
+
+TEST(SessionCacheTest, UnknownHashesDoNotEvictSessions) {
+    auto limited = options();
+    limited.maxMissing = 16;
+    Cache::SessionCache cache { limited };
+    auto now = Cache::SessionCache::Clock::now();
+
+    for (int i = 0; i < 32; ++i) {
+        cache.store("live-" + std::to_string(i), session(), now);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        cache.storeMissing("bogus-" + std::to_string(i), now);
+    }
+
+    EXPECT_LE(cache.size(), 48u);
+    for (int i = 0; i < 32; ++i) {
+        auto hit = cache.find("live-" + std::to_string(i), now);
+        ASSERT_TRUE(hit) << i;
+        EXPECT_TRUE(hit->session);
+    }
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include "Auth/RevocationSet.hpp"
+#include "Auth/SessionTokens.hpp"
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/use_future.hpp>
+
+using Network::Auth::RevocationSet;
+using Network::Auth::SessionTokens;
+using namespace std::chrono_literals;
+
+namespace {
+
+SessionTokens::Options keys(std::vector<SessionTokens::Key> keys) {
+    SessionTokens::Options result;
+    result.keys = std::move(keys);
+    return result;
+}
+
+const auto NOW = std::chrono::sys_seconds { std::chrono::seconds { 1'800'000'000 } };
+
+SessionTokens::Claims claims() {
+    return { .sessionId = "Zm9vYmFyLXNlc3Npb24taWQ", .userId = "7d0f5a52-0c1e-4d0b-9a57-3f0a1c2b4e6d",
+             .expiresAt = NOW + std::chrono::days { 7 } };
+}
+
+bool refresh(RevocationSet& set, RevocationSet::Loader load) {
+    boost::asio::io_context ioc;
+    auto done = boost::asio::co_spawn(ioc, set.refresh(load), boost::asio::use_future);
+    ioc.run();
+    return done.get();
+}
+
+}   // namespace
+
+TEST(SessionTokensTest, IssuedTokensVerifyUntilExpiry) {
+    SessionTokens tokens { keys({ { "k1", "first secret" } }) };
+    auto token = tokens.issue(claims());
+
+    EXPECT_TRUE(SessionTokens::isSigned(token));
+    EXPECT_FALSE(SessionTokens::isSigned("Zm9vYmFyLXNlc3Npb24taWQ"));
+
+    auto verified = tokens.verify(token, NOW);
+    ASSERT_TRUE(verified.has_value());
+    EXPECT_EQ(verified->sessionId, claims().sessionId);
+    EXPECT_EQ(verified->userId, claims().userId);
+    EXPECT_EQ(verified->expiresAt, claims().expiresAt);
+
+    EXPECT_FALSE(tokens.verify(token, claims().expiresAt).has_value());
+}
+
+TEST(SessionTokensTest, RejectsTamperedAndMalformedTokens) {
+    SessionTokens tokens { keys({ { "k1", "first secret" } }) };
+    auto token = tokens.issue(claims());
+
+    auto otherUser = token;
+    otherUser.replace(otherUser.find("7d0f"), 4, "7d0e");
+    EXPECT_FALSE(tokens.verify(otherUser, NOW).has_value());
+
+    auto laterExpiry = claims();
+    laterExpiry.expiresAt += std::chrono::days { 365 };
+    auto forged = SessionTokens { keys({ { "k1", "guessed secret" } }) }.issue(laterExpiry);
+    EXPECT_FALSE(tokens.verify(forged, NOW).has_value());
+
+    EXPECT_FALSE(tokens.verify("", NOW).has_value());
+    EXPECT_FALSE(tokens.verify("s1.k1", NOW).has_value());
+    EXPECT_FALSE(tokens.verify(token + ".extra", NOW).has_value());
+    EXPECT_FALSE(tokens.verify("s2" + token.substr(2), NOW).has_value());
+}
+
+TEST(SessionTokensTest, RotatedKeysKeepOlderTokensValid) {
+    SessionTokens before { keys({ { "k1", "first secret" } }) };
+    SessionTokens rotated { keys({ { "k2", "second secret" }, { "k1", "first secret" } }) };
+    SessionTokens retired { keys({ { "k2", "second secret" } }) };
+
+    auto oldToken = before.issue(claims());
+    auto newToken = rotated.issue(claims());
+
+    EXPECT_NE(newToken.find(".k2."), std::string::npos);
+    EXPECT_TRUE(rotated.verify(oldToken, NOW).has_value());
+    EXPECT_TRUE(rotated.verify(newToken, NOW).has_value());
+    EXPECT_FALSE(retired.verify(oldToken, NOW).has_value());
+    EXPECT_FALSE(before.verify(newToken, NOW).has_value());
+}
+
+TEST(RevocationSetTest, CurrentOnlyAfterARecentLoad) {
+    RevocationSet::Options options;
+    options.maxStaleness = 60s;
+    RevocationSet set { options };
+    EXPECT_FALSE(set.current());
+
+    auto failing = []() -> boost::asio::awaitable<std::optional<std::vector<std::string>>> { co_return std::nullopt; };
+    EXPECT_FALSE(refresh(set, failing));
+    EXPECT_FALSE(set.current());
+
+    auto loaded = []() -> boost::asio::awaitable<std::optional<std::vector<std::string>>> {
+        co_return std::vector<std::string> { "revoked-hash" };
+    };
+    EXPECT_TRUE(refresh(set, loaded));
+    EXPECT_TRUE(set.current());
+    EXPECT_FALSE(set.current(RevocationSet::Clock::now() + 61s));
+    EXPECT_TRUE(set.contains("revoked-hash"));
+    EXPECT_FALSE(set.contains("active-hash"));
+}
+
+TEST(RevocationSetTest, KeepsRevocationsMadeDuringARefresh) {
+    RevocationSet set { RevocationSet::Options {} };
+    set.revoke("before-load", RevocationSet::Clock::now() - 1s);
+
+    auto load = [&]() -> boost::asio::awaitable<std::optional<std::vector<std::string>>> {
+        set.revoke("during-load");
+        co_return std::vector<std::string> { "from-database" };
+    };
+    EXPECT_TRUE(refresh(set, load));
+
+    // A local revocation older than the load is in its result if it reached the database.
+    EXPECT_FALSE(set.contains("before-load"));
+    EXPECT_TRUE(set.contains("during-load"));
+    EXPECT_TRUE(set.contains("from-database"));
+}
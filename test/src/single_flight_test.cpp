@@ -0,0 +1,130 @@
+#include "Util/SingleFlight.hpp"
+
+#include <boost/asio/bind_cancellation_slot.hpp>
+#include <boost/asio/cancellation_signal.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <boost/asio/use_future.hpp>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace asio = boost::asio;
+
+TEST(SingleFlightTest, ConcurrentCallersShareOneExecution) {
+    asio::io_context ioc;
+    util::SingleFlight<std::string, int> flight;
+    asio::steady_timer gate { ioc, asio::steady_timer::time_point::max() };
+
+    int calls = 0;
+    auto work = [&]() -> asio::awaitable<int> {
+        ++calls;
+        boost::system::error_code ec;
+        co_await gate.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+        co_return 42;
+    };
+
+    std::vector<int> results;
+    for (int i = 0; i < 3; ++i) {
+        asio::co_spawn(ioc, flight.run("file", work), [&](std::exception_ptr, int value) { results.push_back(value); });
+    }
+
+    ioc.poll();
+    EXPECT_EQ(flight.inFlight(), 1u);
+
+    gate.cancel();
+    ioc.run();
+
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(results, (std::vector<int> { 42, 42, 42 }));
+    EXPECT_EQ(flight.inFlight(), 0u);
+}
+
+TEST(SingleFlightTest, ErrorReachesEveryWaiterAndIsNotCached) {
+    asio::io_context ioc;
+    util::SingleFlight<std::string, int> flight;
+
+    int calls = 0;
+    auto failing = [&]() -> asio::awaitable<int> {
+        ++calls;
+        throw std::runtime_error("download failed");
+        co_return 0;
+    };
+
+    int failures = 0;
+    for (int i = 0; i < 2; ++i) {
+        asio::co_spawn(ioc, flight.run("file", failing), [&](std::exception_ptr error, int) {
+            failures += error ? 1 : 0;
+        });
+    }
+    ioc.run();
+
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(failures, 2);
+
+    ioc.restart();
+    asio::co_spawn(ioc, flight.run("file", failing), [&](std::exception_ptr error, int) { failures += error ? 1 : 0; });
+    ioc.run();
+
+    EXPECT_EQ(calls, 2);
+}
+
+TEST(SingleFlightTest, CancelledWaiterDoesNotCancelTheCall) {
+    asio::io_context ioc;
+    util::SingleFlight<std::string, int> flight;
+    asio::steady_timer gate { ioc, asio::steady_timer::time_point::max() };
+
+    int calls = 0;
+    auto work = [&]() -> asio::awaitable<int> {
+        ++calls;
+        boost::system::error_code ec;
+        co_await gate.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+        co_return 7;
+    };
+
+    asio::cancellation_signal signal;
+    std::exception_ptr cancelled;
+    std::optional<int> other;
+
+    asio::co_spawn(ioc, flight.run("file", work),
+                   asio::bind_cancellation_slot(signal.slot(), [&](std::exception_ptr error, int) { cancelled = error; }));
+    asio::co_spawn(ioc, flight.run("file", work), [&](std::exception_ptr error, int value) {
+        if (!error) {
+            other = value;
+        }
+    });
+
+    ioc.poll();
+    signal.emit(asio::cancellation_type::terminal);
+    ioc.poll();
+    EXPECT_TRUE(cancelled);
+
+    gate.cancel();
+    ioc.run();
+
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(other, 7);
+}
+
+TEST(SingleFlightTest, WakesEveryWaiterOnAThreadPool) {
+    asio::thread_pool pool { 4 };
+    util::SingleFlight<int, int> flight;
+
+    // Work that finishes at once races the waiters that are still about to start waiting.
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 2000; ++i) {
+        auto work = [key = i % 8]() -> asio::awaitable<int> { co_return key; };
+        results.push_back(asio::co_spawn(pool, flight.run(i % 8, work), asio::use_future));
+    }
+
+    for (int i = 0; i < 2000; ++i) {
+        ASSERT_EQ(results[i].wait_for(std::chrono::seconds(10)), std::future_status::ready) << "waiter " << i;
+        EXPECT_EQ(results[i].get(), i % 8);
+    }
+    EXPECT_EQ(flight.inFlight(), 0u);
+}
@@ -0,0 +1,93 @@
+#include "Session/HedgedRequest.hpp"
+#include "Session/RetryPolicy.hpp"
+#include "Session/SslSession.hpp"
+
+#include <gtest/gtest.h>
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/asio/use_future.hpp>
+#include <boost/beast/core/flat_buffer.hpp>
+#include <boost/beast/http.hpp>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+
+namespace {
+
+namespace asio = boost::asio;
+namespace http = boost::beast::http;
+using tcp = asio::ip::tcp;
+
+// Throwaway self-signed certificate; the client context does not verify peers.
+asio::ssl::context serverContext() {
+    asio::ssl::context context { asio::ssl::context::tlsv12_server };
+
+    EVP_PKEY* key = EVP_EC_gen("P-256");
+    X509* cert = X509_new();
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+    X509_set_pubkey(cert, key);
+    X509_NAME_add_entry_by_txt(X509_get_subject_name(cert), "CN", MBSTRING_ASC,
+                               reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(cert, X509_get_subject_name(cert));
+    X509_sign(cert, key, EVP_sha256());
+
+    SSL_CTX_use_certificate(context.native_handle(), cert);
+    SSL_CTX_use_PrivateKey(context.native_handle(), key);
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    return context;
+}
+
+// Resets the first connection once the request has arrived and answers on the second one.
+asio::awaitable<int> resetThenAnswer(tcp::acceptor& acceptor, asio::ssl::context& context) {
+    int connections = 0;
+    while (connections < 2) {
+        asio::ssl::stream<tcp::socket> stream { co_await acceptor.async_accept(asio::use_awaitable), context };
+        ++connections;
+        co_await stream.async_handshake(asio::ssl::stream_base::server, asio::use_awaitable);
+
+        boost::beast::flat_buffer buffer;
+        http::request<http::string_body> req;
+        co_await http::async_read(stream, buffer, req, asio::use_awaitable);
+
+        if (connections == 1) {
+            stream.lowest_layer().set_option(asio::socket_base::linger(true, 0));
+            stream.lowest_layer().close();
+            continue;
+        }
+
+        http::response<http::string_body> res { http::status::ok, 11 };
+        res.body() = "answered";
+        res.prepare_payload();
+        co_await http::async_write(stream, res, asio::use_awaitable);
+    }
+    co_return connections;
+}
+
+}   // namespace
+
+TEST(SslSessionTest, RetriesOnAFreshConnectionAfterAReset) {
+    asio::io_context ioc;
+    auto context = serverContext();
+    tcp::acceptor acceptor { ioc, { asio::ip::address_v4::loopback(), 0 } };
+    const auto host = "127.0.0.1:" + std::to_string(acceptor.local_endpoint().port());
+
+    // Fill the per-host retry budget so the single retry is allowed.
+    for (int i = 0; i < 10; ++i) {
+        Network::RetryGovernor::instance().onRequest(host);
+    }
+
+    http::request<http::string_body> req { http::verb::get, "/", 11 };
+    req.set(http::field::host, host);
+
+    auto served = asio::co_spawn(ioc, resetThenAnswer(acceptor, context), asio::use_future);
+    auto response = asio::co_spawn(
+        ioc, Network::sendOnce<Network::SslSession, http::string_body>(ioc.get_executor(), req), asio::use_future);
+    ioc.run();
+
+    EXPECT_EQ(response.get().body(), "answered");
+    EXPECT_EQ(served.get(), 2);
+}
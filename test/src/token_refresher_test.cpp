@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include "Auth/TokenRefresher.hpp"
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/use_future.hpp>
+
+#include <algorithm>
+
+using Network::Auth::AccessTokenCache;
+using Network::Auth::TokenRefresher;
+
+namespace {
+
+AccessTokenCache::Options cacheOptions() {
+    AccessTokenCache::Options result;
+    result.maxUsers = 8;
+    result.maxTokenBytes = 64;
+    return result;
+}
+
+TokenRefresher::Options refresherOptions() {
+    TokenRefresher::Options result;
+    result.refreshAhead = std::chrono::seconds(900);
+    result.activeWindow = std::chrono::seconds(1800);
+    result.jitter = std::chrono::milliseconds(0);
+    result.concurrency = 2;
+    return result;
+}
+
+}   // namespace
+
+TEST(TokenRefresherTest, PicksActiveUsersWhoseTokensExpireSoon) {
+    boost::asio::io_context ioc;
+    AccessTokenCache cache { cacheOptions() };
+    TokenRefresher refresher { ioc.get_executor(), [](std::string) -> boost::asio::awaitable<bool> { co_return true; },
+                               cache, refresherOptions() };
+    auto now = TokenRefresher::Clock::now();
+
+    cache.store("fresh", "a", now + std::chrono::seconds(3600), now);
+    cache.store("expiring", "b", now + std::chrono::seconds(600), now);
+    refresher.touch("fresh", now);
+    refresher.touch("expiring", now);
+    refresher.touch("uncached", now);
+    refresher.touch("idle", now - std::chrono::seconds(3600));
+
+    auto due = refresher.due(now);
+    std::ranges::sort(due);
+    EXPECT_EQ(due, (std::vector<std::string> { "expiring", "uncached" }));
+
+    refresher.touch("idle", now);
+    due = refresher.due(now + std::chrono::seconds(1801));
+    EXPECT_TRUE(due.empty());
+}
+
+TEST(TokenRefresherTest, RefreshesEveryDueUserWithBoundedConcurrency) {
+    boost::asio::io_context ioc;
+    AccessTokenCache cache { cacheOptions() };
+
+    std::vector<std::string> refreshed;
+    int running = 0;
+    int peak = 0;
+    TokenRefresher refresher {
+        ioc.get_executor(),
+        [&](std::string userId) -> boost::asio::awaitable<bool> {
+            peak = std::max(peak, ++running);
+            boost::asio::steady_timer timer { co_await boost::asio::this_coro::executor, std::chrono::milliseconds(5) };
+            co_await timer.async_wait(boost::asio::use_awaitable);
+            --running;
+            refreshed.push_back(std::move(userId));
+            co_return true;
+        },
+        cache, refresherOptions()
+    };
+
+    for (auto user : { "u1", "u2", "u3", "u4", "u5" }) {
+        refresher.touch(user);
+    }
+
+    auto done = boost::asio::co_spawn(ioc, refresher.refreshDue(), boost::asio::use_future);
+    ioc.run();
+    done.get();
+
+    EXPECT_EQ(refreshed.size(), 5u);
+    EXPECT_EQ(peak, 2);
+}
+
+TEST(TokenRefresherTest, BacksOffUsersWhoseRefreshFails) {
+    boost::asio::io_context ioc;
+    AccessTokenCache cache { cacheOptions() };
+
+    std::vector<std::string> attempts;
+    TokenRefresher refresher {
+        ioc.get_executor(),
+        [&](std::string userId) -> boost::asio::awaitable<bool> {
+            attempts.push_back(userId);
+            if (userId == "no-tokens") {
+                co_return false;
+            }
+            cache.store(userId, "token", TokenRefresher::Clock::now() + std::chrono::seconds(3600));
+            co_return true;
+        },
+        cache, refresherOptions()
+    };
+
+    auto now = TokenRefresher::Clock::now();
+    refresher.touch("no-tokens", now);
+    refresher.touch("refreshed", now);
+
+    auto done = boost::asio::co_spawn(ioc, refresher.refreshDue(), boost::asio::use_future);
+    ioc.run();
+    done.get();
+    std::ranges::sort(attempts);
+    EXPECT_EQ(attempts, (std::vector<std::string> { "no-tokens", "refreshed" }));
+
+    // Skipped for the next round and due again after two intervals; the refreshed user is not due.
+    EXPECT_TRUE(refresher.due(now + std::chrono::seconds(60)).empty());
+    EXPECT_EQ(refresher.due(now + std::chrono::seconds(121)), (std::vector<std::string> { "no-tokens" }));
+}
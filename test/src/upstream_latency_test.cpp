@@ -0,0 +1,93 @@
+#include "Session/HedgedRequest.hpp"
+#include "Session/UpstreamLatency.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+using namespace std::chrono_literals;
+
+TEST(LatencyHistogramTest, NoQuantileWithoutEnoughSamples) {
+    Network::LatencyHistogram histogram;
+    histogram.record(5ms);
+
+    EXPECT_EQ(histogram.count(), 1);
+    EXPECT_FALSE(histogram.quantile(0.95).has_value());
+}
+
+TEST(LatencyHistogramTest, QuantileFollowsDistribution) {
+    Network::LatencyHistogram histogram;
+
+    for (int i = 0; i < 95; ++i) {
+        histogram.record(10ms);
+    }
+    for (int i = 0; i < 5; ++i) {
+        histogram.record(2s);
+    }
+
+    auto p50 = histogram.quantile(0.5);
+    auto p99 = histogram.quantile(0.99);
+    ASSERT_TRUE(p50.has_value());
+    ASSERT_TRUE(p99.has_value());
+
+    EXPECT_GE(*p50, 10ms);
+    EXPECT_LT(*p50, 13ms);
+    EXPECT_GE(*p99, 2s);
+    EXPECT_LT(*p99, 2600ms);
+}
+
+TEST(LatencyHistogramTest, BucketsAreMonotonic) {
+    for (std::size_t i = 1; i < Network::LatencyHistogram::bucketCount; ++i) {
+        EXPECT_GT(Network::LatencyHistogram::bucketUpperBound(i), Network::LatencyHistogram::bucketUpperBound(i - 1));
+    }
+}
+
+TEST(UpstreamLatencyTest, UpstreamKeyAddsDefaultPort) {
+    EXPECT_EQ(Network::upstreamKey("www.googleapis.com", "443"), "www.googleapis.com:443");
+    EXPECT_EQ(Network::upstreamKey("localhost:8000", "80"), "localhost:8000");
+}
+
+TEST(HedgeBudgetTest, HedgesLimitedToShareOfRequests) {
+    Network::HedgeBudget budget(true, 0.25, 2.0);
+
+    EXPECT_FALSE(budget.tryAcquire());
+
+    for (int i = 0; i < 4; ++i) {
+        budget.onRequest();
+    }
+    EXPECT_TRUE(budget.tryAcquire());
+    EXPECT_FALSE(budget.tryAcquire());
+
+    for (int i = 0; i < 100; ++i) {
+        budget.onRequest();
+    }
+    EXPECT_TRUE(budget.tryAcquire());
+    EXPECT_TRUE(budget.tryAcquire());
+    EXPECT_FALSE(budget.tryAcquire());
+}
+
+TEST(UpstreamLatencyTest, RequestClassDropsIdsAndQuery) {
+    EXPECT_EQ(Network::requestClass("GET", "/drive/v3/files/1Bx00000001fileId?alt=media"), "GET /drive/v3/files");
+    EXPECT_EQ(Network::requestClass("GET", "/rest/v1/documents?select=*"), "GET /rest/v1/documents");
+    EXPECT_EQ(Network::requestClass("POST", "/token"), "POST /token");
+}
+
+TEST(HedgeBudgetTest, HedgeDelayIncludesConnectTime) {
+    auto& latency = Network::UpstreamLatency::instance();
+    const auto upstream = "hedge-delay.test:443";
+
+    for (int i = 0; i < 100; ++i) {
+        latency.request(upstream, "GET /v1/courses").record(10ms);
+    }
+    EXPECT_FALSE(Network::hedgeDelay(upstream, "GET /v1/courses").has_value());
+
+    for (int i = 0; i < 100; ++i) {
+        latency.connect(upstream).record(100ms);
+        latency.request(upstream, "GET /drive/v3/files").record(2s);
+    }
+
+    auto delay = Network::hedgeDelay(upstream, "GET /v1/courses");
+    ASSERT_TRUE(delay.has_value());
+    EXPECT_GE(*delay, 110ms);
+    EXPECT_LT(*delay, 150ms);
+}
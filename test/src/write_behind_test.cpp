@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include "Session/WriteBehind.hpp"
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/use_future.hpp>
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+class WriteBehindTest : public testing::Test {
+protected:
+    void SetUp() override {
+        options.journalPath = (std::filesystem::temp_directory_path()
+                               / ("write_behind_test_" + std::to_string(::getpid()) + ".journal")).string();
+        std::filesystem::remove(options.journalPath);
+    }
+
+    void TearDown() override { std::filesystem::remove(options.journalPath); }
+
+    void flush(Network::WriteBehind& writeBehind) {
+        auto done = boost::asio::co_spawn(ioc, writeBehind.flush(), boost::asio::use_future);
+        ioc.restart();
+        ioc.run();
+        done.get();
+    }
+
+    boost::asio::io_context ioc;
+    Network::WriteBehind::Options options;
+};
+
+}   // namespace
+
+TEST_F(WriteBehindTest, CoalescesUpdatesToTheSameKey) {
+    Network::WriteBehind writeBehind { ioc.get_executor(), options };
+
+    std::vector<Network::WriteBehind::Entry> flushed;
+    writeBehind.registerKind("last_seen", [&](std::vector<Network::WriteBehind::Entry> batch) -> boost::asio::awaitable<bool> {
+        flushed = std::move(batch);
+        co_return true;
+    });
+
+    writeBehind.enqueue("last_seen", "session-a", "10:00");
+    writeBehind.enqueue("last_seen", "session-a", "10:01");
+    writeBehind.enqueue("last_seen", "session-b", "10:02");
+    EXPECT_EQ(writeBehind.pending(), 2u);
+
+    flush(writeBehind);
+
+    ASSERT_EQ(flushed.size(), 2u);
+    EXPECT_EQ(flushed[0].key, "session-a");
+    EXPECT_EQ(flushed[0].value, "10:01");
+    EXPECT_EQ(writeBehind.pending(), 0u);
+    EXPECT_EQ(std::filesystem::file_size(options.journalPath), 0u);
+}
+
+TEST_F(WriteBehindTest, FailedFlushKeepsTheBatch) {
+    Network::WriteBehind writeBehind { ioc.get_executor(), options };
+
+    int attempts = 0;
+    writeBehind.registerKind("last_seen", [&](std::vector<Network::WriteBehind::Entry>) -> boost::asio::awaitable<bool> {
+        co_return ++attempts > 1;
+    });
+
+    writeBehind.enqueue("last_seen", "session-a", "10:00");
+    flush(writeBehind);
+    EXPECT_EQ(writeBehind.pending(), 1u);
+
+    flush(writeBehind);
+    EXPECT_EQ(attempts, 2);
+    EXPECT_EQ(writeBehind.pending(), 0u);
+}
+
+TEST_F(WriteBehindTest, FailedFlushStillCompactsTheJournal) {
+    Network::WriteBehind writeBehind { ioc.get_executor(), options };
+    writeBehind.registerKind("last_seen", [](std::vector<Network::WriteBehind::Entry>) -> boost::asio::awaitable<bool> {
+        co_return false;
+    });
+
+    writeBehind.enqueue("last_seen", "session-a", "10:00");
+    writeBehind.enqueue("last_seen", "session-a", "10:01");
+    writeBehind.enqueue("last_seen", "session-a", "10:02");
+    flush(writeBehind);
+
+    std::ifstream journal { options.journalPath };
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(journal, line);) {
+        lines.push_back(line);
+    }
+    EXPECT_EQ(lines, (std::vector<std::string> { "last_seen\tsession-a\t10:02" }));
+    EXPECT_EQ(writeBehind.pending(), 1u);
+}
+
+TEST_F(WriteBehindTest, ReplaysTheJournalAfterACrash) {
+    {
+        Network::WriteBehind writeBehind { ioc.get_executor(), options };
+        writeBehind.enqueue("last_seen", "session-a", "10:00");
+        writeBehind.enqueue("last_seen", "session-b\twith\\odd\nkey", "10:01");
+        writeBehind.enqueue("last_seen", "session-a", "10:02");
+    }
+
+    Network::WriteBehind restarted { ioc.get_executor(), options };
+    EXPECT_EQ(restarted.pending(), 2u);
+
+    std::vector<Network::WriteBehind::Entry> flushed;
+    restarted.registerKind("last_seen", [&](std::vector<Network::WriteBehind::Entry> batch) -> boost::asio::awaitable<bool> {
+        flushed = std::move(batch);
+        co_return true;
+    });
+    flush(restarted);
+
+    ASSERT_EQ(flushed.size(), 2u);
+    EXPECT_EQ(flushed[0].key, "session-a");
+    EXPECT_EQ(flushed[0].value, "10:02");
+    EXPECT_EQ(flushed[1].key, "session-b\twith\\odd\nkey");
+}